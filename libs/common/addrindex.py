@@ -0,0 +1,136 @@
+"""
+Reverse address lookup: finds derivation index of an address
+that belongs to a wildcard descriptor.
+
+    from addrindex import AddressIndex
+    index = AddressIndex(desc, "/flash/wallets/mywallet.idx")
+    res = index.find("bc1q...")  # (idx, branch_index) or None
+
+Scripts are derived in batches and compared as raw bytes,
+addresses are never encoded.
+With a path the first bytes of every derived hash160 / witness program
+are stored in a file per branch, so the next lookups only derive
+the candidate to confirm the match.
+Index is rebuilt if the descriptor changes.
+"""
+from embit import hashes, script
+
+MAGIC = b"AIDX"
+# bytes of the program stored per index
+PREFIX_LEN = 4
+# number of indexes derived per branch before switching to the next one
+BATCH = 20
+# default number of indexes to check per branch
+LIMIT = 1000
+
+
+def program(sc):
+    """hash160 or witness program of the scriptpubkey"""
+    data = sc.data
+    # OP_DUP OP_HASH160 <20:hash160(pubkey)> ...
+    if data[0] == 0x76:
+        return data[3:23]
+    # OP_HASH160 <20:hash160(script)> OP_EQUAL or OP_n <program>
+    if data[0] == 0xA9:
+        return data[2:22]
+    return data[2:]
+
+
+class AddressIndex:
+    def __init__(self, descriptor, path=None):
+        if not descriptor.is_wildcard:
+            raise ValueError("Descriptor has no wildcard")
+        self.descriptor = descriptor
+        self.path = path
+        # header of index files, changes with the descriptor
+        self.header = MAGIC + hashes.sha256(str(descriptor).encode())[:8]
+        # prefixes of derived programs per branch, loaded on first use
+        self._prefixes = [None] * descriptor.num_branches
+
+    def derive_script(self, idx, branch_index):
+        return self.descriptor.derive(idx, branch_index=branch_index).script_pubkey()
+
+    def _fname(self, branch_index):
+        return "%s.%d" % (self.path, branch_index)
+
+    def prefixes(self, branch_index):
+        """Stored prefixes of the branch, PREFIX_LEN bytes per index"""
+        data = self._prefixes[branch_index]
+        if data is not None:
+            return data
+        data = b""
+        if self.path is not None:
+            fname = self._fname(branch_index)
+            stored = None
+            try:
+                with open(fname, "rb") as f:
+                    if f.read(len(self.header)) == self.header:
+                        stored = f.read()
+            except OSError:
+                pass
+            # new file, other descriptor or incomplete record after interrupted write
+            if stored is None or len(stored) % PREFIX_LEN:
+                if stored:
+                    data = stored[: len(stored) - len(stored) % PREFIX_LEN]
+                with open(fname, "wb") as f:
+                    f.write(self.header)
+                    f.write(data)
+            else:
+                data = stored
+        self._prefixes[branch_index] = data
+        return data
+
+    def _lookup(self, sc, branch_index):
+        """Checks known indexes, only candidates are derived"""
+        data = self.prefixes(branch_index)
+        prefix = program(sc)[:PREFIX_LEN]
+        pos = data.find(prefix)
+        while pos >= 0:
+            # wpkh and pkh of the same key share the hash,
+            # so candidates are compared as full scripts
+            if pos % PREFIX_LEN == 0:
+                idx = pos // PREFIX_LEN
+                if self.derive_script(idx, branch_index) == sc:
+                    return idx
+            pos = data.find(prefix, pos + 1)
+        return None
+
+    def _extend(self, sc, branch_index, limit):
+        """Derives up to BATCH new indexes, returns index of sc if found"""
+        data = self.prefixes(branch_index)
+        start = len(data) // PREFIX_LEN
+        res = None
+        batch = b""
+        for idx in range(start, min(start + BATCH, limit)):
+            derived = self.derive_script(idx, branch_index)
+            batch += program(derived)[:PREFIX_LEN]
+            if derived == sc:
+                res = idx
+                break
+        if self.path is not None and batch:
+            with open(self._fname(branch_index), "ab") as f:
+                f.write(batch)
+        self._prefixes[branch_index] = data + batch
+        return res
+
+    def find(self, addr, limit=LIMIT):
+        """
+        Returns (idx, branch_index) of the address or scriptpubkey,
+        None if it's not in the first `limit` indexes of any branch.
+        """
+        sc = addr if isinstance(addr, script.Script) else script.Script.from_address(addr)
+        branches = range(len(self._prefixes))
+        for b in branches:
+            idx = self._lookup(sc, b)
+            if idx is not None:
+                return idx, b
+        # derive branches in turns, so change and receive addresses
+        # with small indexes are found first
+        pending = [b for b in branches if len(self.prefixes(b)) < limit * PREFIX_LEN]
+        while pending:
+            for b in pending:
+                idx = self._extend(sc, b, limit)
+                if idx is not None:
+                    return idx, b
+            pending = [b for b in pending if len(self.prefixes(b)) < limit * PREFIX_LEN]
+        return None
@@ -14,6 +14,8 @@ _attrs = {
     "start_server": "stream",
     "StreamReader": "stream",
     "StreamWriter": "stream",
+    "HostStream": "stream",
+    "open_host": "stream",
 }
 
 # Lazy loader, effectively does:
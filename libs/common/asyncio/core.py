@@ -169,7 +169,16 @@ def run_until_complete(main_task=None):
                 # No tasks can be woken so finished running
                 return
             # print('(poll {})'.format(dt), len(_io_queue.map))
-            _io_queue.wait_io_event(dt)
+            if dt and _idle is not None:
+                # Tickless idle: check IO without waiting, then let the MCU
+                # sleep until the next task is due or an interrupt fires
+                _io_queue.wait_io_event(0)
+                if _task_queue.peek() is t:
+                    _idle(dt)
+                    # recalculate, the sleep could end early
+                    dt = 1
+            else:
+                _io_queue.wait_io_event(dt)
 
         # Get next task to run and continue it
         t = _task_queue.pop_head()
@@ -208,6 +217,14 @@ def run_until_complete(main_task=None):
             t.coro = None
 
 
+# Set function called with time in ms (-1 if no timers) when no task is runnable.
+# It should sleep until then or until an interrupt, i.e. tickless.sleep_ms.
+# None restores the default: blocking poll of IO with a timeout.
+def set_idle_hook(fn):
+    global _idle
+    _idle = fn
+
+
 # Create a new task from a coroutine and run it until it finishes
 def run(coro):
     return run_until_complete(create_task(coro))
@@ -222,6 +239,7 @@ async def _stopper():
 
 
 _stop_task = None
+_idle = None
 
 
 class Loop:
@@ -58,6 +58,146 @@ StreamReader = Stream
 StreamWriter = Stream
 
 
+# Stream over a host connection: pyb.USB_VCP, pyb.UART (TCPHost on unix).
+# Device must be non-blocking (UART with timeout=0). Data is pulled from the
+# device only when the consumer asks for it, through fixed buffers, so a slow
+# consumer throttles the sender with USB NAKs or UART RTS/CTS flow control
+# instead of growing the heap.
+# drain() returns when at most txlow bytes are still pending,
+# so small writes can be batched, flush() sends everything.
+class HostStream(Stream):
+    def __init__(self, dev, rxbuf=512, txbuf=512, txlow=0):
+        super().__init__(dev)
+        self.rxbuf = bytearray(rxbuf)
+        self.txbuf = bytearray(txbuf)
+        self.txlow = txlow
+
+    def _readinto(self, mv):
+        # None means no data
+        return self.s.readinto(mv) or 0
+
+    # Device may have buffered data that doesn't wake the poller
+    # (TCPHost on unix), so always try to read before waiting
+    async def readinto(self, buf):
+        mv = memoryview(buf)
+        while True:
+            n = self._readinto(mv)
+            if n:
+                return n
+            yield core._io_queue.queue_read(self.s)
+
+    async def read(self, n=-1):
+        mv = memoryview(self.rxbuf)
+        if 0 <= n < len(mv):
+            mv = mv[:n]
+        n = await self.readinto(mv)
+        return bytes(mv[:n])
+
+    async def readexactly(self, n):
+        buf = bytearray(n)
+        mv = memoryview(buf)
+        off = 0
+        while off < n:
+            off += await self.readinto(mv[off:])
+        return bytes(buf)
+
+    async def readline(self, maxlen=1024):
+        """
+        Returns a line including b"\\n", raises ValueError if there is
+        no newline in maxlen bytes. Bytes are read one by one,
+        so data after the newline stays in the device.
+        """
+        line = bytearray()
+        b = bytearray(1)
+        while len(line) < maxlen:
+            await self.readinto(b)
+            line += b
+            if b[0] == 10:
+                return bytes(line)
+        raise ValueError("Line is too long")
+
+    async def _send(self, low):
+        # write at most len(txbuf) at once, device write may block otherwise
+        mv = memoryview(self.out_buf)
+        step = len(self.txbuf)
+        off = 0
+        while len(mv) - off > low:
+            yield core._io_queue.queue_write(self.s)
+            ret = self.s.write(mv[off : off + step])
+            if ret:
+                off += ret
+        self.out_buf = bytes(mv[off:]) if off < len(mv) else b""
+
+    async def drain(self):
+        await self._send(self.txlow)
+
+    async def flush(self):
+        await self._send(0)
+
+    async def copy_to(self, out, nbytes, progress=None):
+        """
+        Streams nbytes from the device into a file-like object with write()
+        or directly into a writable buffer (i.e. memoryview from sdram.alloc()).
+        Other tasks run after every chunk, progress(done) is called if set.
+        Returns number of bytes copied.
+        """
+        dst = None
+        if hasattr(out, "write"):
+            mv = memoryview(self.rxbuf)
+        else:
+            dst = memoryview(out)
+            if nbytes > len(dst):
+                raise ValueError("Buffer is too small")
+        chunk = len(self.rxbuf)
+        done = 0
+        while done < nbytes:
+            n = min(chunk, nbytes - done)
+            if dst is None:
+                n = await self.readinto(mv[:n])
+                out.write(mv[:n])
+            else:
+                n = await self.readinto(dst[done : done + n])
+            done += n
+            if progress is not None:
+                progress(done)
+            await core.sleep_ms(0)
+        return done
+
+    async def copy_from(self, src, nbytes=-1, progress=None):
+        """
+        Streams data from a file-like object to the device
+        through txbuf, waiting until the device can accept more.
+        Data pending from write() is sent first.
+        Returns number of bytes sent.
+        """
+        await self.flush()
+        mv = memoryview(self.txbuf)
+        done = 0
+        while nbytes < 0 or done < nbytes:
+            n = len(mv) if nbytes < 0 else min(len(mv), nbytes - done)
+            n = src.readinto(mv[:n])
+            if not n:
+                break
+            off = 0
+            while off < n:
+                yield core._io_queue.queue_write(self.s)
+                ret = self.s.write(mv[off:n])
+                if ret:
+                    off += ret
+            done += n
+            if progress is not None:
+                progress(done)
+            await core.sleep_ms(0)
+        return done
+
+
+# Wrap a host connection device into an asyncio stream,
+# returns (reader, writer) pair like open_connection()
+def open_host(dev, rxbuf=512, txbuf=512, txlow=0):
+    s = HostStream(dev, rxbuf, txbuf, txlow)
+    return s, s
+
+
 # Create a TCP stream connection to a remote host
 async def open_connection(host, port):
     from uerrno import EINPROGRESS
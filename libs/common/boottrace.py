@@ -0,0 +1,124 @@
+"""
+Boot-time tracing.
+
+Records how long imports and init phases take into a fixed-size
+ring buffer, so it can stay enabled on the device without growing the heap.
+Start it as early as possible in boot.py / main.py:
+
+    import boottrace
+    boottrace.start()
+    ...
+    boottrace.mark("gui ready")
+    boottrace.report()
+
+Every record is (name, start, duration) in microseconds
+relative to start().
+"""
+import time
+import builtins
+
+SIZE = 64
+
+_names = [None] * SIZE
+_starts = [0] * SIZE
+_durations = [0] * SIZE
+# total number of records, position in the ring is _count % SIZE
+_count = 0
+_t0 = 0
+_import = None
+# nesting level of imports
+_depth = 0
+
+
+def now():
+    """Microseconds since start()"""
+    return time.ticks_diff(time.ticks_us(), _t0)
+
+
+def active():
+    return _import is not None
+
+
+def record(name, start, duration=0):
+    global _count
+    i = _count % SIZE
+    _names[i] = name
+    _starts[i] = start
+    _durations[i] = duration
+    _count += 1
+
+
+def mark(name):
+    """Records a point in time, no-op if tracing is not started"""
+    if active():
+        record(name, now())
+
+
+class phase:
+    """Context manager recording duration of a block"""
+
+    def __init__(self, name):
+        self.name = name
+
+    def __enter__(self):
+        self.t = now()
+        return self
+
+    def __exit__(self, *args):
+        if active():
+            record(self.name, self.t, now() - self.t)
+
+
+def _traced_import(name, *args):
+    global _depth
+    t = now()
+    _depth += 1
+    try:
+        return _import(name, *args)
+    finally:
+        _depth -= 1
+        # modules already in sys.modules return in a few us, skip them
+        dt = now() - t
+        if dt > 50:
+            # relative "from . import x" has empty name
+            if not name and len(args) > 2 and args[2]:
+                name = "." + ",".join(args[2])
+            # nested imports are indented and recorded before the parent
+            record("  " * _depth + "import " + name, t, dt)
+
+
+def start():
+    """Resets the buffer and starts tracing imports"""
+    global _count, _t0, _import
+    _count = 0
+    _t0 = time.ticks_us()
+    if _import is None:
+        _import = builtins.__import__
+        builtins.__import__ = _traced_import
+
+
+def stop():
+    """Stops tracing imports, keeps recorded data"""
+    global _import
+    if _import is not None:
+        builtins.__import__ = _import
+        _import = None
+
+
+def records():
+    """Returns list of (name, start, duration), oldest first"""
+    first = max(0, _count - SIZE)
+    return [
+        (_names[i % SIZE], _starts[i % SIZE], _durations[i % SIZE])
+        for i in range(first, _count)
+    ]
+
+
+def report(file=None):
+    """Prints recorded events, returns time of the last one"""
+    res = records()
+    for name, t, dt in res:
+        print("%10d us %10d us  %s" % (t, dt, name), file=file)
+    if _count > SIZE:
+        print("%d older records dropped" % (_count - SIZE), file=file)
+    return (res[-1][1] + res[-1][2]) if res else 0
@@ -9,6 +9,58 @@ class EmbitError(Exception):
     pass
 
 
+class LenStream:
+    """Writable stream that only counts bytes, see serialized_len()"""
+
+    def write(self, b) -> int:
+        return len(b)
+
+
+class BufStream:
+    """Writable stream over a preallocated buffer, see serialize_into()"""
+
+    def __init__(self, buf, offset=0):
+        self.buf = memoryview(buf)
+        self.pos = offset
+
+    def write(self, b) -> int:
+        l = len(b)
+        self.buf[self.pos : self.pos + l] = b
+        self.pos += l
+        return l
+
+
+class SerializeBuffer:
+    """
+    Reusable buffer for many small serializations,
+    i.e. inputs and outputs going into a hash:
+
+        buf = SerializeBuffer()
+        for out in vout:
+            h.update(buf.serialize(out))
+    """
+
+    def __init__(self, size=64):
+        self.buf = bytearray(size)
+        self.pos = 0
+
+    def write(self, b) -> int:
+        l = len(b)
+        end = self.pos + l
+        if end > len(self.buf):
+            # new buffer, views returned before stay valid
+            self.buf = self.buf[: self.pos] + bytearray(max(end, 2 * len(self.buf)) - self.pos)
+        self.buf[self.pos : end] = b
+        self.pos = end
+        return l
+
+    def serialize(self, obj, *args, **kwargs):
+        """Returns memoryview valid until the next call"""
+        self.pos = 0
+        obj.write_to(self, *args, **kwargs)
+        return memoryview(self.buf)[: self.pos]
+
+
 class EmbitBase:
     @classmethod
     def read_from(cls, stream, *args, **kwargs):
@@ -38,6 +90,17 @@ class EmbitBase:
         self.write_to(stream, *args, **kwargs)
         return stream.getvalue()
 
+    def serialized_len(self, *args, **kwargs) -> int:
+        """
+        Length of serialize() result.
+        Override if it's known without writing the data.
+        """
+        return self.write_to(LenStream(), *args, **kwargs)
+
+    def serialize_into(self, buf, offset=0, *args, **kwargs) -> int:
+        """Writes serialization into preallocated buffer, returns number of bytes"""
+        return self.write_to(BufStream(buf, offset), *args, **kwargs)
+
     def to_string(self, *args, **kwargs) -> str:
         """
         String representation.
@@ -91,6 +91,9 @@ class HDKey(EmbitKey):
         res += stream.write(self.key.serialize())
         return res
 
+    def serialized_len(self, version=None) -> int:
+        return 78
+
     def to_base58(self, version=None) -> str:
         b = self.serialize(version)
         res = base58.encode_check(b)
@@ -2,7 +2,16 @@
 import hashlib
 from .misc import const
 
-from .wordlists.bip39 import WORDLIST
+from .wordlists.base import LazyWordlist
+
+
+def _load_wordlist():
+    from .wordlists.bip39 import WORDLIST
+
+    return WORDLIST
+
+
+WORDLIST = LazyWordlist(_load_wordlist)
 
 PBKDF2_ROUNDS = const(2048)
 
@@ -18,6 +18,17 @@ def to_bytes(i: int) -> bytes:
     return bytes([0xFC + order]) + i.to_bytes(2**order, "little")
 
 
+def size(i: int) -> int:
+    """length of compact int encoding of i"""
+    if i < 0xFD:
+        return 1
+    if i <= 0xFFFF:
+        return 3
+    if i <= 0xFFFFFFFF:
+        return 5
+    return 9
+
+
 def from_bytes(b: bytes) -> int:
     s = io.BytesIO(b)
     res = read_from(s)
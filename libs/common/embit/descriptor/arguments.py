@@ -81,8 +81,10 @@ class AllowedDerivation(DescriptorBase):
                 if der not in el:
                     return None
                 branch_idx = el.index(der)
-            # wildcard
+            # wildcard, fill() doesn't allow hardened indexes
             elif el is None:
+                if der >= HARDENED_INDEX:
+                    return None
                 idx = der
             # shouldn't happen
             else:
@@ -179,6 +181,9 @@ class AllowedDerivation(DescriptorBase):
 
 
 class Key(DescriptorBase):
+    # branch keys kept by derive(), <0;1>/* needs two
+    MAX_PARENTS = 4
+
     def __init__(
         self,
         key,
@@ -194,6 +199,8 @@ class Key(DescriptorBase):
         if not hasattr(key, "derive") and derivation:
             raise ArgumentError("Key %s doesn't support derivation" % key)
         self.allowed_derivation = derivation
+        # branch path -> derived public key, see derive()
+        self._parents = {}
 
     def __len__(self):
         return 34 - int(self.taproot)  # <33:sec> or <32:xonly>
@@ -366,11 +373,29 @@ class Key(DescriptorBase):
         if self.allowed_derivation is None:
             return self
         der = self.allowed_derivation.fill(idx, branch_index=branch_index)
-        k = self.key.derive(der)
+        # for xpub/<0;1>/* keep derived branch keys,
+        # so every next index costs one child derivation.
+        # Private keys are not kept in memory longer than needed.
+        if (
+            len(der) > 1
+            and self.allowed_derivation.indexes[-1] is None
+            and not self.is_private
+        ):
+            branch = tuple(der[:-1])
+            parent = self._parents.get(branch)
+            if parent is None:
+                parent = self.key.derive(der[:-1])
+                if len(self._parents) >= self.MAX_PARENTS:
+                    self._parents.clear()
+                self._parents[branch] = parent
+            k = parent.child(der[-1])
+        else:
+            k = self.key.derive(der)
         if self.origin:
             origin = KeyOrigin(self.origin.fingerprint, self.origin.derivation + der)
         else:
-            origin = KeyOrigin(self.key.child(0).fingerprint, der)
+            # derivation starts at this key
+            origin = KeyOrigin(self.key.my_fingerprint, der)
         # empty derivation
         derivation = None
         return type(self)(k, origin, derivation, self.taproot)
@@ -498,7 +523,7 @@ class Raw(DescriptorBase):
         return compact.to_bytes(len(self.raw)) + self.raw
 
     def __len__(self):
-        return len(compact.to_bytes(self.LEN)) + self.LEN
+        return compact.size(self.LEN) + self.LEN
 
 
 class Raw32(Raw):
@@ -8,6 +8,10 @@ from .arguments import Key
 from .taptree import TapTree
 
 
+# script_pubkey lengths for quick rejects in Descriptor.owns()
+SCRIPT_LENGTHS = {"p2pkh": 25, "p2sh": 23, "p2wpkh": 22, "p2wsh": 34, "p2tr": 34}
+
+
 class Descriptor(DescriptorBase):
     def __init__(
         self,
@@ -48,6 +52,8 @@ class Descriptor(DescriptorBase):
         # make sure all keys are either taproot or not
         for k in self.keys:
             k.taproot = taproot
+        # (fingerprint, path prefix) -> keys, see check_derivation()
+        self.key_index, self._der_lens = self._index_keys()
 
     @property
     def script_len(self):
@@ -200,44 +206,65 @@ class Descriptor(DescriptorBase):
                 self.taptree.to_public(),
             )
 
+    def _index_keys(self):
+        """
+        Maps fingerprint and derivation prefix of key origins and of the
+        xpubs themselves to keys that derive from there, so derivation
+        paths from PSBT are checked only against keys that can match.
+        Also returns lengths of derivations that can follow a prefix.
+        """
+        index = {}
+        lens = []
+        for k in self.keys:
+            if k.allowed_derivation is None:
+                continue
+            l = len(k.allowed_derivation.indexes)
+            if l not in lens:
+                lens.append(l)
+            prefixes = [(k.my_fingerprint, ())]
+            if k.origin is not None:
+                prefixes.append((k.fingerprint, tuple(k.derivation)))
+            for prefix in prefixes:
+                keys = index.setdefault(prefix, [])
+                if k not in keys:
+                    keys.append(k)
+        return index, lens
+
     def owns(self, psbt_scope):
         """Checks if psbt input or output belongs to this descriptor"""
+        sc = psbt_scope.script_pubkey
         # we can't check if we don't know script_pubkey
-        if psbt_scope.script_pubkey is None:
+        if sc is None:
+            return False
+        # quick check of script_pubkey length and type
+        sc_type = self.scriptpubkey_type()
+        l = SCRIPT_LENGTHS.get(sc_type)
+        if l is not None and len(sc.data) != l:
             return False
-        # quick check of script_pubkey type
-        if psbt_scope.script_pubkey.script_type() != self.scriptpubkey_type():
+        if sc.script_type() != sc_type:
             return False
-        for pub, der in psbt_scope.bip32_derivations.items():
-            # check of the fingerprints
-            for k in self.keys:
-                if not k.is_extended:
-                    continue
-                res = k.check_derivation(der)
-                if res:
-                    idx, branch_idx = res
-                    sc = self.derive(idx, branch_index=branch_idx).script_pubkey()
-                    # if derivation is found but scriptpubkey doesn't match - fail
-                    return sc == psbt_scope.script_pubkey
-        for pub, (leafs, der) in psbt_scope.taproot_bip32_derivations.items():
-            # check of the fingerprints
-            for k in self.keys:
-                if not k.is_extended:
-                    continue
-                res = k.check_derivation(der)
-                if res:
-                    idx, branch_idx = res
-                    sc = self.derive(idx, branch_index=branch_idx).script_pubkey()
-                    # if derivation is found but scriptpubkey doesn't match - fail
-                    return sc == psbt_scope.script_pubkey
+        ders = list(psbt_scope.bip32_derivations.values())
+        ders += [der for _, der in psbt_scope.taproot_bip32_derivations.values()]
+        for der in ders:
+            res = self.check_derivation(der)
+            if res:
+                idx, branch_idx = res
+                # if derivation is found but scriptpubkey doesn't match - fail
+                return self.derive(idx, branch_index=branch_idx).script_pubkey() == sc
         return False
 
     def check_derivation(self, derivation_path):
-        for k in self.keys:
-            # returns a tuple branch_idx, idx
-            der = k.check_derivation(derivation_path)
-            if der is not None:
-                return der
+        fgp = derivation_path.fingerprint
+        path = derivation_path.derivation
+        for l in self._der_lens:
+            if l > len(path):
+                continue
+            n = len(path) - l
+            for k in self.key_index.get((fgp, tuple(path[:n])), []):
+                # returns a tuple idx, branch_idx
+                der = k.allowed_derivation.check_derivation(path[n:])
+                if der is not None:
+                    return der
         return None
 
     def witness_script(self):
@@ -8,11 +8,22 @@ class Miniscript(DescriptorBase):
     def __init__(self, *args, **kwargs):
         self.args = args
         self.taproot = kwargs.get("taproot", False)
+        # type, properties, length and validity depend only on the structure,
+        # they are computed on first use and kept by derive / branch / to_public
+        self._type = None
+        self._props = None
+        self._len = None
+        self._verified = False
 
     def compile(self):
         return self.inner_compile()
 
     def verify(self):
+        if not self._verified:
+            self.inner_verify()
+            self._verified = True
+
+    def inner_verify(self):
         for arg in self.args:
             if isinstance(arg, Miniscript):
                 arg.verify()
@@ -29,27 +40,46 @@ class Miniscript(DescriptorBase):
             arg.derive(idx, branch_index) if hasattr(arg, "derive") else arg
             for arg in self.args
         ]
-        return type(self)(*args, taproot=self.taproot)
+        return self._clone(args)
 
     def to_public(self):
         args = [
             arg.to_public() if hasattr(arg, "to_public") else arg for arg in self.args
         ]
-        return type(self)(*args, taproot=self.taproot)
+        return self._clone(args)
 
     def branch(self, branch_index):
         args = [
             arg.branch(branch_index) if hasattr(arg, "branch") else arg
             for arg in self.args
         ]
-        return type(self)(*args, taproot=self.taproot)
+        return self._clone(args)
+
+    def _clone(self, args):
+        """Same fragment with new arguments, keeps cached analysis"""
+        res = type(self)(*args, taproot=self.taproot)
+        res._type = self._type
+        res._props = self._props
+        res._len = self._len
+        res._verified = self._verified
+        return res
 
     @property
     def properties(self):
+        if self._props is None:
+            self._props = self.inner_properties()
+        return self._props
+
+    def inner_properties(self):
         return self.PROPS
 
     @property
     def type(self):
+        if self._type is None:
+            self._type = self.inner_type()
+        return self._type
+
+    def inner_type(self):
         return self.TYPE
 
     @classmethod
@@ -109,6 +139,11 @@ class Miniscript(DescriptorBase):
         return type(self).NAME + "(" + ",".join([str(arg) for arg in self.args]) + ")"
 
     def __len__(self):
+        if self._len is None:
+            self._len = self.inner_len()
+        return self._len
+
+    def inner_len(self):
         """Length of the compiled script, override this if you know the length"""
         return len(self.compile())
 
@@ -142,7 +177,7 @@ class PkK(OneArg):
     def inner_compile(self):
         return self.carg
 
-    def __len__(self):
+    def inner_len(self):
         return self.len_args()
 
 
@@ -156,7 +191,7 @@ class PkH(OneArg):
     def inner_compile(self):
         return b"\x76\xa9" + self.carg + b"\x88"
 
-    def __len__(self):
+    def inner_len(self):
         return self.len_args() + 3
 
 
@@ -170,14 +205,14 @@ class Older(OneArg):
     def inner_compile(self):
         return self.carg + b"\xb2"
 
-    def verify(self):
-        super().verify()
+    def inner_verify(self):
+        super().inner_verify()
         if (self.arg.num < 1) or (self.arg.num >= 0x80000000):
             raise MiniscriptError(
                 "%s should have an argument in range [1, 0x80000000)" % self.NAME
             )
 
-    def __len__(self):
+    def inner_len(self):
         return self.len_args() + 1
 
 
@@ -199,7 +234,7 @@ class Sha256(OneArg):
     def inner_compile(self):
         return b"\x82" + Number(32).compile() + b"\x88\xa8" + self.carg + b"\x87"
 
-    def __len__(self):
+    def inner_len(self):
         return self.len_args() + 6
 
 
@@ -234,14 +269,13 @@ class AndOr(Miniscript):
     NARGS = 3
     ARGCLS = Miniscript
 
-    @property
-    def type(self):
+    def inner_type(self):
         # same as Y/Z
         return self.args[1].type
 
-    def verify(self):
+    def inner_verify(self):
         # requires: X is Bdu; Y and Z are both B, K, or V
-        super().verify()
+        super().inner_verify()
         if self.args[0].type != "B":
             raise MiniscriptError("andor: X should be 'B'")
         px = self.args[0].properties
@@ -252,8 +286,7 @@ class AndOr(Miniscript):
         if self.args[1].type not in "BKV":
             raise MiniscriptError("andor: Y and Z should be B K or V")
 
-    @property
-    def properties(self):
+    def inner_properties(self):
         # props: z=zXzYzZ; o=zXoYoZ or oXzYzZ; u=uYuZ; d=dZ
         props = ""
         px, py, pz = [arg.properties for arg in self.args]
@@ -279,7 +312,7 @@ class AndOr(Miniscript):
             + b"\x68"
         )
 
-    def __len__(self):
+    def inner_len(self):
         return self.len_args() + 3
 
 
@@ -292,24 +325,22 @@ class AndV(Miniscript):
     def inner_compile(self):
         return self.args[0].compile() + self.args[1].compile()
 
-    def __len__(self):
+    def inner_len(self):
         return self.len_args()
 
-    def verify(self):
+    def inner_verify(self):
         # X is V; Y is B, K, or V
-        super().verify()
+        super().inner_verify()
         if self.args[0].type != "V":
             raise MiniscriptError("and_v: X should be 'V'")
         if self.args[1].type not in "BKV":
             raise MiniscriptError("and_v: Y should be B K or V")
 
-    @property
-    def type(self):
+    def inner_type(self):
         # same as Y
         return self.args[1].type
 
-    @property
-    def properties(self):
+    def inner_properties(self):
         # z=zXzY; o=zXoY or zYoX; n=nX or zXnY; u=uY
         px, py = [arg.properties for arg in self.args]
         props = ""
@@ -334,19 +365,18 @@ class AndB(Miniscript):
     def inner_compile(self):
         return self.args[0].compile() + self.args[1].compile() + b"\x9a"
 
-    def __len__(self):
+    def inner_len(self):
         return self.len_args() + 1
 
-    def verify(self):
+    def inner_verify(self):
         # X is B; Y is W
-        super().verify()
+        super().inner_verify()
         if self.args[0].type != "B":
             raise MiniscriptError("and_b: X should be B")
         if self.args[1].type != "W":
             raise MiniscriptError("and_b: Y should be W")
 
-    @property
-    def properties(self):
+    def inner_properties(self):
         # z=zXzY; o=zXoY or zYoX; n=nX or zXnY; d=dXdY; u
         px, py = [arg.properties for arg in self.args]
         props = ""
@@ -379,17 +409,16 @@ class AndN(Miniscript):
             + b"\x68"
         )
 
-    def __len__(self):
+    def inner_len(self):
         return self.len_args() + 4
 
-    @property
-    def type(self):
+    def inner_type(self):
         # same as Y/Z
         return self.args[1].type
 
-    def verify(self):
+    def inner_verify(self):
         # requires: X is Bdu; Y and Z are both B, K, or V
-        super().verify()
+        super().inner_verify()
         if self.args[0].type != "B":
             raise MiniscriptError("and_n: X should be 'B'")
         px = self.args[0].properties
@@ -398,8 +427,7 @@ class AndN(Miniscript):
         if self.args[1].type != "B":
             raise MiniscriptError("and_n: Y should be B")
 
-    @property
-    def properties(self):
+    def inner_properties(self):
         # props: z=zXzYzZ; o=zXoYoZ or oXzYzZ; u=uYuZ; d=dZ
         props = ""
         px, py = [arg.properties for arg in self.args]
@@ -427,12 +455,12 @@ class OrB(Miniscript):
     def inner_compile(self):
         return self.args[0].compile() + self.args[1].compile() + b"\x9b"
 
-    def __len__(self):
+    def inner_len(self):
         return self.len_args() + 1
 
-    def verify(self):
+    def inner_verify(self):
         # X is Bd; Z is Wd
-        super().verify()
+        super().inner_verify()
         if self.args[0].type != "B":
             raise MiniscriptError("or_b: X should be B")
         if "d" not in self.args[0].properties:
@@ -442,8 +470,7 @@ class OrB(Miniscript):
         if "d" not in self.args[1].properties:
             raise MiniscriptError("or_b: Z should be d")
 
-    @property
-    def properties(self):
+    def inner_properties(self):
         # z=zXzZ; o=zXoZ or zZoX; d; u
         props = ""
         px, pz = [arg.properties for arg in self.args]
@@ -465,12 +492,12 @@ class OrC(Miniscript):
     def inner_compile(self):
         return self.args[0].compile() + b"\x64" + self.args[1].compile() + b"\x68"
 
-    def __len__(self):
+    def inner_len(self):
         return self.len_args() + 2
 
-    def verify(self):
+    def inner_verify(self):
         # X is Bdu; Z is V
-        super().verify()
+        super().inner_verify()
         if self.args[0].type != "B":
             raise MiniscriptError("or_c: X should be B")
         if self.args[1].type != "V":
@@ -479,8 +506,7 @@ class OrC(Miniscript):
         if "d" not in px or "u" not in px:
             raise MiniscriptError("or_c: X should be du")
 
-    @property
-    def properties(self):
+    def inner_properties(self):
         # z=zXzZ; o=oXzZ
         props = ""
         px, pz = [arg.properties for arg in self.args]
@@ -501,12 +527,12 @@ class OrD(Miniscript):
     def inner_compile(self):
         return self.args[0].compile() + b"\x73\x64" + self.args[1].compile() + b"\x68"
 
-    def __len__(self):
+    def inner_len(self):
         return self.len_args() + 3
 
-    def verify(self):
+    def inner_verify(self):
         # X is Bdu; Z is B
-        super().verify()
+        super().inner_verify()
         if self.args[0].type != "B":
             raise MiniscriptError("or_d: X should be B")
         if self.args[1].type != "B":
@@ -515,8 +541,7 @@ class OrD(Miniscript):
         if "d" not in px or "u" not in px:
             raise MiniscriptError("or_d: X should be du")
 
-    @property
-    def properties(self):
+    def inner_properties(self):
         # z=zXzZ; o=oXzZ; d=dZ; u=uZ
         props = ""
         px, pz = [arg.properties for arg in self.args]
@@ -546,23 +571,21 @@ class OrI(Miniscript):
             + b"\x68"
         )
 
-    def __len__(self):
+    def inner_len(self):
         return self.len_args() + 3
 
-    def verify(self):
+    def inner_verify(self):
         # both are B, K, or V
-        super().verify()
+        super().inner_verify()
         if self.args[0].type != self.args[1].type:
             raise MiniscriptError("or_i: X and Z should be the same type")
         if self.args[0].type not in "BKV":
             raise MiniscriptError("or_i: X and Z should be B K or V")
 
-    @property
-    def type(self):
+    def inner_type(self):
         return self.args[0].type
 
-    @property
-    def properties(self):
+    def inner_properties(self):
         # o=zXzZ; u=uXuZ; d=dX or dZ
         props = ""
         px, pz = [arg.properties for arg in self.args]
@@ -590,12 +613,12 @@ class Thresh(Miniscript):
             + b"\x87"
         )
 
-    def __len__(self):
+    def inner_len(self):
         return self.len_args() + len(self.args) - 1
 
-    def verify(self):
+    def inner_verify(self):
         # 1 <= k <= n; X1 is Bdu; others are Wdu
-        super().verify()
+        super().inner_verify()
         if self.args[0].num < 1 or self.args[0].num >= len(self.args):
             raise MiniscriptError(
                 "thresh: Invalid k! Should be 1 <= k <= %d, got %d"
@@ -613,8 +636,7 @@ class Thresh(Miniscript):
             if "d" not in p or "u" not in p:
                 raise MiniscriptError("thresh: X%d should be du" % (i + 1))
 
-    @property
-    def properties(self):
+    def inner_properties(self):
         # z=all are z; o=all are z except one is o; d; u
         props = ""
         parr = [arg.properties for arg in self.args[1:]]
@@ -651,11 +673,11 @@ class Multi(Miniscript):
             + b"\xae"
         )
 
-    def __len__(self):
+    def inner_len(self):
         return self.len_args() + 2
 
-    def verify(self):
-        super().verify()
+    def inner_verify(self):
+        super().inner_verify()
         if self.args[0].num < 1 or self.args[0].num > (len(self.args) - 1):
             raise MiniscriptError(
                 "multi: 1 <= k <= %d, got %d" % ((len(self.args) - 1), self.args[0].num)
@@ -689,7 +711,7 @@ class MultiA(Multi):
             + b"\x9c"
         )
 
-    def __len__(self):
+    def inner_len(self):
         return self.len_args() + len(self.args)
 
 
@@ -718,7 +740,7 @@ class Pk(OneArg):
     def inner_compile(self):
         return self.carg + b"\xac"
 
-    def __len__(self):
+    def inner_len(self):
         return self.len_args() + 1
 
 
@@ -732,7 +754,7 @@ class Pkh(OneArg):
     def inner_compile(self):
         return b"\x76\xa9" + self.carg + b"\x88\xac"
 
-    def __len__(self):
+    def inner_len(self):
         return self.len_args() + 4
 
     # TODO: 0, 1 - they are without brackets, so it should be different...
@@ -788,16 +810,15 @@ class A(Wrapper):
     def inner_compile(self):
         return b"\x6b" + self.carg + b"\x6c"
 
-    def __len__(self):
+    def inner_len(self):
         return len(self.arg) + 2
 
-    def verify(self):
-        super().verify()
+    def inner_verify(self):
+        super().inner_verify()
         if self.arg.type != "B":
             raise MiniscriptError("a: X should be B")
 
-    @property
-    def properties(self):
+    def inner_properties(self):
         props = ""
         px = self.arg.properties
         if "d" in px:
@@ -814,18 +835,17 @@ class S(Wrapper):
     def inner_compile(self):
         return b"\x7c" + self.carg
 
-    def __len__(self):
+    def inner_len(self):
         return len(self.arg) + 1
 
-    def verify(self):
-        super().verify()
+    def inner_verify(self):
+        super().inner_verify()
         if self.arg.type != "B":
             raise MiniscriptError("s: X should be B")
         if "o" not in self.arg.properties:
             raise MiniscriptError("s: X should be o")
 
-    @property
-    def properties(self):
+    def inner_properties(self):
         props = ""
         px = self.arg.properties
         if "d" in px:
@@ -842,16 +862,15 @@ class C(Wrapper):
     def inner_compile(self):
         return self.carg + b"\xac"
 
-    def __len__(self):
+    def inner_len(self):
         return len(self.arg) + 1
 
-    def verify(self):
-        super().verify()
+    def inner_verify(self):
+        super().inner_verify()
         if self.arg.type != "K":
             raise MiniscriptError("c: X should be K")
 
-    @property
-    def properties(self):
+    def inner_properties(self):
         props = ""
         px = self.arg.properties
         for p in ["o", "n", "d"]:
@@ -868,11 +887,10 @@ class T(Wrapper):
     def inner_compile(self):
         return self.carg + Number(1).compile()
 
-    def __len__(self):
+    def inner_len(self):
         return len(self.arg) + 1
 
-    @property
-    def properties(self):
+    def inner_properties(self):
         # z=zXzY; o=zXoY or zYoX; n=nX or zXnY; u=uY
         px = self.arg.properties
         py = "zu"
@@ -895,18 +913,17 @@ class D(Wrapper):
     def inner_compile(self):
         return b"\x76\x63" + self.carg + b"\x68"
 
-    def __len__(self):
+    def inner_len(self):
         return len(self.arg) + 3
 
-    def verify(self):
-        super().verify()
+    def inner_verify(self):
+        super().inner_verify()
         if self.arg.type != "V":
             raise MiniscriptError("d: X should be V")
         if "z" not in self.arg.properties:
             raise MiniscriptError("d: X should be z")
 
-    @property
-    def properties(self):
+    def inner_properties(self):
         # https://github.com/bitcoin/bitcoin/pull/24906
         if self.taproot:
             props = "ndu"
@@ -928,13 +945,12 @@ class V(Wrapper):
             return self.carg[:-1] + bytes([self.carg[-1] + 1])
         return self.carg + b"\x69"
 
-    def verify(self):
-        super().verify()
+    def inner_verify(self):
+        super().inner_verify()
         if self.arg.type != "B":
             raise MiniscriptError("v: X should be B")
 
-    @property
-    def properties(self):
+    def inner_properties(self):
         props = ""
         px = self.arg.properties
         for p in ["z", "o", "n"]:
@@ -950,15 +966,14 @@ class J(Wrapper):
     def inner_compile(self):
         return b"\x82\x92\x63" + self.carg + b"\x68"
 
-    def verify(self):
-        super().verify()
+    def inner_verify(self):
+        super().inner_verify()
         if self.arg.type != "B":
             raise MiniscriptError("j: X should be B")
         if "n" not in self.arg.properties:
             raise MiniscriptError("j: X should be n")
 
-    @property
-    def properties(self):
+    def inner_properties(self):
         props = "nd"
         px = self.arg.properties
         for p in ["o", "u"]:
@@ -974,16 +989,15 @@ class N(Wrapper):
     def inner_compile(self):
         return self.carg + b"\x92"
 
-    def __len__(self):
+    def inner_len(self):
         return len(self.arg) + 1
 
-    def verify(self):
-        super().verify()
+    def inner_verify(self):
+        super().inner_verify()
         if self.arg.type != "B":
             raise MiniscriptError("n: X should be B")
 
-    @property
-    def properties(self):
+    def inner_properties(self):
         props = "u"
         px = self.arg.properties
         for p in ["z", "o", "n", "d"]:
@@ -999,17 +1013,16 @@ class L(Wrapper):
     def inner_compile(self):
         return b"\x63" + Number(0).compile() + b"\x67" + self.carg + b"\x68"
 
-    def __len__(self):
+    def inner_len(self):
         return len(self.arg) + 4
 
-    def verify(self):
+    def inner_verify(self):
         # both are B, K, or V
-        super().verify()
+        super().inner_verify()
         if self.arg.type != "B":
             raise MiniscriptError("or_i: X and Z should be the same type")
 
-    @property
-    def properties(self):
+    def inner_properties(self):
         # o=zXzZ; u=uXuZ; d=dX or dZ
         props = "d"
         pz = self.arg.properties
@@ -1025,7 +1038,7 @@ class U(L):
     def inner_compile(self):
         return b"\x63" + self.carg + b"\x67" + Number(0).compile() + b"\x68"
 
-    def __len__(self):
+    def inner_len(self):
         return len(self.arg) + 4
 
 
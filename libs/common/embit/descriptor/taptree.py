@@ -5,10 +5,17 @@ from ..hashes import tagged_hash
 from ..script import Script
 
 
+# number of derived trees cached by TapTree.derive()
+DERIVE_CACHE_SIZE = 4
+
+
 class TapLeaf(DescriptorBase):
     def __init__(self, miniscript=None, version=0xC0):
         self.miniscript = miniscript
         self.version = version
+        # compiled script and leaf hash, calculated on first use
+        self._script = None
+        self._hash = None
 
     def __str__(self):
         return str(self.miniscript)
@@ -18,18 +25,34 @@ class TapLeaf(DescriptorBase):
         ms = Miniscript.read_from(s, taproot=True)
         return cls(ms)
 
+    def script(self) -> bytes:
+        """Compiled leaf script"""
+        if self._script is None:
+            self._script = self.miniscript.compile()
+        return self._script
+
     def serialize(self):
         if self.miniscript is None:
             return b""
-        return bytes([self.version]) + Script(self.miniscript.compile()).serialize()
+        return bytes([self.version]) + Script(self.script()).serialize()
+
+    def leaf_hash(self) -> bytes:
+        if self._hash is None:
+            self._hash = tagged_hash("TapLeaf", self.serialize())
+        return self._hash
 
     @property
     def keys(self):
         return self.miniscript.keys
 
+    @property
+    def can_derive(self):
+        return self.miniscript is not None and any(k.can_derive for k in self.keys)
+
     def derive(self, *args, **kwargs):
-        if self.miniscript is None:
-            return type(self)(None, version=self.version)
+        # leaf without derivable keys is the same for all indexes
+        if not self.can_derive:
+            return self
         return type(self)(
             self.miniscript.derive(*args, **kwargs),
             self.version,
@@ -55,11 +78,11 @@ class TapLeaf(DescriptorBase):
 def _tweak_helper(tree):
     # https://github.com/bitcoin/bips/blob/master/bip-0341.mediawiki#constructing-and-spending-taproot-outputs
     if isinstance(tree, TapTree):
-        tree = tree.tree
+        # subtrees keep their result
+        return tree.compile()
     if isinstance(tree, TapLeaf):
         # one leaf on this branch
-        h = tagged_hash("TapLeaf", tree.serialize())
-        return ([(tree, b"")], h)
+        return ([(tree, b"")], tree.leaf_hash())
     left, left_h = _tweak_helper(tree[0])
     right, right_h = _tweak_helper(tree[1])
     ret = [(leaf, c + right_h) for leaf, c in left] + [
@@ -77,15 +100,40 @@ class TapTree(DescriptorBase):
         # make sure all keys are taproot
         for k in self.keys:
             k.taproot = True
+        # (leaves with merkle paths, merkle root), calculated on first use
+        self._compiled = None
+        # derive() arguments -> derived tree
+        self._derived = {}
 
     def __bool__(self):
         return bool(self.tree)
 
+    def compile(self):
+        """
+        Returns a list of (TapLeaf, merkle path) and the merkle root.
+        Result is cached, derived trees reuse results of subtrees
+        without derivable keys, so only branches with changed keys are hashed.
+        """
+        if self._compiled is None:
+            self._compiled = _tweak_helper(self.tree)
+        return self._compiled
+
     def tweak(self):
         if self.tree is None:
             return b""
-        _, h = _tweak_helper(self.tree)
-        return h
+        return self.compile()[1]
+
+    def leaf_hashes(self):
+        """
+        Returns a dict {leaf script + leaf version: leaf hash}.
+        Keys have the same format as taproot scripts in PSBT inputs.
+        """
+        if self.tree is None:
+            return {}
+        return {
+            leaf.script() + bytes([leaf.version]): leaf.leaf_hash()
+            for leaf, _ in self.compile()[0]
+        }
 
     @property
     def keys(self):
@@ -116,13 +164,31 @@ class TapTree(DescriptorBase):
         ms = TapLeaf.read_from(s)
         return cls(ms)
 
+    @property
+    def can_derive(self):
+        return any(k.can_derive for k in self.keys)
+
     def derive(self, *args, **kwargs):
-        if self.tree is None:
-            return type(self)(None)
+        """
+        Derived trees are cached, so the same index used for address,
+        owns() and signing compiles leaf scripts and hashes only once.
+        """
+        # subtree without derivable keys is the same for all indexes
+        if self.tree is None or not self.can_derive:
+            return self
+        key = (args, tuple(sorted(kwargs.items())))
+        res = self._derived.get(key)
+        if res is not None:
+            return res
         if isinstance(self.tree, TapLeaf):
-            return type(self)(self.tree.derive(*args, **kwargs))
-        left, right = self.tree
-        return type(self)((left.derive(*args, **kwargs), right.derive(*args, **kwargs)))
+            res = type(self)(self.tree.derive(*args, **kwargs))
+        else:
+            left, right = self.tree
+            res = type(self)((left.derive(*args, **kwargs), right.derive(*args, **kwargs)))
+        if len(self._derived) >= DERIVE_CACHE_SIZE:
+            self._derived = {}
+        self._derived[key] = res
+        return res
 
     def branch(self, *args, **kwargs):
         if self.tree is None:
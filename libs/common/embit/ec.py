@@ -32,14 +32,29 @@ class SchnorrSig(EmbitBase):
     def write_to(self, stream) -> int:
         return stream.write(self._sig)
 
+    def serialized_len(self) -> int:
+        return 64
+
     @classmethod
     def read_from(cls, stream):
         return cls(stream.read(64))
 
 
 class PublicKey(EmbitKey):
-    def __init__(self, point: bytes, compressed: bool = True):
+    """
+    Public key keeps the internal secp256k1 point and caches SEC bytes.
+    Keys parsed from SEC are validated and keep the original bytes,
+    so comparing and hashing them doesn't re-serialize the point.
+    """
+
+    def __init__(self, point: bytes = None, compressed: bool = True, sec: bytes = None):
+        if point is None:
+            try:
+                point = secp256k1.ec_pubkey_parse(sec)
+            except Exception as e:
+                raise ECError(str(e))
         self._point = point
+        self._sec = sec
         self.compressed = compressed
 
     @classmethod
@@ -51,17 +66,16 @@ class PublicKey(EmbitKey):
             b += stream.read(64)
         else:
             b += stream.read(32)
-        try:
-            point = secp256k1.ec_pubkey_parse(b)
-        except Exception as e:
-            raise ECError(str(e))
         compressed = b[0] != 0x04
-        return cls(point, compressed)
+        return cls(compressed=compressed, sec=b)
 
     def sec(self) -> bytes:
         """Sec representation of the key"""
-        flag = secp256k1.EC_COMPRESSED if self.compressed else secp256k1.EC_UNCOMPRESSED
-        return secp256k1.ec_pubkey_serialize(self._point, flag)
+        # re-serialize if compressed flag was changed after creation
+        if self._sec is None or (self._sec[0] == 0x04) == self.compressed:
+            flag = secp256k1.EC_COMPRESSED if self.compressed else secp256k1.EC_UNCOMPRESSED
+            self._sec = secp256k1.ec_pubkey_serialize(self._point, flag)
+        return self._sec
 
     def xonly(self) -> bytes:
         return self.sec()[1:33]
@@ -72,10 +86,12 @@ class PublicKey(EmbitKey):
         tweak = hashes.tagged_hash("TapTweak", x + h)
         if not secp256k1.ec_seckey_verify(tweak):
             raise EmbitError("Tweak is too large")
-        point = secp256k1.ec_pubkey_parse(b"\x02" + x)
+        # internal point with even y, same layout as a public key
+        point, _ = secp256k1.xonly_pubkey_from_pubkey(self._point)
         pub = secp256k1.ec_pubkey_add(point, tweak)
-        sec = secp256k1.ec_pubkey_serialize(pub)
-        return PublicKey.from_xonly(sec[1:33])
+        # output key is x-only, so keep the point with even y
+        pub, _ = secp256k1.xonly_pubkey_from_pubkey(pub)
+        return PublicKey(pub)
 
     def write_to(self, stream) -> int:
         return stream.write(self.sec())
@@ -83,6 +99,9 @@ class PublicKey(EmbitKey):
     def serialize(self) -> bytes:
         return self.sec()
 
+    def serialized_len(self) -> int:
+        return 33 if self.compressed else 65
+
     def verify(self, sig, msg_hash) -> bool:
         return bool(secp256k1.ecdsa_verify(sig._sig, msg_hash, self._point))
 
@@ -94,7 +113,7 @@ class PublicKey(EmbitKey):
     @classmethod
     def from_xonly(cls, data: bytes):
         assert len(data) == 32
-        return cls.parse(b"\x02" + data)
+        return cls(sec=b"\x02" + data)
 
     def schnorr_verify(self, sig, msg_hash) -> bool:
         return bool(secp256k1.schnorrsig_verify(sig._sig, msg_hash, self._xonly()))
@@ -122,7 +141,7 @@ class PublicKey(EmbitKey):
         return self.sec() == other.sec()
 
     def __hash__(self):
-        return hash(self._point)
+        return hash(self.sec())
 
 
 class PrivateKey(EmbitKey):
@@ -135,6 +154,7 @@ class PrivateKey(EmbitKey):
         self.compressed = compressed
         self._secret = secret
         self.network = network
+        self._pub = None
 
     def wif(self, network=None) -> str:
         """Export private key as Wallet Import Format string.
@@ -207,7 +227,10 @@ class PrivateKey(EmbitKey):
         return cls.from_wif(s)
 
     def get_public_key(self) -> PublicKey:
-        return PublicKey(secp256k1.ec_pubkey_create(self._secret), self.compressed)
+        # secret never changes, so public key is derived only once
+        if self._pub is None or self._pub.compressed != self.compressed:
+            self._pub = PublicKey(secp256k1.ec_pubkey_create(self._secret), self.compressed)
+        return self._pub
 
     def to_public(self) -> PublicKey:
         """Alias to get_public_key for API consistency"""
@@ -242,6 +265,9 @@ class PrivateKey(EmbitKey):
         # return a copy of the secret
         return stream.write(self._secret)
 
+    def serialized_len(self) -> int:
+        return 32
+
     def ecdh(self, public_key: PublicKey, hashfn=None, data=None) -> bytes:
         pubkey_point = secp256k1.ec_pubkey_parse(public_key.sec())
         return secp256k1.ecdh(pubkey_point, self._secret, hashfn, data)
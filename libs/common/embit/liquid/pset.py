@@ -21,10 +21,18 @@ from .transaction import (
     LSIGHASH,
     unblind,
 )
-from . import slip77
 import hashlib, gc
 
 
+def blinding_factors(txseed: bytes, idx: int):
+    """Deterministic asset and value blinding factors of output idx"""
+    i = idx.to_bytes(4, "little")
+    return (
+        hashes.tagged_hash("liquid/abf", txseed + i),
+        hashes.tagged_hash("liquid/vbf", txseed + i),
+    )
+
+
 class LInputScope(InputScope):
     TX_CLS = LTransaction
     TXOUT_CLS = LTransactionOutput
@@ -81,6 +89,8 @@ class LInputScope(InputScope):
         if self.range_proof is None:
             return
 
+        from . import slip77
+
         pk = slip77.blinding_key(blinding_key, self.utxo.script_pubkey)
         try:
             value, asset, vbf, in_abf, extra, min_value, max_value = unblind(
@@ -384,6 +394,69 @@ class LOutputScope(OutputScope):
             secp256k1.generator_parse(self.asset_commitment),
         )
 
+    def generate_proofs(self, txseed, idx, in_tags, in_gens, in_abfs):
+        """
+        Calculates commitments and generates surjection, range, asset and value proofs.
+        Blinding factors should be set already, idx is the index of this output.
+        in_tags, in_gens and in_abfs are assets, generators and asset blinding factors of inputs.
+        """
+        gen = secp256k1.generator_generate_blinded(
+            self.asset, self.asset_blinding_factor
+        )
+        self.asset_commitment = secp256k1.generator_serialize(gen)
+        value_commitment = secp256k1.pedersen_commit(
+            self.value_blinding_factor, self.value, gen
+        )
+        self.value_commitment = secp256k1.pedersen_commitment_serialize(
+            value_commitment
+        )
+
+        proof_seed = hashes.tagged_hash(
+            "liquid/surjection_proof", txseed + idx.to_bytes(4, "little")
+        )
+        proof, in_idx = secp256k1.surjectionproof_initialize(
+            in_tags, self.asset, proof_seed
+        )
+        secp256k1.surjectionproof_generate(
+            proof, in_idx, in_gens, gen, in_abfs[in_idx], self.asset_blinding_factor
+        )
+        self.surjection_proof = secp256k1.surjectionproof_serialize(proof)
+        del proof
+        gc.collect()
+
+        # generate range proof
+        rangeproof_nonce = hashes.tagged_hash(
+            "liquid/range_proof", txseed + idx.to_bytes(4, "little")
+        )
+        self.reblind(rangeproof_nonce)
+
+        # generate asset proof
+        gen_asset = secp256k1.generator_generate(self.asset)
+        proof, asset_idx = secp256k1.surjectionproof_initialize(
+            [self.asset], self.asset, b"\x00" * 32, 1, 1
+        )
+        proof = secp256k1.surjectionproof_generate(
+            proof, asset_idx, [gen_asset], gen, b"\x00" * 32, self.asset_blinding_factor
+        )
+        self.asset_proof = secp256k1.surjectionproof_serialize(proof)
+
+        # generate value proof
+        value_proof_nonce = hashes.tagged_hash(
+            "liquid/value_proof", txseed + idx.to_bytes(4, "little")
+        )
+        self.value_proof = secp256k1.rangeproof_sign(
+            value_proof_nonce,
+            self.value,
+            value_commitment,
+            self.value_blinding_factor,
+            b"",
+            b"",
+            gen,
+            self.value,  # min_value
+            -1,  # exp
+            0,  # min bits
+        )
+
     def read_value(self, stream, k):
         if (b"\xfc\x08elements" not in k) and (b"\xfc\x04pset" not in k):
             super().read_value(stream, k)
@@ -525,12 +598,9 @@ class PSET(PSBT):
             # skip ones where we don't need blinding
             if out.blinding_pubkey is None or out.value is None:
                 continue
-            out.asset_blinding_factor = hashes.tagged_hash(
-                "liquid/abf", txseed + i.to_bytes(4, "little")
-            )
-            out.value_blinding_factor = hashes.tagged_hash(
-                "liquid/vbf", txseed + i.to_bytes(4, "little")
-            )
+            abf, vbf = blinding_factors(txseed, i)
+            out.asset_blinding_factor = abf
+            out.value_blinding_factor = vbf
             blinding_outs.append(out)
         if len(blinding_outs) == 0:
             raise PSBTError("Nothing to blind")
@@ -567,62 +637,7 @@ class PSET(PSBT):
         for i, out in enumerate(self.outputs):
             if None in [out.blinding_pubkey, out.value, out.asset_blinding_factor]:
                 continue
-            gen = secp256k1.generator_generate_blinded(
-                out.asset, out.asset_blinding_factor
-            )
-            out.asset_commitment = secp256k1.generator_serialize(gen)
-            value_commitment = secp256k1.pedersen_commit(
-                out.value_blinding_factor, out.value, gen
-            )
-            out.value_commitment = secp256k1.pedersen_commitment_serialize(
-                value_commitment
-            )
-
-            proof_seed = hashes.tagged_hash(
-                "liquid/surjection_proof", txseed + i.to_bytes(4, "little")
-            )
-            proof, in_idx = secp256k1.surjectionproof_initialize(
-                in_tags, out.asset, proof_seed
-            )
-            secp256k1.surjectionproof_generate(
-                proof, in_idx, in_gens, gen, abfs[in_idx], out.asset_blinding_factor
-            )
-            out.surjection_proof = secp256k1.surjectionproof_serialize(proof)
-            del proof
-            gc.collect()
-
-            # generate range proof
-            rangeproof_nonce = hashes.tagged_hash(
-                "liquid/range_proof", txseed + i.to_bytes(4, "little")
-            )
-            out.reblind(rangeproof_nonce)
-
-            # generate asset proof
-            gen_asset = secp256k1.generator_generate(out.asset)
-            proof, idx = secp256k1.surjectionproof_initialize(
-                [out.asset], out.asset, b"\x00" * 32, 1, 1
-            )
-            proof = secp256k1.surjectionproof_generate(
-                proof, idx, [gen_asset], gen, b"\x00" * 32, out.asset_blinding_factor
-            )
-            out.asset_proof = secp256k1.surjectionproof_serialize(proof)
-
-            # generate value proof
-            value_proof_nonce = hashes.tagged_hash(
-                "liquid/value_proof", txseed + i.to_bytes(4, "little")
-            )
-            out.value_proof = secp256k1.rangeproof_sign(
-                value_proof_nonce,
-                out.value,
-                value_commitment,
-                out.value_blinding_factor,
-                b"",
-                b"",
-                gen,
-                out.value,  # min_value
-                -1,  # exp
-                0,  # min bits
-            )
+            out.generate_proofs(txseed, i, in_tags, in_gens, abfs)
 
     def fee(self):
         fee = 0
@@ -1,6 +1,7 @@
 from ..psbtview import *
 from .pset import *
-import hashlib
+from .. import hashes
+import hashlib, gc
 
 
 def skip_commitment(stream):
@@ -114,12 +115,17 @@ class PSETView(PSBTView):
     PSBTIN_CLS = LInputScope
     PSBTOUT_CLS = LOutputScope
     TX_CLS = GlobalLTransactionView
+    # buffer size for hashing of range and surjection proofs
+    HASH_CHUNK = 256
 
     def clear_cache(self):
         # cache for digests
         super().clear_cache()
         self._hash_rangeproofs = None
         self._hash_issuances = None
+        # unblinded inputs for the last used blinding key
+        self._blinding_key = None
+        self._unblinded = {}
 
     def vin(self, i, compress=None):
         return self.input(i, True).vin
@@ -145,59 +151,113 @@ class PSETView(PSBTView):
             self._hash_issuances = h.digest()
         return self._hash_issuances
 
-    def _hash_to(self, h, l):
-        while l > 32:
-            h.update(self.stream.read(32))
-            l -= 32
-        h.update(self.stream.read(l))
+    def _hash_to(self, h, l, buf):
+        """Hashes next l bytes of the stream reading them into buf"""
+        while l > 0:
+            r = self.stream.readinto(buf if l >= len(buf) else buf[:l])
+            if not r:
+                raise PSBTError("Unexpected end of stream")
+            h.update(buf[:r])
+            l -= r
 
-    def hash_rangeproofs(self):
-        if self._hash_rangeproofs is None:
-            h = hashlib.sha256()
-            for i in range(self.num_outputs):
-                off = self.seek_to_scope(self.num_inputs + i)
-                rangeproof_offset = self.seek_to_value(
-                    b"\xfc\x04pset\x04", from_current=True
-                )
-                if not rangeproof_offset:
-                    self.stream.seek(off)
-                    rangeproof_offset = self.seek_to_value(
-                        b"\xfc\x08elements\x04", from_current=True
-                    )
-                if not rangeproof_offset:
-                    h.update(b"\x00")
-                else:
-                    l = compact.read_from(self.stream)
-                    h.update(compact.to_bytes(l))
-                    self._hash_to(h, l)
+    def _scan_proofs(self):
+        """
+        Reads keys of the current output scope till the separator.
+        Returns offsets and lengths of range and surjection proofs
+        ((offset, len) or None) and offset of the next scope relative to current.
+        """
+        rangeproof = None
+        surj_proof = None
+        off = 0
+        while True:
+            key = read_string(self.stream)
+            off += len(key) + compact.size(len(key))
+            if len(key) == 0:
+                return rangeproof, surj_proof, off
+            l = compact.read_from(self.stream)
+            off += compact.size(l)
+            # pset keys take precedence over legacy elements keys
+            if key == b"\xfc\x04pset\x04" or (
+                key == b"\xfc\x08elements\x04" and rangeproof is None
+            ):
+                rangeproof = (off, l)
+            elif key == b"\xfc\x04pset\x05" or (
+                key == b"\xfc\x08elements\x05" and surj_proof is None
+            ):
+                surj_proof = (off, l)
+            self.stream.seek(l, 1)
+            off += l
 
-                self.stream.seek(off)
-                surj_proof_offset = self.seek_to_value(
-                    b"\xfc\x04pset\x05", from_current=True
-                )
-                if not surj_proof_offset:
-                    self.stream.seek(off)
-                    surj_proof_offset = self.seek_to_value(
-                        b"\xfc\x08elements\x05", from_current=True
-                    )
-                if not surj_proof_offset:
-                    h.update(b"\x00")
+    def _hash_outputs_and_proofs(self):
+        """
+        Calculates hash_outputs and hash_rangeproofs in one pass over output scopes,
+        proofs are hashed through a fixed buffer without loading them to memory.
+        """
+        h = hashlib.sha256()
+        hp = hashlib.sha256()
+        buf = memoryview(bytearray(self.HASH_CHUNK))
+        off = self.seek_to_scope(self.num_inputs)
+        for i in range(self.num_outputs):
+            vout = self.tx.vout(i) if self.tx else None
+            self.stream.seek(off)
+            out = self.PSBTOUT_CLS.read_from(self.stream, vout=vout, compress=True)
+            h.update(out.blinded_vout.serialize())
+            self.stream.seek(off)
+            proofs = self._scan_proofs()
+            for proof in proofs[:2]:
+                if proof is None:
+                    hp.update(b"\x00")
                 else:
-                    l = compact.read_from(self.stream)
-                    h.update(compact.to_bytes(l))
-                    self._hash_to(h, l)
-            self._hash_rangeproofs = h.digest()
+                    self.stream.seek(off + proof[0])
+                    hp.update(compact.to_bytes(proof[1]))
+                    self._hash_to(hp, proof[1], buf)
+            off += proofs[2]
+        self._hash_outputs = h.digest()
+        self._hash_rangeproofs = hp.digest()
+
+    def hash_rangeproofs(self):
+        if self._hash_rangeproofs is None:
+            self._hash_outputs_and_proofs()
         return self._hash_rangeproofs
 
     def hash_outputs(self):
         if self._hash_outputs is None:
-            h = hashlib.sha256()
-            for i in range(self.num_outputs):
-                out = self.blinded_vout(i)
-                h.update(out.serialize())
-            self._hash_outputs = h.digest()
+            self._hash_outputs_and_proofs()
         return self._hash_outputs
 
+    def unblind_input(self, i, blinding_key, inp=None):
+        """
+        Unblinds input i like LInputScope.unblind and returns the scope.
+        inp is the already parsed input i, it is parsed again with
+        range proof if it doesn't have it.
+        Value, asset and blinding factors are cached for the last used
+        blinding key, so resumed blinding doesn't repeat ECDH and rewind.
+        """
+        if blinding_key != self._blinding_key:
+            self._blinding_key = blinding_key
+            self._unblinded = {}
+        res = self._unblinded.get(i)
+        if res is None:
+            if inp is None or inp.range_proof is None:
+                inp = self.input(i, compress=CompressMode.KEEP_ALL)
+            inp.unblind(blinding_key)
+            res = (
+                inp.value,
+                inp.asset,
+                inp.value_blinding_factor,
+                inp.asset_blinding_factor,
+            )
+            self._unblinded[i] = res
+        elif inp is None:
+            inp = self.input(i)
+        (
+            inp.value,
+            inp.asset,
+            inp.value_blinding_factor,
+            inp.asset_blinding_factor,
+        ) = res
+        return inp
+
     def sighash_segwit(
         self,
         input_index,
@@ -255,6 +315,105 @@ class PSETView(PSBTView):
         h.update(sighash.to_bytes(4, "little"))
         return hashlib.sha256(h.digest()).digest()
 
+    def txseed(self, seed: bytes):
+        """Same as PSET.txseed, but hashes inputs and outputs one by one"""
+        assert len(seed) == 32
+        h = hashes.tagged_hash_init("liquid/txseed", seed)
+        for i in range(self.num_inputs):
+            vin = self.vin(i)
+            h.update(bytes(reversed(vin.txid)) + vin.vout.to_bytes(4, "little"))
+        for i in range(self.num_outputs):
+            out = self.output(i, compress=True)
+            h.update(out.script_pubkey.serialize())
+        return h.digest()
+
+    def blind(self, seed: bytes, writable_stream, blinding_key=None, start_output=0):
+        """
+        Blinds outputs one by one and writes blinded PSET to writable_stream.
+        Result is the same as PSET.blind(seed) followed by PSET.write_to(),
+        but only one output with its proofs is kept in memory.
+        If blinding_key is set, inputs are unblinded with it first (like PSET.unblind).
+
+        This is a generator yielding (output index, total bytes written)
+        after every output, so the caller can update progress between outputs.
+        To resume interrupted blinding pass start_output - number of outputs
+        already in writable_stream. Global scope and inputs are written
+        only if start_output is 0.
+        """
+        if start_output < 0 or start_output > self.num_outputs:
+            raise PSBTError("Invalid output index")
+        txseed = self.txseed(seed)
+        res = 0
+        if start_output == 0:
+            self.stream.seek(self.offset)
+            res += read_write(
+                self.stream, writable_stream, self.first_scope - self.offset
+            )
+        # inputs: values and blinding factors for blind sum, tags for surjection proofs
+        vals = []
+        abfs = []
+        vbfs = []
+        in_tags = []
+        in_gens = []
+        # range proofs are needed only to write inputs,
+        # unblind_input() reads them if the input is not cached yet
+        for i in range(self.num_inputs):
+            inp = self.input(i, compress=(self.compress if start_output == 0 else True))
+            if blinding_key is not None:
+                inp = self.unblind_input(i, blinding_key, inp)
+            value = inp.value if inp.value is not None else inp.utxo.value
+            asset = inp.asset or inp.utxo.asset
+            if isinstance(value, int) and len(asset) == 32:
+                vals.append(value)
+                abfs.append(inp.asset_blinding_factor or b"\x00" * 32)
+                vbfs.append(inp.value_blinding_factor or b"\x00" * 32)
+            if inp.asset:
+                in_tags.append(inp.asset)
+                in_gens.append(secp256k1.generator_parse(inp.utxo.asset))
+            # if we have unconfidential input
+            elif len(inp.utxo.asset) == 32:
+                in_tags.append(inp.utxo.asset)
+                in_gens.append(secp256k1.generator_generate(inp.utxo.asset))
+            if start_output == 0:
+                res += inp.write_to(writable_stream, version=self.version)
+            del inp
+        num_inputs = len(vals)
+        # outputs: only amounts and blinding factors for blind sum
+        num_blinding = 0
+        last = None
+        for i in range(self.num_outputs):
+            out = self.output(i, compress=True)
+            if out.blinding_pubkey is None or out.value is None:
+                continue
+            num_blinding += 1
+            last = i
+            if not (isinstance(out.value, int) and len(out.asset) == 32):
+                continue
+            abf, vbf = blinding_factors(txseed, i)
+            vals.append(out.value)
+            abfs.append(abf)
+            vbfs.append(vbf)
+        if num_blinding == 0:
+            raise PSBTError("Nothing to blind")
+        last_vbf = secp256k1.pedersen_blind_generator_blind_sum(
+            vals, abfs, vbfs, len(vals) - num_blinding
+        )
+        # surjection proofs only need input blinding factors
+        del vals, vbfs, abfs[num_inputs:]
+        gc.collect()
+
+        for i in range(start_output, self.num_outputs):
+            out = self.output(i)
+            if out.blinding_pubkey is not None and out.value is not None:
+                abf, vbf = blinding_factors(txseed, i)
+                out.asset_blinding_factor = abf
+                out.value_blinding_factor = last_vbf if i == last else vbf
+                out.generate_proofs(txseed, i, in_tags, in_gens, abfs)
+            res += out.write_to(writable_stream, version=self.version)
+            del out
+            gc.collect()
+            yield i, res
+
     def sighash_legacy(self, input_index, script_pubkey, sighash=SIGHASH.ALL):
         raise NotImplementedError()
 
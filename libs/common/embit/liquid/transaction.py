@@ -450,6 +450,10 @@ class LTransactionInput(TransactionInput):
             res += self.asset_issuance.write_to(stream)
         return res
 
+    def serialized_len(self, script_sig=None):
+        # layout differs from bitcoin inputs
+        return EmbitBase.serialized_len(self, script_sig)
+
     @classmethod
     def read_from(cls, stream):
         txid = bytes(reversed(stream.read(32)))
@@ -506,6 +510,10 @@ class LTransactionOutput(TransactionOutput):
         res += self.script_pubkey.write_to(stream)
         return res
 
+    def serialized_len(self):
+        # layout differs from bitcoin outputs
+        return EmbitBase.serialized_len(self)
+
     @property
     def is_blinded(self):
         return self.ecdh_pubkey is not None
@@ -1,7 +1,6 @@
 from collections import OrderedDict
 from .transaction import Transaction, TransactionOutput, TransactionInput, SIGHASH
 from . import compact
-from . import bip32
 from . import ec
 from . import hashes
 from . import script
@@ -26,6 +25,17 @@ def ser_string(stream, s: bytes) -> int:
     return stream.write(compact.to_bytes(len(s))) + stream.write(s)
 
 
+def ser_value(stream, obj) -> int:
+    """Same as ser_string(stream, obj.serialize()) without a copy of obj in RAM"""
+    return stream.write(compact.to_bytes(obj.serialized_len())) + obj.write_to(stream)
+
+
+def ser_key(stream, key_type: bytes, obj) -> int:
+    """Key of type key_type with serialized obj as key data, i.e. pubkey"""
+    r = stream.write(compact.to_bytes(len(key_type) + obj.serialized_len()))
+    return r + stream.write(key_type) + obj.write_to(stream)
+
+
 def read_string(stream) -> bytes:
     l = compact.read_from(stream)
     s = stream.read(l)
@@ -37,7 +47,7 @@ def read_string(stream) -> bytes:
 def skip_string(stream) -> int:
     l = compact.read_from(stream)
     stream.seek(l, 1)
-    return len(compact.to_bytes(l)) + l
+    return compact.size(l) + l
 
 
 class DerivationPath(EmbitBase):
@@ -51,6 +61,9 @@ class DerivationPath(EmbitBase):
             r += stream.write(idx.to_bytes(4, "little"))
         return r
 
+    def serialized_len(self) -> int:
+        return 4 + 4 * len(self.derivation)
+
     @classmethod
     def read_from(cls, stream):
         fingerprint = stream.read(4)
@@ -397,12 +410,12 @@ class InputScope(PSBTScope):
         r = 0
         if self.non_witness_utxo is not None:
             r += stream.write(b"\x01\x00")
-            r += ser_string(stream, self.non_witness_utxo.serialize())
+            r += ser_value(stream, self.non_witness_utxo)
         if self.witness_utxo is not None:
             r += stream.write(b"\x01\x01")
-            r += ser_string(stream, self.witness_utxo.serialize())
+            r += ser_value(stream, self.witness_utxo)
         for pub in self.partial_sigs:
-            r += ser_string(stream, b"\x02" + pub.serialize())
+            r += ser_key(stream, b"\x02", pub)
             r += ser_string(stream, self.partial_sigs[pub])
         if self.sighash_type is not None:
             r += stream.write(b"\x01\x03")
@@ -414,14 +427,14 @@ class InputScope(PSBTScope):
             r += stream.write(b"\x01\x05")
             r += self.witness_script.write_to(stream)  # script serialization has length
         for pub in self.bip32_derivations:
-            r += ser_string(stream, b"\x06" + pub.serialize())
-            r += ser_string(stream, self.bip32_derivations[pub].serialize())
+            r += ser_key(stream, b"\x06", pub)
+            r += ser_value(stream, self.bip32_derivations[pub])
         if self.final_scriptsig is not None:
             r += stream.write(b"\x01\x07")
             r += self.final_scriptsig.write_to(stream)
         if self.final_scriptwitness is not None:
             r += stream.write(b"\x01\x08")
-            r += ser_string(stream, self.final_scriptwitness.serialize())
+            r += ser_value(stream, self.final_scriptwitness)
 
         if version == 2:
             if self.txid is not None:
@@ -582,8 +595,8 @@ class OutputScope(PSBTScope):
             r += stream.write(b"\x01\x01")
             r += self.witness_script.write_to(stream)  # script serialization has length
         for pub in self.bip32_derivations:
-            r += ser_string(stream, b"\x02" + pub.serialize())
-            r += ser_string(stream, self.bip32_derivations[pub].serialize())
+            r += ser_key(stream, b"\x02", pub)
+            r += ser_value(stream, self.bip32_derivations[pub])
 
         if version == 2:
             if self.value is not None:
@@ -628,6 +641,7 @@ class PSBT(EmbitBase):
 
     def __init__(self, tx=None, unknown={}, version=None):
         self.version = version  # None for v0
+        self._tx = None
         self.inputs = []
         self.outputs = []
         self.tx_version = None
@@ -648,6 +662,9 @@ class PSBT(EmbitBase):
 
     @property
     def tx(self):
+        # cached only while signing
+        if self._tx is not None:
+            return self._tx
         return self.TX_CLS(
             version=self.tx_version or 2,
             locktime=self.locktime or 0,
@@ -695,12 +712,11 @@ class PSBT(EmbitBase):
             # unsigned tx flag
             r += stream.write(b"\x01\x00")
             # write serialized tx
-            tx = self.tx.serialize()
-            r += ser_string(stream, tx)
+            r += ser_value(stream, self.tx)
         # xpubs
         for xpub in self.xpubs:
-            r += ser_string(stream, b"\x01" + xpub.serialize())
-            r += ser_string(stream, self.xpubs[xpub].serialize())
+            r += ser_key(stream, b"\x01", xpub)
+            r += ser_value(stream, self.xpubs[xpub])
 
         if self.version == 2:
             if self.tx_version is not None:
@@ -729,6 +745,13 @@ class PSBT(EmbitBase):
             r += out.write_to(stream, version=self.version)
         return r
 
+    def serialize(self) -> bytes:
+        # length is known in advance, so the buffer is allocated once
+        # instead of growing BytesIO
+        buf = bytearray(self.serialized_len())
+        self.serialize_into(buf)
+        return bytes(buf)
+
     @classmethod
     def from_base64(cls, b64, compress=CompressMode.KEEP_ALL):
         raw = a2b_base64(b64)
@@ -803,6 +826,9 @@ class PSBT(EmbitBase):
         for k in list(self.unknown):
             # xpub field
             if k[0] == 0x01:
+                # bip32 is only needed for global xpubs, import on demand
+                from . import bip32
+
                 xpub = bip32.HDKey.parse(k[1:])
                 self.xpubs[xpub] = DerivationPath.parse(self.unknown.pop(k))
             elif k == b"\x02":
@@ -925,12 +951,21 @@ class PSBT(EmbitBase):
         so if PSBT is asking to sign with a different sighash this function won't sign.
         If you want to sign with sighashes provided in the PSBT - set sighash=None.
         """
+        # unsigned tx doesn't change while we sign,
+        # so all inputs share sighash caches of one tx object
+        self._tx = self.tx
+        try:
+            return self._sign_with(root, sighash)
+        finally:
+            self._tx = None
+
+    def _sign_with(self, root, sighash=SIGHASH.DEFAULT) -> int:
         counter = 0  # sigs counter
         # check if it's a descriptor, and sign with all private keys in this descriptor
         if hasattr(root, "keys"):
             for k in root.keys:
                 if hasattr(k, "is_private") and k.is_private:
-                    counter += self.sign_with(k, sighash)
+                    counter += self._sign_with(k, sighash)
             return counter
 
         # if WIF - fingerprint is None
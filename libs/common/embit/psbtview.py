@@ -20,6 +20,7 @@ from . import ec
 from . import script
 from .script import Script, Witness
 from . import hashes
+from .base import SerializeBuffer
 from .psbt import (
     PSBTError,
     CompressMode,
@@ -27,12 +28,15 @@ from .psbt import (
     OutputScope,
     read_string,
     ser_string,
+    ser_value,
+    ser_key,
     skip_string,
 )
 from .transaction import (
     TransactionOutput,
     TransactionInput,
     SIGHASH,
+    LegacySighash,
     hash_amounts,
     hash_script_pubkeys,
 )
@@ -109,7 +113,7 @@ class GlobalTransactionView:
     def vin0_offset(self):
         if self._vin0_offset is None:
             self._vin0_offset = (
-                self.offset + self.NUM_VIN_OFFSET + len(compact.to_bytes(self.num_vin))
+                self.offset + self.NUM_VIN_OFFSET + compact.size(self.num_vin)
             )
         return self._vin0_offset
 
@@ -119,7 +123,7 @@ class GlobalTransactionView:
             self._vout0_offset = (
                 self.vin0_offset
                 + self.LEN_VIN * self.num_vin
-                + len(compact.to_bytes(self.num_vout))
+                + compact.size(self.num_vout)
             )
         return self._vout0_offset
 
@@ -204,6 +208,7 @@ class PSBTView:
         self._hash_outputs = None
         self._hash_amounts = None
         self._hash_script_pubkeys = None
+        self._legacy = None
 
     @classmethod
     def view(cls, stream, offset=None, compress=CompressMode.KEEP_ALL):
@@ -224,13 +229,13 @@ class PSBTView:
         while True:
             # read key and update cursor
             key = read_string(stream)
-            cur += len(key) + len(compact.to_bytes(len(key)))
+            cur += len(key) + compact.size(len(key))
             # separator
             if len(key) == 0:
                 break
             if key in [b"\xfb", b"\x04", b"\x05"]:
                 value = read_string(stream)
-                cur += len(value) + len(compact.to_bytes(len(value)))
+                cur += len(value) + compact.size(len(value))
                 if key == b"\xfb":
                     version = int.from_bytes(value, "little")
                 elif key == b"\x04":
@@ -242,7 +247,7 @@ class PSBTView:
                 assert version != 2
                 assert (num_inputs is None) and (num_outputs is None)
                 tx_len = compact.read_from(stream)
-                cur += len(compact.to_bytes(tx_len))
+                cur += compact.size(tx_len)
                 tx_offset = cur
                 tx = cls.TX_CLS(stream, tx_offset)
                 num_inputs = tx.num_vin
@@ -387,7 +392,7 @@ class PSBTView:
             off = self.offset + len(self.MAGIC)
         while True:
             key = read_string(self.stream)
-            off += len(key) + len(compact.to_bytes(len(key)))
+            off += len(key) + compact.size(len(key))
             # separator - not found
             if len(key) == 0:
                 return None
@@ -424,9 +429,10 @@ class PSBTView:
     def hash_outputs(self):
         if self._hash_outputs is None:
             h = hashlib.sha256()
+            buf = SerializeBuffer()
             for i in range(self.num_outputs):
                 out = self.vout(i)
-                h.update(out.serialize())
+                h.update(buf.serialize(out))
             self._hash_outputs = h.digest()
         return self._hash_outputs
 
@@ -547,21 +553,35 @@ class PSBTView:
         # no corresponding output for this input, we sign 00...01
         if sh == SIGHASH.SINGLE and input_index >= self.num_outputs:
             return b"\x00" * 31 + b"\x01"
+        # inputs with empty scripts are kept in memory, 41 bytes per input
+        if sh == SIGHASH.ALL and not anyonecanpay:
+            if self._legacy is None:
+                self._legacy = LegacySighash(
+                    self.tx_version,
+                    (self.vin(i) for i in range(self.num_inputs)),
+                    (self.vout(i) for i in range(self.num_outputs)),
+                    self.locktime,
+                )
+            return self._legacy.sighash(
+                input_index, self.vin(input_index), script_pubkey, sighash
+            )
 
         h = hashlib.sha256()
+        buf = SerializeBuffer()
         h.update(self.tx_version.to_bytes(4, "little"))
         # ANYONECANPAY - only one input is serialized
         if anyonecanpay:
             h.update(compact.to_bytes(1))
-            h.update(self.vin(input_index).serialize(script_pubkey))
+            h.update(buf.serialize(self.vin(input_index), script_pubkey))
         else:
             h.update(compact.to_bytes(self.num_inputs))
+            empty = Script(b"")
             for i in range(self.num_inputs):
                 inp = self.vin(i)
                 if input_index == i:
-                    h.update(inp.serialize(script_pubkey))
+                    h.update(buf.serialize(inp, script_pubkey))
                 else:
-                    h.update(inp.serialize(Script(b""), sighash))
+                    h.update(buf.serialize(inp, empty, sighash))
         # no outputs
         if sh == SIGHASH.NONE:
             h.update(compact.to_bytes(0))
@@ -578,7 +598,7 @@ class PSBTView:
             h.update(compact.to_bytes(self.num_outputs))
             for i in range(self.num_outputs):
                 out = self.vout(i)
-                h.update(out.serialize())
+                h.update(buf.serialize(out))
         else:
             # shouldn't happen
             raise PSBTError("Invalid sighash")
@@ -634,14 +654,26 @@ class PSBTView:
         input_index: int,
         inp=None,
         sighash=SIGHASH.DEFAULT,
+        taptree=None,
     ) -> int:
-        """Sign taproot input with key. Signs with internal or leaf key."""
+        """
+        Sign taproot input with key. Signs with internal or leaf key.
+        taptree is a derived descriptor TapTree of this input. Its merkle root
+        and leaf hashes are cached, so it can be reused for all inputs
+        with the same derivation.
+        """
         # get input ourselves if not provided
         inp = inp or self.input(input_index)
         if not inp.is_taproot:
             return 0
+        if taptree is not None:
+            merkle_root = taptree.tweak()
+            leaf_hashes = taptree.leaf_hashes()
+        else:
+            merkle_root = inp.taproot_merkle_root or b""
+            leaf_hashes = {}
         # check if key is internal key
-        pk = key.taproot_tweak(inp.taproot_merkle_root or b"")
+        pk = key.taproot_tweak(merkle_root)
         if pk.xonly() in inp.utxo.script_pubkey.data:
             h = self.sighash(
                 input_index,
@@ -672,7 +704,7 @@ class PSBTView:
                 leaf_version=leaf_version,
             )
             sig = key.schnorr_sign(h)
-            leaf = hashes.tagged_hash(
+            leaf = leaf_hashes.get(sc) or hashes.tagged_hash(
                 "TapLeaf", bytes([leaf_version]) + script.serialize()
             )
             sigdata = sig.serialize()
@@ -684,7 +716,13 @@ class PSBTView:
         return counter
 
     def sign_input(
-        self, i, root, sig_stream, sighash=SIGHASH.DEFAULT, extra_scope_data=None
+        self,
+        i,
+        root,
+        sig_stream,
+        sighash=SIGHASH.DEFAULT,
+        extra_scope_data=None,
+        taptree=None,
     ) -> int:
         """
         Signs input taking into account additional
@@ -693,6 +731,8 @@ class PSBTView:
         It's helpful if your wallet knows more than provided in PSBT.
         As PSBTView is read-only it can't change anything in PSBT,
         that's why you may need extra_scope_data.
+        For taproot inputs taptree can be a derived descriptor TapTree,
+        see sign_input_with_tapkey.
         """
         if i < 0 or i >= self.num_inputs:
             raise PSBTError("Invalid input number")
@@ -785,6 +825,7 @@ class PSBTView:
                 i,
                 inp,
                 sighash=inp_sighash,
+                taptree=taptree,
             )
             # sign with all derived keys
             for prv, pub in derived_keypairs:
@@ -793,10 +834,11 @@ class PSBTView:
                     i,
                     inp,
                     sighash=inp_sighash,
+                    taptree=taptree,
                 )
             if inp.final_scriptwitness:
                 ser_string(sig_stream, b"\x08")
-                ser_string(sig_stream, inp.final_scriptwitness.serialize())
+                ser_value(sig_stream, inp.final_scriptwitness)
 
             for pub, leaf in inp.taproot_sigs:
                 ser_string(sig_stream, b"\x14" + pub.xonly() + leaf)
@@ -818,7 +860,7 @@ class PSBTView:
             inp.partial_sigs[pub] = sig.serialize() + bytes([inp_sighash])
             counter += 1
         for pub in inp.partial_sigs:
-            ser_string(sig_stream, b"\x02" + pub.serialize())
+            ser_key(sig_stream, b"\x02", pub)
             ser_string(sig_stream, inp.partial_sigs[pub])
         return counter
 
@@ -65,6 +65,20 @@ class Script(EmbitBase):
         res += stream.write(self.data)
         return res
 
+    def serialize(self):
+        return compact.to_bytes(len(self.data)) + self.data
+
+    def serialized_len(self):
+        return compact.size(len(self.data)) + len(self.data)
+
+    def serialize_into(self, buf, offset=0):
+        l = compact.to_bytes(len(self.data))
+        mv = memoryview(buf)
+        mv[offset : offset + len(l)] = l
+        offset += len(l)
+        mv[offset : offset + len(self.data)] = self.data
+        return len(l) + len(self.data)
+
     @classmethod
     def read_from(cls, stream):
         l = compact.read_from(stream)
@@ -104,6 +118,12 @@ class Witness(EmbitBase):
             res += stream.write(item)
         return res
 
+    def serialized_len(self):
+        res = compact.size(len(self.items))
+        for item in self.items:
+            res += compact.size(len(item)) + len(item)
+        return res
+
     @classmethod
     def read_from(cls, stream):
         num = compact.read_from(stream)
@@ -2,7 +2,16 @@ import hmac
 import hashlib
 from .bip39 import mnemonic_from_bytes, mnemonic_to_bytes
 from .misc import secure_randint
-from .wordlists.slip39 import SLIP39_WORDS
+from .wordlists.base import LazyWordlist
+
+
+def _load_wordlist():
+    from .wordlists.slip39 import SLIP39_WORDS
+
+    return SLIP39_WORDS
+
+
+SLIP39_WORDS = LazyWordlist(_load_wordlist)
 
 
 # functions for SLIP39 checksum
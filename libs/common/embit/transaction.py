@@ -1,7 +1,7 @@
 import hashlib
 from . import compact
 from . import hashes
-from .base import EmbitBase, EmbitError
+from .base import EmbitBase, EmbitError, SerializeBuffer
 from .script import Script, Witness
 from .misc import const
 
@@ -42,11 +42,71 @@ def hash_amounts(amounts):
 
 def hash_script_pubkeys(script_pubkeys):
     h = hashlib.sha256()
+    buf = SerializeBuffer()
     for sc in script_pubkeys:
-        h.update(sc.serialize())
+        h.update(buf.serialize(sc))
     return h.digest()
 
 
+class LegacySighash:
+    """
+    Legacy sighash for SIGHASH.ALL without re-serializing
+    the whole transaction for every input.
+    Inputs with empty scripts are serialized once into a single buffer,
+    outputs and locktime - into a cached suffix.
+    SHA-256 midstate over version and inputs before the current one
+    moves forward, so signing inputs in order hashes the prefix only once.
+    vin and vout can be any iterables, i.e. generators reading from a stream.
+    """
+
+    def __init__(self, version, vin, vout, locktime):
+        empty = Script(b"")
+        buf = SerializeBuffer()
+        inputs = bytearray()
+        # offsets of inputs in the buffer
+        offsets = [0]
+        for inp in vin:
+            inputs += buf.serialize(inp, empty)
+            offsets.append(len(inputs))
+        outputs = bytearray()
+        num_vout = 0
+        for out in vout:
+            outputs += buf.serialize(out)
+            num_vout += 1
+        self._buf = buf
+        self._inputs = inputs
+        self._offsets = offsets
+        self._suffix = (
+            compact.to_bytes(num_vout) + outputs + locktime.to_bytes(4, "little")
+        )
+        self._start = hashlib.sha256(
+            version.to_bytes(4, "little") + compact.to_bytes(len(offsets) - 1)
+        )
+        # midstate covers all inputs before self._idx
+        self._h = self._start.copy()
+        self._idx = 0
+
+    def sighash(self, input_index, inp, script_pubkey, sighash=SIGHASH.ALL):
+        """inp is the input being signed, script_pubkey replaces its script_sig"""
+        off = self._offsets
+        if input_index < 0 or input_index >= len(off) - 1:
+            raise TransactionError("Invalid input index")
+        mv = memoryview(self._inputs)
+        # going back - start over
+        if input_index < self._idx:
+            self._h = self._start.copy()
+            self._idx = 0
+        if input_index > self._idx:
+            self._h.update(mv[off[self._idx] : off[input_index]])
+            self._idx = input_index
+        h = self._h.copy()
+        h.update(self._buf.serialize(inp, script_pubkey))
+        h.update(mv[off[input_index + 1] :])
+        h.update(self._suffix)
+        h.update(sighash.to_bytes(4, "little"))
+        return hashlib.sha256(h.digest()).digest()
+
+
 # API similar to bitcoin-cli decoderawtransaction
 
 
@@ -65,6 +125,7 @@ class Transaction(EmbitBase):
         self._hash_outputs = None
         self._hash_amounts = None
         self._hash_script_pubkeys = None
+        self._legacy = None
 
     @property
     def is_segwit(self):
@@ -77,7 +138,8 @@ class Transaction(EmbitBase):
     def write_to(self, stream):
         """Returns the byte serialization of the transaction"""
         res = stream.write(self.version.to_bytes(4, "little"))
-        if self.is_segwit:
+        is_segwit = self.is_segwit
+        if is_segwit:
             res += stream.write(b"\x00\x01")  # segwit marker and flag
         res += stream.write(compact.to_bytes(len(self.vin)))
         for inp in self.vin:
@@ -85,7 +147,7 @@ class Transaction(EmbitBase):
         res += stream.write(compact.to_bytes(len(self.vout)))
         for out in self.vout:
             res += out.write_to(stream)
-        if self.is_segwit:
+        if is_segwit:
             for inp in self.vin:
                 res += inp.witness.write_to(stream)
         res += stream.write(self.locktime.to_bytes(4, "little"))
@@ -93,13 +155,14 @@ class Transaction(EmbitBase):
 
     def hash(self):
         h = hashlib.sha256()
+        buf = SerializeBuffer()
         h.update(self.version.to_bytes(4, "little"))
         h.update(compact.to_bytes(len(self.vin)))
         for inp in self.vin:
-            h.update(inp.serialize())
+            h.update(buf.serialize(inp))
         h.update(compact.to_bytes(len(self.vout)))
         for out in self.vout:
-            h.update(out.serialize())
+            h.update(buf.serialize(out))
         h.update(self.locktime.to_bytes(4, "little"))
         hsh = hashlib.sha256(h.digest()).digest()
         return hsh
@@ -121,9 +184,10 @@ class Transaction(EmbitBase):
                 raise TransactionError("Invalid segwit marker")
             num_vin = compact.read_from(stream)
         h.update(compact.to_bytes(num_vin))
+        buf = SerializeBuffer()
         for i in range(num_vin):
             txin = TransactionInput.read_from(stream)
-            h.update(txin.serialize())
+            h.update(buf.serialize(txin))
         num_vout = compact.read_from(stream)
         h.update(compact.to_bytes(num_vout))
         if idx >= num_vout or idx < 0:
@@ -135,7 +199,7 @@ class Transaction(EmbitBase):
             vout = TransactionOutput.read_from(stream)
             if idx == i:
                 res = vout
-            h.update(vout.serialize())
+            h.update(buf.serialize(vout))
         if is_segwit:
             for i in range(num_vin):
                 Witness.read_from(stream)
@@ -186,8 +250,9 @@ class Transaction(EmbitBase):
     def hash_outputs(self):
         if self._hash_outputs is None:
             h = hashlib.sha256()
+            buf = SerializeBuffer()
             for out in self.vout:
-                h.update(out.serialize())
+                h.update(buf.serialize(out))
             self._hash_outputs = h.digest()
         return self._hash_outputs
 
@@ -305,20 +370,31 @@ class Transaction(EmbitBase):
         # no corresponding output for this input, we sign 00...01
         if sh == SIGHASH.SINGLE and input_index >= len(self.vout):
             return b"\x00" * 31 + b"\x01"
+        # the most common case, inputs share prefix and suffix
+        if sh == SIGHASH.ALL and not anyonecanpay:
+            if self._legacy is None:
+                self._legacy = LegacySighash(
+                    self.version, self.vin, self.vout, self.locktime
+                )
+            return self._legacy.sighash(
+                input_index, self.vin[input_index], script_pubkey, sighash
+            )
 
         h = hashlib.sha256()
+        buf = SerializeBuffer()
         h.update(self.version.to_bytes(4, "little"))
         # ANYONECANPAY - only one input is serialized
         if anyonecanpay:
             h.update(compact.to_bytes(1))
-            h.update(self.vin[input_index].serialize(script_pubkey))
+            h.update(buf.serialize(self.vin[input_index], script_pubkey))
         else:
             h.update(compact.to_bytes(len(self.vin)))
+            empty = Script(b"")
             for i, inp in enumerate(self.vin):
                 if input_index == i:
-                    h.update(inp.serialize(script_pubkey))
+                    h.update(buf.serialize(inp, script_pubkey))
                 else:
-                    h.update(inp.serialize(Script(b""), sighash))
+                    h.update(buf.serialize(inp, empty, sighash))
         # no outputs
         if sh == SIGHASH.NONE:
             h.update(compact.to_bytes(0))
@@ -334,7 +410,7 @@ class Transaction(EmbitBase):
         elif sh == SIGHASH.ALL:
             h.update(compact.to_bytes(len(self.vout)))
             for out in self.vout:
-                h.update(out.serialize())
+                h.update(buf.serialize(out))
         else:
             # shouldn't happen
             raise TransactionError("Invalid sighash")
@@ -357,7 +433,8 @@ class TransactionInput(EmbitBase):
 
     @property
     def is_segwit(self):
-        return not (self.witness.serialize() == b"\x00")
+        # empty witness is a single zero byte
+        return self.witness.serialized_len() != 1
 
     def write_to(self, stream, script_sig=None, sighash=SIGHASH.ALL):
         sh, anyonecanpay = SIGHASH.check(sighash)
@@ -368,12 +445,17 @@ class TransactionInput(EmbitBase):
         res = stream.write(bytes(reversed(self.txid)))
         res += stream.write(self.vout.to_bytes(4, "little"))
         if script_sig is None:
-            res += stream.write(self.script_sig.serialize())
-        else:
-            res += stream.write(script_sig.serialize())
+            script_sig = self.script_sig
+        res += script_sig.write_to(stream)
         res += stream.write(sequence.to_bytes(4, "little"))
         return res
 
+    def serialized_len(self, script_sig=None, sighash=SIGHASH.ALL):
+        if script_sig is None:
+            script_sig = self.script_sig
+        # txid, vout, script_sig, sequence
+        return 40 + script_sig.serialized_len()
+
     @classmethod
     def read_from(cls, stream):
         txid = bytes(reversed(stream.read(32)))
@@ -390,9 +472,12 @@ class TransactionOutput(EmbitBase):
 
     def write_to(self, stream):
         res = stream.write(self.value.to_bytes(8, "little"))
-        res += stream.write(self.script_pubkey.serialize())
+        res += self.script_pubkey.write_to(stream)
         return res
 
+    def serialized_len(self):
+        return 8 + self.script_pubkey.serialized_len()
+
     @classmethod
     def read_from(cls, stream):
         value = int.from_bytes(stream.read(8), "little")
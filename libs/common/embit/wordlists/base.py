@@ -31,3 +31,36 @@ class WordlistBase:
 
     def __contains__(self, word):
         return self._mod.index(word) >= 0
+
+
+class LazyWordlist:
+    """
+    Wordlist that is imported on first use.
+    Keeps a large list of strings out of the heap
+    until mnemonic functions are actually called.
+    """
+
+    def __init__(self, loader):
+        self._loader = loader
+        self._words = None
+
+    @property
+    def words(self):
+        if self._words is None:
+            self._words = self._loader()
+        return self._words
+
+    def __getitem__(self, n):
+        return self.words[n]
+
+    def __len__(self):
+        return len(self.words)
+
+    def __iter__(self):
+        return iter(self.words)
+
+    def __contains__(self, word):
+        return word in self.words
+
+    def index(self, word):
+        return self.words.index(word)
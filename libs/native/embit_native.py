@@ -0,0 +1,238 @@
+"""
+Native versions of embit and microur hot loops.
+
+Frozen only by the native build profiles (manifests/disco_native.py),
+where mpy-cross compiles them to machine code. Functions are copies of
+the pure-Python ones with @micropython.native / @micropython.viper
+annotations, install() replaces the originals in their modules:
+
+    import embit_native
+    embit_native.install()
+
+The native firmware calls it at boot from native_boot.py, the originals
+stay available in `originals`. Without this module everything keeps
+working as plain bytecode.
+"""
+import micropython
+import binascii
+from binascii import crc32
+
+# bech32 and slip39 checksums fit into 30 bits,
+# so viper can keep them in machine words
+
+
+@micropython.viper
+def bech32_polymod(values) -> int:
+    chk = 1
+    for value in values:
+        top = chk >> 25
+        chk = ((chk & 0x1FFFFFF) << 5) ^ int(value)
+        if top & 1:
+            chk ^= 0x3B6A57B2
+        if top & 2:
+            chk ^= 0x26508E6D
+        if top & 4:
+            chk ^= 0x1EA119FA
+        if top & 8:
+            chk ^= 0x3D4233DD
+        if top & 16:
+            chk ^= 0x2A1462B3
+    return chk
+
+
+@micropython.viper
+def rs1024_polymod(values) -> int:
+    chk = 1
+    for v in values:
+        b = chk >> 20
+        chk = ((chk & 0xFFFFF) << 10) ^ int(v)
+        if b & 1:
+            chk ^= 0xE0E040
+        if b & 2:
+            chk ^= 0x1C1C080
+        if b & 4:
+            chk ^= 0x3838100
+        if b & 8:
+            chk ^= 0x7070200
+        if b & 16:
+            chk ^= 0xE0E0009
+        if b & 32:
+            chk ^= 0x1C0C2412
+        if b & 64:
+            chk ^= 0x38086C24
+        if b & 128:
+            chk ^= 0x3090FC48
+        if b & 256:
+            chk ^= 0x21B1F890
+        if b & 512:
+            chk ^= 0x3F3F120
+    return chk
+
+
+B58_DIGITS = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz"
+
+
+@micropython.native
+def base58_encode(b):
+    n = int("0x0" + binascii.hexlify(b).decode("utf8"), 16)
+    chars = []
+    while n > 0:
+        n, r = divmod(n, 58)
+        chars.append(B58_DIGITS[r])
+    result = "".join(chars[::-1])
+    pad = 0
+    for c in b:
+        if c == 0:
+            pad += 1
+        else:
+            break
+    return B58_DIGITS[0] * pad + result
+
+
+@micropython.native
+def base58_decode(s):
+    if not s:
+        return b""
+    n = 0
+    for c in s:
+        n *= 58
+        digit = B58_DIGITS.find(c)
+        if digit < 0:
+            raise ValueError("Character %r is not a valid base58 character" % c)
+        n += digit
+    h = "%x" % n
+    if len(h) % 2:
+        h = "0" + h
+    res = binascii.unhexlify(h.encode("utf8"))
+    pad = 0
+    for c in s[:-1]:
+        if c == B58_DIGITS[0]:
+            pad += 1
+        else:
+            break
+    return b"\x00" * pad + res
+
+
+MAX_UINT64 = 0xFFFFFFFFFFFFFFFF
+
+
+@micropython.native
+def _rotl(x, k):
+    return ((x << k) | (x >> (64 - k))) & MAX_UINT64
+
+
+# 64-bit state doesn't fit into viper integers, native only saves
+# the interpreter overhead here
+@micropython.native
+def xoshiro_next(self):
+    s = self.s
+    result = (_rotl((s[1] * 5) & MAX_UINT64, 7) * 9) & MAX_UINT64
+    t = (s[1] << 17) & MAX_UINT64
+    s[2] ^= s[0]
+    s[3] ^= s[1]
+    s[1] ^= s[2]
+    s[0] ^= s[3]
+    s[2] ^= t
+    s[3] = _rotl(s[3], 45)
+    return result
+
+
+@micropython.native
+def bytewords_stream_encode(fin, data_len, fout):
+    from microur.util.bytewords import LOOKUP_TABLE, ALPHABET_LEN
+
+    written = 0
+    out = bytearray(2)
+    while data_len > 0:
+        b = fin.read(1)
+        if not b:
+            return written
+        idx = LOOKUP_TABLE.index(b[0])
+        out[0] = idx % ALPHABET_LEN + 65
+        out[1] = idx // ALPHABET_LEN + 65
+        written += fout.write(out)
+        data_len -= 1
+    return written
+
+
+@micropython.native
+def bytewords_stream_decode(fin, fout, maxread=0, crc=0):
+    from microur.util.bytewords import LOOKUP_TABLE, ALPHABET_LEN, stream_pos
+
+    if maxread <= 0:
+        cur, sz = stream_pos(fin)
+        maxread = sz - cur + maxread
+    assert maxread % 2 == 0
+    maxlen = maxread // 2
+    assert maxlen > 0
+    buf = bytearray(2)
+    chunk = bytearray(1)
+    written = 0
+    l = fin.readinto(buf)
+    while l > 0:
+        assert l % 2 == 0
+        # ord('A') = 65, ord('a') = 97
+        c1 = buf[0] - 65 if buf[0] < 97 else buf[0] - 97
+        c2 = buf[1] - 65 if buf[1] < 97 else buf[1] - 97
+        chunk[0] = LOOKUP_TABLE[c2 * ALPHABET_LEN + c1]
+        crc = crc32(chunk, crc)
+        written += fout.write(chunk)
+        if maxlen == written:
+            return written, crc
+        l = fin.readinto(buf)
+    raise ValueError("End reached")
+
+
+@micropython.native
+def slip39_interpolate(cls, x, share_data):
+    exp = cls.exp
+    log2 = cls.log2
+    log_product = 0
+    for share_x, _ in share_data:
+        log_product += log2[share_x ^ x]
+    result = bytearray(len(share_data[0][1]))
+    for share_x, share_bytes in share_data:
+        log_numerator = log_product - log2[share_x ^ x]
+        log_denominator = 0
+        for other_x, _ in share_data:
+            log_denominator += log2[share_x ^ other_x]
+        log = (log_numerator - log_denominator) % 255
+        for i in range(len(result)):
+            y = share_bytes[i]
+            if y > 0:
+                result[i] ^= exp[(log2[y] + log) % 255]
+    return bytes(result)
+
+
+# pure-Python functions replaced by install(), by name of the native one
+originals = {}
+
+
+def install():
+    """Replaces pure-Python hot functions with native ones"""
+    from embit import base58, bech32, slip39
+    from microur.util import bytewords, xoshiro256
+
+    # installed already, e.g. by native_boot.py
+    if originals:
+        return
+    originals.update(
+        {
+            "bech32_polymod": bech32.bech32_polymod,
+            "rs1024_polymod": slip39.rs1024_polymod,
+            "slip39_interpolate": slip39.ShareSet.interpolate,
+            "base58_encode": base58.encode,
+            "base58_decode": base58.decode,
+            "xoshiro_next": xoshiro256.Xoshiro256.next,
+            "bytewords_stream_encode": bytewords.stream_encode,
+            "bytewords_stream_decode": bytewords.stream_decode,
+        }
+    )
+    bech32.bech32_polymod = bech32_polymod
+    slip39.rs1024_polymod = rs1024_polymod
+    slip39.ShareSet.interpolate = classmethod(slip39_interpolate)
+    base58.encode = base58_encode
+    base58.decode = base58_decode
+    xoshiro256.Xoshiro256.next = xoshiro_next
+    bytewords.stream_encode = bytewords_stream_encode
+    bytewords.stream_decode = bytewords_stream_decode
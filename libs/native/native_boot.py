@@ -0,0 +1,6 @@
+# Frozen boot code of the native build profile, runs before boot.py
+# (MICROPY_BOARD_FROZEN_BOOT_FILE, set by `make disco-native`)
+import embit_native
+
+embit_native.install()
+del embit_native
@@ -0,0 +1,255 @@
+"""
+This module simulates sdram module available on hardware.
+RAMDevice and arena regions are backed by an anonymous mmap outside
+of GC heap, GC heap functions only track the state as unix port
+has a single heap.
+"""
+
+SDRAM_START = 0xC03EE000
+SDRAM_END = 0xC1000000
+HEAP_MIN_SIZE = 0x1000
+ARENA_SIZE = 0x100000
+ARENA_ALIGN = 32
+ARENA_MAX_REGIONS = 16
+ARENA_NAME_LEN = 32
+
+_heap_size = 0
+_heap_first = False
+_ramdevice_end = SDRAM_START
+_arena = None
+# memory of all RAMDevice instances, same SDRAM on hardware
+_ramdevice_mem = None
+# [name, offset, size], name is None for a free block
+_regions = []
+_arena_top = 0
+
+
+def init():
+    pass
+
+
+def add_heap(size):
+    global _heap_size
+    if _heap_size > 0:
+        raise ValueError("SDRAM heap is already added")
+    size = (size + HEAP_MIN_SIZE - 1) & ~(HEAP_MIN_SIZE - 1)
+    if size < HEAP_MIN_SIZE or size > SDRAM_END - _ramdevice_end:
+        raise ValueError("Invalid heap size")
+    _heap_size = size
+    return size
+
+
+def heap_first(*args):
+    global _heap_first
+    prev = _heap_first
+    if args:
+        first = bool(args[0])
+        if first and _heap_size == 0:
+            raise ValueError("SDRAM heap is not added")
+        _heap_first = first
+    return prev
+
+
+def heap_info():
+    if _heap_size == 0:
+        return None
+    return (SDRAM_END - _heap_size, _heap_size)
+
+
+def _mmap(size):
+    """Anonymous mmap outside of GC heap, None if not available"""
+    try:
+        import ffi
+        import uctypes
+
+        libc = ffi.open("libc.so.6")
+        # signed return type, "p" would turn MAP_FAILED into 2**64-1
+        mmap = libc.func("l", "mmap", "pLiiil")
+        # PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS
+        ptr = mmap(None, size, 3, 0x22, -1, 0)
+        if ptr in (0, -1):
+            return None
+        return uctypes.bytearray_at(ptr, size)
+    except (ImportError, OSError):
+        return None
+
+
+def _arena_mem():
+    global _arena
+    if _arena is None:
+        _arena = _mmap(ARENA_SIZE)
+        if _arena is None:
+            # no ffi or not linux, fall back to a plain buffer
+            _arena = bytearray(ARENA_SIZE)
+    return _arena
+
+
+def _ramdevice_view():
+    """Memoryview of the whole RAMDevice area, mapped once, or None"""
+    global _ramdevice_mem
+    if _ramdevice_mem is None:
+        # pages of anonymous mmap are allocated by the kernel on first write
+        mem = _mmap(SDRAM_END - SDRAM_START)
+        _ramdevice_mem = False if mem is None else memoryview(mem)
+    return _ramdevice_mem or None
+
+
+def _check_name(name):
+    # same limits as fixed-size names in usermods/sdram
+    if not name or len(name) >= ARENA_NAME_LEN or "\x00" in name:
+        raise ValueError("Invalid region name")
+
+
+def _find(name):
+    _check_name(name)
+    for r in _regions:
+        if r[0] == name:
+            return r
+
+
+def _view(region, size):
+    return memoryview(_arena_mem())[region[1] : region[1] + size]
+
+
+def _coalesce():
+    global _arena_top
+    changed = True
+    while changed:
+        changed = False
+        for a in _regions:
+            if a[0] is not None:
+                continue
+            if a[1] + a[2] == _arena_top:
+                _arena_top = a[1]
+                _regions.remove(a)
+                changed = True
+                break
+            for b in _regions:
+                if b[0] is None and a[1] + a[2] == b[1]:
+                    a[2] += b[2]
+                    _regions.remove(b)
+                    changed = True
+                    break
+            if changed:
+                break
+
+
+def alloc(name, size):
+    global _arena_top
+    if size <= 0:
+        raise ValueError("Invalid size")
+    r = _find(name)
+    if r is not None:
+        if size > r[2]:
+            raise ValueError("Region exists and is smaller")
+        return _view(r, size)
+    aligned = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1)
+    for r in _regions:
+        if r[0] is not None or r[2] < aligned:
+            continue
+        if r[2] > aligned and len(_regions) < ARENA_MAX_REGIONS:
+            _regions.append([None, r[1] + aligned, r[2] - aligned])
+            r[2] = aligned
+        r[0] = name
+        return _view(r, size)
+    if aligned > ARENA_SIZE - _arena_top:
+        raise MemoryError("SDRAM arena is full")
+    if len(_regions) == ARENA_MAX_REGIONS:
+        raise MemoryError("Too many SDRAM regions")
+    r = [name, _arena_top, aligned]
+    _regions.append(r)
+    _arena_top += aligned
+    return _view(r, size)
+
+
+def free(name):
+    r = _find(name)
+    if r is None:
+        raise ValueError("Region not found")
+    r[0] = None
+    _coalesce()
+
+
+def arena_stats():
+    used = sum(r[2] for r in _regions if r[0] is not None)
+    largest = ARENA_SIZE - _arena_top
+    for r in _regions:
+        if r[0] is None and r[2] > largest:
+            largest = r[2]
+    return {
+        "size": ARENA_SIZE,
+        "used": used,
+        "free": ARENA_SIZE - used,
+        "largest_free": largest,
+        "regions": len([r for r in _regions if r[0] is not None]),
+    }
+
+
+def arena_reset():
+    global _arena_top
+    _regions.clear()
+    _arena_top = 0
+
+
+class RAMDevice:
+    def __init__(self, block_size=512):
+        global _ramdevice_end
+        self.block_size = block_size
+        self.len = SDRAM_END - _heap_size - SDRAM_START
+        self.len -= self.len % block_size
+        _ramdevice_end = max(_ramdevice_end, SDRAM_START + self.len)
+        # instances share the memory like on hardware,
+        # so creating one doesn't map another 12 MB.
+        # Without ffi only written blocks are kept in a dict
+        mem = _ramdevice_view()
+        self._mem = None if mem is None else mem[: self.len]
+        self._blocks = {}
+
+    def _pos(self, block_num, buf, offset):
+        pos = block_num * self.block_size + offset
+        if block_num < 0 or offset < 0 or pos + len(buf) > self.len:
+            raise ValueError("Outer space...")
+        return pos
+
+    def readblocks(self, block_num, buf, offset=0):
+        pos = self._pos(block_num, buf, offset)
+        if self._mem is not None:
+            buf[:] = self._mem[pos : pos + len(buf)]
+            return
+        bs = self.block_size
+        i = 0
+        while i < len(buf):
+            block, off = divmod(pos + i, bs)
+            n = min(bs - off, len(buf) - i)
+            data = self._blocks.get(block)
+            buf[i : i + n] = data[off : off + n] if data else bytes(n)
+            i += n
+
+    def writeblocks(self, block_num, buf, offset=0):
+        pos = self._pos(block_num, buf, offset)
+        if self._mem is not None:
+            self._mem[pos : pos + len(buf)] = buf
+            return
+        bs = self.block_size
+        i = 0
+        while i < len(buf):
+            block, off = divmod(pos + i, bs)
+            n = min(bs - off, len(buf) - i)
+            data = self._blocks.get(block)
+            if data is None:
+                data = bytearray(bs)
+                self._blocks[block] = data
+            data[off : off + n] = buf[i : i + n]
+            i += n
+
+    def ioctl(self, op, arg):
+        if op in (1, 2, 3):  # init, deinit, sync
+            return 0
+        if op == 4:
+            return self.len // self.block_size
+        if op == 5:
+            return self.block_size
+        if op == 6:  # erase, RAM doesn't need it
+            if arg < 0 or arg >= self.len // self.block_size:
+                return -22  # EINVAL
+            return 0
@@ -1,8 +1,22 @@
 import socket
+import io
+
+# stream ioctl requests and poll flags, see py/stream.h
+_MP_STREAM_POLL = 3
+_MP_STREAM_GET_FILENO = 10
+_POLLIN = 0x0001
+_POLLOUT = 0x0004
+
 
 # mimics API of pyb.USB_VCP / pyb.UART etc
-class TCPHost:
-    def __init__(self, port=8789):
+# Received data is kept in a fixed ring buffer, socket is not read
+# while the buffer is full so TCP flow control slows down the sender.
+# Implements stream ioctl, so it can be registered in select.poll
+# and awaited by asyncio instead of polling any() in a loop.
+# With fd-based poll only new data on the socket wakes the poller,
+# so check any() before waiting for more.
+class TCPHost(io.IOBase):
+    def __init__(self, port=8789, rxbuf=32768):
         self.port = port
         self.socket = socket.socket()
         ai = socket.getaddrinfo("0.0.0.0", port)
@@ -12,7 +26,11 @@ class TCPHost:
         self.socket.listen(5)
         self.socket.setblocking(False)
         self.client = None
-        self.buf = b""
+        self._buf = bytearray(rxbuf)
+        self._mv = memoryview(self._buf)
+        # ring buffer state: index of the first byte and number of bytes
+        self._start = 0
+        self._len = 0
         self._check()
 
     def isconnected(self):
@@ -21,27 +39,43 @@ class TCPHost:
 
     def any(self):
         self._check()
-        return len(self.buf)
+        return self._len
 
-    # `last` argument is used to avoid circular recursion
-    def _check(self, last=False):
-        if self.client is not None:
-            # check if EAGAIN on recv - still connected
-            # if b'' is returned on read - disconnected
+    def _disconnect(self):
+        self.client.close()
+        self.client = None
+
+    # reads from the socket into free space of the ring buffer,
+    # returns False if the client has disconnected
+    def _fill(self):
+        size = len(self._buf)
+        while self._len < size:
+            end = (self._start + self._len) % size
+            n = min(size - self._len, size - end)
             try:
-                # large enough to read all
-                b = self.client.recv(10000)
-                if len(b) == 0:
-                    self.client.close()
-                    self.client = None
-                    # try to check connections if this one is dead
-                    if not last:
-                        self._check()
-                else:
-                    self.buf += b
+                r = self.client.readinto(self._mv[end : end + n])
             except OSError as e:
-                if "EAGAIN" not in str(e) and "ECONNRESET" not in str(e):
+                if "ECONNRESET" not in str(e):
                     raise e
+                return True
+            # None means EAGAIN - nothing to read yet
+            if r is None:
+                return True
+            if r == 0:
+                return False
+            self._len += r
+            if r < n:
+                return True
+        return True
+
+    # `last` argument is used to avoid circular recursion
+    def _check(self, last=False):
+        if self.client is not None:
+            if not self._fill():
+                self._disconnect()
+                # try to check connections if this one is dead
+                if not last:
+                    self._check()
         else:
             # check if got connected
             try:
@@ -53,27 +87,37 @@ class TCPHost:
                 if "EAGAIN" not in str(e):
                     raise e
 
+    # moves up to len(mv) bytes from the ring buffer to mv
+    def _pop(self, mv):
+        size = len(self._buf)
+        n = min(len(mv), self._len)
+        first = min(n, size - self._start)
+        mv[:first] = self._mv[self._start : self._start + first]
+        if n > first:
+            mv[first:n] = self._mv[: n - first]
+        self._start = (self._start + n) % size
+        self._len -= n
+        if self._len == 0:
+            self._start = 0
+        return n
+
     def read(self, nbytes=None):
         self._check()
-        if nbytes is None or nbytes >= len(self.buf):
-            buf = self.buf
-            self.buf = b""
-        else:
-            buf = self.buf[:nbytes]
-            self.buf = self.buf[nbytes:]
+        if nbytes is None or nbytes > self._len:
+            nbytes = self._len
         # uart.read() returns None if there is nothing
-        if len(buf) == 0:
+        if nbytes == 0:
             return None
-        return buf
+        buf = bytearray(nbytes)
+        self._pop(memoryview(buf))
+        return bytes(buf)
 
-    def readinto(self, data):
-        try:
-            d = self.read(len(data))
-            for i in range(len(d)):
-                data[i] = d[i]
-            return len(d)
-        except:
-            return 0
+    def readinto(self, data, nbytes=None):
+        self._check()
+        mv = memoryview(data)
+        if nbytes is not None:
+            mv = mv[:nbytes]
+        return self._pop(mv)
 
     def write(self, data):
         try:
@@ -81,6 +125,27 @@ class TCPHost:
         except:
             return 0
 
+    def fileno(self):
+        # Without a client there is no fd to wait on: a poller keeps the fd
+        # it got on register(), and the listening socket would stay there
+        # after accept. Register in select.poll only when isconnected().
+        if self.client is None:
+            return -1
+        return self.client.fileno()
+
+    def ioctl(self, op, arg):
+        if op == _MP_STREAM_POLL:
+            self._check()
+            flags = 0
+            if arg & _POLLIN and self._len > 0:
+                flags |= _POLLIN
+            if arg & _POLLOUT and self.client is not None:
+                flags |= _POLLOUT
+            return flags
+        if op == _MP_STREAM_GET_FILENO:
+            return self.fileno()
+        return -1
+
 
 if __name__ == "__main__":
     tcphost = TCPHost()
@@ -0,0 +1,17 @@
+"""
+This module simulates tickless module available on hardware.
+Unix port has no ticks to suppress, sleep_ms just sleeps
+for the requested time (or a max period) and returns it.
+"""
+import time
+
+# same limit as SysTick on the board at 180 MHz
+MAX_SLEEP_MS = 92
+
+
+def sleep_ms(ms):
+    if ms < 0 or ms > MAX_SLEEP_MS:
+        ms = MAX_SLEEP_MS
+    t0 = time.ticks_ms()
+    time.sleep_ms(ms)
+    return time.ticks_diff(time.ticks_ms(), t0)
@@ -44,22 +44,44 @@ class CardConnection:
             self.s = None
         return False
 
-    def connect(self, protocol):
+    def connect(self, protocol=None):
         if not self.isCardInserted():
             raise NoCardException("no card inserted")
         self.protocol = protocol
 
+    async def connect_async(self, protocol=None):
+        self.connect(protocol)
+
     def disconnect(self):
         pass
 
     def getATR(self):
         return b"simulator ATR"
 
-    def transmit(self, data):
+    @staticmethod
+    def _response(rsp, into):
+        # simulator always returns raw response, optionally copied into buffer
+        if into is None:
+            return rsp
+        n = min(len(rsp), len(into))
+        into[:n] = rsp[:n]
+        return len(rsp)
+
+    def transmit(self, data, protocol=None, *, raw=False, into=None):
+        if not self.isCardInserted():
+            raise NoCardException("no card inserted")
+        self.s.send(bytes(data))
+        return self._response(self.s.recv(300), into)
+
+    async def transmit_async(self, data, protocol=None, *, raw=False, into=None):
+        # same as transmit() but waits for the response in asyncio IO queue
+        from asyncio import core
+
         if not self.isCardInserted():
             raise NoCardException("no card inserted")
         self.s.send(bytes(data))
-        return self.s.recv(300)
+        yield core._io_queue.queue_read(self.s)
+        return self._response(self.s.recv(300), into)
 
 
 class Reader:
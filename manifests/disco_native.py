@@ -0,0 +1,4 @@
+include('disco.py')
+# native / viper versions of hot loops, see libs/native/embit_native.py,
+# native_boot.py installs them at boot (MICROPY_BOARD_FROZEN_BOOT_FILE)
+freeze('../libs/native')
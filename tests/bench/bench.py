@@ -0,0 +1,78 @@
+"""
+Measurement helpers shared by benchmark modules.
+
+Every benchmark module has a `benchmarks()` generator yielding
+(name, fn, repeat) tuples. Setup code runs in the generator,
+so only `fn()` is measured. If `fn()` returns a dict (from the first,
+warm-up run) its items are added to the results.
+Long-running benchmarks can call `sample()` in inner loops
+to make peak heap estimation more precise.
+"""
+import gc
+import time
+
+_base = 0
+_peak = 0
+
+
+def sample():
+    """Records current heap usage if it is above the peak"""
+    global _peak
+    used = gc.mem_alloc() - _base
+    if used > _peak:
+        _peak = used
+
+
+def allocated(fn):
+    """
+    Bytes allocated by fn() with GC disabled,
+    None if heap is too small to run it without collection.
+    """
+    gc.collect()
+    gc.disable()
+    try:
+        start = gc.mem_alloc()
+        fn()
+        return gc.mem_alloc() - start
+    except MemoryError:
+        return None
+    finally:
+        gc.enable()
+
+
+def peak(fn):
+    """Maximum heap usage above the current level sampled during fn()"""
+    global _base, _peak
+    gc.collect()
+    _base = gc.mem_alloc()
+    _peak = 0
+    fn()
+    sample()
+    return _peak
+
+
+def best_time(fn, repeat):
+    """Best of `repeat` runs in microseconds"""
+    best = None
+    for _ in range(repeat):
+        gc.collect()
+        t0 = time.ticks_us()
+        fn()
+        dt = time.ticks_diff(time.ticks_us(), t0)
+        if best is None or dt < best:
+            best = dt
+    return best
+
+
+def measure(fn, repeat=3):
+    # warm up caches and lazy imports
+    extra = fn()
+    res = {
+        "time_us": best_time(fn, repeat),
+        "alloc": allocated(fn),
+        "peak": peak(fn),
+    }
+    # benchmarks can report their own metrics as a dict
+    if isinstance(extra, dict):
+        res.update(extra)
+    return res
@@ -0,0 +1,98 @@
+"""
+asyncio scheduler: task switch rate with native and Python TaskQueue,
+CPU load of an idle loop with blocking poll and with the idle hook.
+"""
+import time
+import asyncio
+from asyncio import core, task as pytask
+
+try:
+    import _uasyncio
+except ImportError:
+    _uasyncio = None
+
+import tickless
+
+TASKS = 10
+SWITCHES = 1000
+IDLE_PERIOD_MS = 20
+IDLE_PERIODS = 10
+
+
+async def worker(n):
+    for _ in range(n):
+        await asyncio.sleep_ms(0)
+
+
+async def switches():
+    tasks = [asyncio.create_task(worker(SWITCHES // TASKS)) for _ in range(TASKS)]
+    for t in tasks:
+        await t
+
+
+def run_switches():
+    t0 = time.ticks_us()
+    asyncio.run(switches())
+    dt = time.ticks_diff(time.ticks_us(), t0)
+    return {"switches_per_s": SWITCHES * 1000000 // max(dt, 1)}
+
+
+def queue_ops(mod):
+    """push_sorted / pop_head of 100 tasks"""
+    q = mod.TaskQueue()
+    tasks = [mod.Task(worker(0), None) for _ in range(100)]
+
+    def fn():
+        for i, t in enumerate(tasks):
+            q.push_sorted(t, (i * 7919) % 1000)
+        while q.peek():
+            q.pop_head()
+
+    return fn
+
+
+async def idle():
+    for _ in range(IDLE_PERIODS):
+        await asyncio.sleep_ms(IDLE_PERIOD_MS)
+
+
+def idle_load(hook):
+    """Share of wall time spent outside of sleep while tasks are waiting"""
+    stats = [0, 0]  # time asleep, number of wakeups
+
+    def timed(fn):
+        def wrapper(dt):
+            t0 = time.ticks_us()
+            res = fn(dt)
+            stats[0] += time.ticks_diff(time.ticks_us(), t0)
+            stats[1] += 1
+            return res
+
+        return wrapper
+
+    if hook is None:
+        io = core._io_queue
+        io.wait_io_event = timed(io.wait_io_event)
+    else:
+        asyncio.set_idle_hook(timed(hook))
+    t0 = time.ticks_us()
+    try:
+        asyncio.run(idle())
+    finally:
+        asyncio.set_idle_hook(None)
+        if hook is None:
+            del io.wait_io_event
+    wall = time.ticks_diff(time.ticks_us(), t0)
+    return {
+        "idle_load_pct": round((wall - stats[0]) * 100 / wall, 2),
+        "wakeups": stats[1],
+    }
+
+
+def benchmarks():
+    yield "asyncio_switch_1k", run_switches, 5
+    yield "taskqueue_py", queue_ops(pytask), 10
+    if _uasyncio is not None:
+        yield "taskqueue_native", queue_ops(_uasyncio), 10
+    yield "asyncio_idle_poll", lambda: idle_load(None), 1
+    yield "asyncio_idle_tickless", lambda: idle_load(tickless.sleep_ms), 1
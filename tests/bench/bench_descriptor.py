@@ -0,0 +1,119 @@
+from embit import bip32, script
+from embit.descriptor import Descriptor
+from embit.hashes import sha256
+from embit.psbt import OutputScope, DerivationPath
+from addrindex import AddressIndex
+from bench import sample
+
+NUM_KEYS = 15
+NUM_OUTPUTS = 50
+# receive address to look up, change branch is checked too
+LOOKUP_INDEX = 49
+INDEX_PATH = "/tmp/bench_addrindex"
+PATH = "m/48h/1h/0h/2h"
+
+
+def cosigners(tag):
+    """Distinct roots so every cosigner has own fingerprint"""
+    return [bip32.HDKey.from_seed(sha256(tag + bytes([i]))) for i in range(NUM_KEYS)]
+
+
+def multisig(roots):
+    keys = []
+    for root in roots:
+        xpub = root.derive(PATH).to_public()
+        keys.append("[%s%s]%s/<0;1>/*" % (root.my_fingerprint.hex(), PATH[1:], xpub.to_base58()))
+    return Descriptor.from_string("wsh(sortedmulti(%d,%s))" % (NUM_KEYS // 2 + 1, ",".join(keys)))
+
+
+def miniscript(roots):
+    """
+    Deep policy: thresh of half of the keys with a timelock,
+    wrapped into a chain of andor(pk(key),older(n),...) by the other half.
+    """
+    keys = []
+    for root in roots:
+        xpub = root.derive(PATH).to_public()
+        keys.append("[%s%s]%s/<0;1>/*" % (root.my_fingerprint.hex(), PATH[1:], xpub.to_base58()))
+    half = NUM_KEYS // 2
+    inner = "thresh(%d,pk(%s),%s,sln:older(12960))" % (
+        half // 2 + 1,
+        keys[0],
+        ",".join("s:pk(%s)" % k for k in keys[1:half]),
+    )
+    for i, k in enumerate(keys[half:]):
+        inner = "andor(pk(%s),older(%d),%s)" % (k, 1000 * (i + 1), inner)
+    return "wsh(%s)" % inner
+
+
+def derive_scripts(desc, n):
+    for i in range(n):
+        desc.derive(i, branch_index=0).script_pubkey()
+        sample()
+
+
+def branches(desc, n):
+    # no EC math here, only copying and checking the tree
+    for i in range(n):
+        desc.branch(i % 2)
+        sample()
+
+
+def lookup_naive(desc, addr):
+    """Encodes addresses of both branches one by one"""
+    for i in range(LOOKUP_INDEX + 1):
+        for branch in range(2):
+            if desc.derive(i, branch_index=branch).address() == addr:
+                return i, branch
+        sample()
+
+
+def lookup(desc, addr, path=None):
+    res = AddressIndex(desc, path).find(addr)
+    sample()
+    return res
+
+
+def outputs(desc, roots, num):
+    """Outputs of the descriptor at change indexes 0..num-1"""
+    path = bip32.parse_path(PATH)
+    res = []
+    for i in range(num):
+        out = OutputScope()
+        d = desc.derive(i, branch_index=1)
+        out.script_pubkey = d.script_pubkey()
+        for root, k in zip(roots, d.keys):
+            der = DerivationPath(root.my_fingerprint, path + [1, i])
+            out.bip32_derivations[k.get_public_key()] = der
+        res.append(out)
+    return res
+
+
+def change(desc, outs):
+    res = [out for out in outs if desc.owns(out)]
+    sample()
+    return res
+
+
+def benchmarks():
+    mine = cosigners(b"mine")
+    desc = multisig(mine)
+    # outputs of the same type from another multisig wallet
+    other = cosigners(b"other")
+    foreign = outputs(multisig(other), other, NUM_OUTPUTS)
+    yield "owns_reject_%d_of_%d" % (NUM_OUTPUTS, NUM_KEYS), lambda: change(desc, foreign), 3
+    # own outputs are derived and compiled, so fewer of them
+    outs = outputs(desc, mine, 5)
+    yield "owns_mine_5_of_%d" % NUM_KEYS, lambda: change(desc, outs), 3
+    policy = miniscript(mine)
+    yield "miniscript_parse_%d" % NUM_KEYS, lambda: Descriptor.from_string(policy), 3
+    desc = Descriptor.from_string(policy)
+    wpkh = Descriptor.from_string("wpkh(%s/<0;1>/*)" % mine[0].derive(PATH).to_public())
+    addr = wpkh.derive(LOOKUP_INDEX, branch_index=0).address()
+    yield "address_lookup_naive_%d" % LOOKUP_INDEX, lambda: lookup_naive(wpkh, addr), 1
+    yield "address_lookup_scan_%d" % LOOKUP_INDEX, lambda: lookup(wpkh, addr), 1
+    # index file is built by the first run
+    lookup(wpkh, addr, INDEX_PATH)
+    yield "address_lookup_indexed", lambda: lookup(wpkh, addr, INDEX_PATH), 3
+    yield "miniscript_branch_20", lambda: branches(desc, 20), 3
+    yield "miniscript_derive_5", lambda: derive_scripts(desc, 5), 3
@@ -0,0 +1,17 @@
+import hashlib
+import hmac
+from embit import hashes
+from embit.bip39 import mnemonic_to_seed
+from fixtures import MNEMONIC
+
+
+def benchmarks():
+    data = bytes(range(256)) * 4
+    big = data * 64
+    yield "sha256_1k", lambda: hashlib.sha256(data).digest(), 20
+    yield "sha256_64k", lambda: hashlib.sha256(big).digest(), 5
+    yield "sha512_64k", lambda: hashlib.sha512(big).digest(), 5
+    yield "hash160_1k", lambda: hashes.hash160(data), 20
+    yield "hmac_sha512", lambda: hmac.new(data[:32], data, "sha512").digest(), 20
+    # BIP-39 seed, 2048 rounds of PBKDF2-HMAC-SHA512
+    yield "pbkdf2_bip39", lambda: mnemonic_to_seed(MNEMONIC), 3
@@ -0,0 +1,45 @@
+"""TCPHost ring buffer throughput, the unix stand-in for USB VCP / UART"""
+import socket
+import time
+from tcphost import TCPHost
+
+SIZE = 1024 * 1024
+CHUNK = 4096
+PORT = 8799
+
+
+def connect():
+    host = TCPHost(PORT)
+    client = socket.socket()
+    client.connect(socket.getaddrinfo("127.0.0.1", PORT)[0][-1])
+    for _ in range(100):
+        if host.isconnected():
+            break
+        time.sleep_ms(10)
+    return host, client
+
+
+def transfer(host, client):
+    chunk = bytes(i % 251 for i in range(CHUNK))
+    # not aligned to chunks, so the ring buffer wraps
+    buf = bytearray(3000)
+    received = 0
+    t0 = time.ticks_us()
+    for i in range(SIZE // CHUNK):
+        client.write(chunk)
+        while received < (i + 1) * CHUNK:
+            received += host.readinto(buf)
+            if time.ticks_diff(time.ticks_us(), t0) > 30000000:
+                raise RuntimeError("TCPHost transfer stalled")
+    dt = time.ticks_diff(time.ticks_us(), t0)
+    return {"kb_per_s": SIZE * 1000000 // 1024 // max(dt, 1)}
+
+
+def benchmarks():
+    host, client = connect()
+    if not host.isconnected():
+        return
+    yield "tcphost_1mb", lambda: transfer(host, client), 3
+    client.close()
+    host.client.close()
+    host.socket.close()
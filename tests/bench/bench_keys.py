@@ -0,0 +1,35 @@
+from embit import bip32
+from embit.descriptor import Descriptor
+from bench import sample
+import fixtures
+
+
+def derive_range(key, n):
+    for i in range(n):
+        key.derive([0, i])
+        sample()
+
+
+def derive_addresses(desc, n):
+    for i in range(n):
+        desc.derive(i).address()
+        sample()
+
+
+def benchmarks():
+    root = fixtures.root()
+    account = root.derive(fixtures.ACCOUNT)
+    xpub = account.to_public()
+    yield "bip32_derive_path", lambda: root.derive("m/84h/0h/0h/0/0"), 5
+    yield "bip32_xprv_20", lambda: derive_range(account, 20), 3
+    yield "bip32_xpub_20", lambda: derive_range(xpub, 20), 3
+    desc = Descriptor.from_string(
+        "wpkh([%s/84h/1h/0h]%s/0/*)" % (root.my_fingerprint.hex(), xpub.to_base58())
+    )
+    yield "descriptor_wpkh_20", lambda: derive_addresses(desc, 20), 3
+    cosigners = [root.derive("m/48h/1h/%dh/2h" % i).to_public() for i in range(3)]
+    desc = Descriptor.from_string(
+        "wsh(sortedmulti(2,%s))"
+        % ",".join("[%s]%s/0/*" % (root.my_fingerprint.hex(), k.to_base58()) for k in cosigners)
+    )
+    yield "descriptor_multisig_20", lambda: derive_addresses(desc, 20), 3
@@ -0,0 +1,74 @@
+"""Pure-Python vs native hot loops, names ending with _native use libs/native"""
+from embit import base58, bech32, slip39
+from microur.util import bytewords, xoshiro256
+import io
+import os
+import sys
+
+try:
+    import embit_native
+except ImportError:
+    embit_native = None
+
+
+def polymod_values():
+    return [i % 32 for i in range(1000)]
+
+
+def xoshiro_run(fn):
+    rng = xoshiro256.Xoshiro256.from_bytes(bytes(32))
+    for _ in range(200):
+        fn(rng)
+
+
+def bytewords_run(fn, data):
+    fout = io.BytesIO()
+    fn(io.BytesIO(data), len(data), fout)
+
+
+# armv7emsp .mpy files built by `make native-mpy`
+MPY_DIR = sys.path[0] + "/../../bin/native-mpy"
+PURE_MODULES = ["base58", "bech32", "slip39", "bytewords", "xoshiro256"]
+
+
+def mpy_sizes():
+    """Flash used by pure modules and by their native versions"""
+    try:
+        pure = sum(os.stat("%s/%s.mpy" % (MPY_DIR, m))[6] for m in PURE_MODULES)
+        native = os.stat(MPY_DIR + "/embit_native.mpy")[6]
+    except OSError:
+        return None
+    return {"pure_mpy": pure, "native_mpy": native}
+
+
+def benchmarks():
+    if embit_native is None:
+        return
+    sizes = mpy_sizes()
+    if sizes is not None:
+        # native profile freezes embit_native.mpy on top of pure modules
+        yield "native_mpy_size", lambda: sizes, 1
+    values = polymod_values()
+    words = [i % 1024 for i in range(300)]
+    data = bytes(range(256)) * 2
+    encoded = base58.encode(data[:80])
+    # native firmware installs embit_native at boot
+    orig = embit_native.originals.get
+    pairs = [
+        ("bech32_polymod", bech32.bech32_polymod, values, 20),
+        ("rs1024_polymod", slip39.rs1024_polymod, words, 20),
+        ("base58_encode", base58.encode, data[:80], 20),
+        ("base58_decode", base58.decode, encoded, 20),
+    ]
+    for name, pure, arg, repeat in pairs:
+        pure = orig(name, pure)
+        native = getattr(embit_native, name)
+        yield name, lambda fn=pure, arg=arg: fn(arg), repeat
+        yield name + "_native", lambda fn=native, arg=arg: fn(arg), repeat
+    pure = orig("xoshiro_next", xoshiro256.Xoshiro256.next)
+    yield "xoshiro_next", lambda fn=pure: xoshiro_run(fn), 10
+    yield "xoshiro_next_native", lambda: xoshiro_run(embit_native.xoshiro_next), 10
+    pure = orig("bytewords_stream_encode", bytewords.stream_encode)
+    native = embit_native.bytewords_stream_encode
+    yield "bytewords_encode", lambda: bytewords_run(pure, data), 10
+    yield "bytewords_encode_native", lambda: bytewords_run(native, data), 10
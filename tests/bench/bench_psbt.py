@@ -0,0 +1,50 @@
+from io import BytesIO
+from embit.psbt import PSBT
+from embit.psbtview import PSBTView
+from bench import sample
+import fixtures
+
+SIZES = (1, 10, 100)
+
+
+def sign(raw):
+    psbt = PSBT.parse(raw)
+    sample()
+    psbt.sign_with(fixtures.root())
+    sample()
+    return psbt.serialize()
+
+
+def sign_view(raw):
+    view = PSBTView.view(BytesIO(raw))
+    sigs = BytesIO()
+    view.sign_with(fixtures.root(), sigs)
+    sample()
+
+
+def benchmarks():
+    for version in (None, 2):
+        v = "v%d" % (version or 0)
+        for n in SIZES:
+            raw = fixtures.make_psbt(n, version)
+            repeat = 3 if n < 100 else 1
+            yield "psbt_parse_%s_%d" % (v, n), lambda: PSBT.parse(raw), repeat
+            yield "psbt_sign_%s_%d" % (v, n), lambda: sign(raw), repeat
+            yield "psbtview_sign_%s_%d" % (v, n), lambda: sign_view(raw), repeat
+    # legacy inputs, every sighash covers all inputs
+    for n in (10, 100):
+        raw = fixtures.make_legacy_psbt(n)
+        yield "psbt_sign_legacy_%d" % n, lambda: sign(raw), 1
+        yield "psbtview_sign_legacy_%d" % n, lambda: sign_view(raw), 1
+    # 15-of-15 multisig, every input has 15 derivations to parse and compare
+    for n in (1, 10):
+        raw = fixtures.make_multisig_psbt(n)
+        repeat = 3 if n < 10 else 1
+        yield "psbt_parse_multisig_%d" % n, lambda: PSBT.parse(raw), repeat
+        yield "psbt_sign_multisig_%d" % n, lambda: sign(raw), repeat
+        yield "psbtview_sign_multisig_%d" % n, lambda: sign_view(raw), repeat
+    # serialization of a parsed psbt and txid, no parsing in the loop
+    for n in (10, 100):
+        psbt = PSBT.parse(fixtures.make_psbt(n))
+        yield "psbt_serialize_%d" % n, psbt.serialize, 3
+        yield "psbt_txid_%d" % n, psbt.tx.txid, 3
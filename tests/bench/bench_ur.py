@@ -0,0 +1,39 @@
+from io import BytesIO
+from microur.encoder import UREncoder
+from microur.decoder import URDecoder
+from bench import sample
+import fixtures
+
+try:
+    import qrcode
+except ImportError:
+    qrcode = None
+
+
+def encode(raw, part_len):
+    enc = UREncoder(UREncoder.CRYPTO_PSBT, BytesIO(raw), part_len)
+    return [enc.next_part() for _ in range(enc.seq_len)]
+
+
+def decode(parts):
+    dec = URDecoder()
+    for part in parts:
+        dec.process_part(part)
+        sample()
+    assert dec.is_complete
+    with dec.result() as f:
+        return f.read()
+
+
+def encode_qr(parts):
+    for part in parts:
+        qrcode.encode(part.upper())
+
+
+def benchmarks():
+    raw = fixtures.make_psbt(10)
+    yield "ur_encode_psbt_10", lambda: encode(raw, 200), 3
+    parts = encode(raw, 200)
+    yield "ur_decode_psbt_10", lambda: decode(parts), 3
+    if qrcode is not None:
+        yield "qr_encode_ur_parts", lambda: encode_qr(parts), 3
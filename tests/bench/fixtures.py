@@ -0,0 +1,97 @@
+"""Deterministic keys and PSBTs for benchmarks"""
+from embit import bip32, bip39, script
+from embit.psbt import PSBT, DerivationPath
+from embit.transaction import Transaction, TransactionInput, TransactionOutput
+from embit.hashes import sha256
+
+MNEMONIC = "abandon " * 11 + "about"
+# BIP-84 testnet account
+ACCOUNT = "m/84h/1h/0h"
+
+_root = None
+
+
+def root():
+    global _root
+    if _root is None:
+        _root = bip32.HDKey.from_seed(bip39.mnemonic_to_seed(MNEMONIC))
+    return _root
+
+
+def make_psbt(num_inputs, version=None):
+    """Serialized PSBT spending `num_inputs` P2WPKH inputs of the root key"""
+    r = root()
+    fgp = r.my_fingerprint
+    account = r.derive(ACCOUNT)
+    vin = []
+    utxos = []
+    for i in range(num_inputs):
+        key = account.derive([0, i]).key
+        vin.append(TransactionInput(sha256(i.to_bytes(4, "little")), i % 2))
+        utxos.append((key.get_public_key(), TransactionOutput(100000, script.p2wpkh(key))))
+    change = account.derive([1, 0]).key.get_public_key()
+    vout = [
+        TransactionOutput(num_inputs * 100000 - 20000, script.p2wpkh(change)),
+        TransactionOutput(10000, script.p2wpkh(r.derive("m/0h").key)),
+    ]
+    psbt = PSBT(Transaction(vin=vin, vout=vout))
+    path = bip32.parse_path(ACCOUNT)
+    for i, (pub, utxo) in enumerate(utxos):
+        psbt.inputs[i].witness_utxo = utxo
+        psbt.inputs[i].bip32_derivations[pub] = DerivationPath(fgp, path + [0, i])
+    psbt.outputs[0].bip32_derivations[change] = DerivationPath(fgp, path + [1, 0])
+    psbt.version = version
+    return psbt.serialize()
+
+
+def make_legacy_psbt(num_inputs):
+    """Serialized PSBT spending `num_inputs` P2PKH inputs with full previous transactions"""
+    r = root()
+    fgp = r.my_fingerprint
+    path = bip32.parse_path("m/44h/1h/0h")
+    account = r.derive(path)
+    vin = []
+    prevs = []
+    for i in range(num_inputs):
+        key = account.derive([0, i]).key
+        prev = Transaction(
+            vin=[TransactionInput(sha256(b"prev" + i.to_bytes(4, "little")), 0)],
+            vout=[TransactionOutput(100000, script.p2pkh(key))],
+        )
+        vin.append(TransactionInput(prev.txid(), 0))
+        prevs.append((key.get_public_key(), prev))
+    vout = [TransactionOutput(num_inputs * 100000 - 20000, script.p2pkh(r.derive("m/0h").key))]
+    psbt = PSBT(Transaction(vin=vin, vout=vout))
+    for i, (pub, prev) in enumerate(prevs):
+        psbt.inputs[i].non_witness_utxo = prev
+        psbt.inputs[i].bip32_derivations[pub] = DerivationPath(fgp, path + [0, i])
+    return psbt.serialize()
+
+
+def make_multisig_psbt(num_inputs, n=15):
+    """
+    Serialized PSBT spending `num_inputs` wsh(sortedmulti(n,...)) inputs.
+    The root key is one of the cosigners, other keys are foreign.
+    """
+    r = root()
+    path = bip32.parse_path("m/48h/1h/0h/2h")
+    accounts = [(r.my_fingerprint, r.derive(path))]
+    for i in range(1, n):
+        cosigner = bip32.HDKey.from_seed(sha256(b"cosigner" + bytes([i])))
+        accounts.append((cosigner.my_fingerprint, cosigner.derive(path)))
+    vin = []
+    scopes = []
+    for i in range(num_inputs):
+        pubs = [(fgp, acc.derive([0, i]).key.get_public_key()) for fgp, acc in accounts]
+        ws = script.multisig(n, sorted(pub for _, pub in pubs))
+        vin.append(TransactionInput(sha256(i.to_bytes(4, "little")), 0))
+        scopes.append((pubs, ws))
+    vout = [TransactionOutput(num_inputs * 100000 - 20000, script.p2wpkh(r.derive("m/0h").key))]
+    psbt = PSBT(Transaction(vin=vin, vout=vout))
+    for i, (pubs, ws) in enumerate(scopes):
+        inp = psbt.inputs[i]
+        inp.witness_utxo = TransactionOutput(100000, script.p2wsh(ws))
+        inp.witness_script = ws
+        for fgp, pub in pubs:
+            inp.bip32_derivations[pub] = DerivationPath(fgp, path + [0, i])
+    return psbt.serialize()
@@ -0,0 +1,102 @@
+"""
+Benchmark suite for the unix port:
+
+    bin/micropython_unix tests/bench/run_bench.py [options] [name_prefix ...]
+
+Options:
+    --save FILE         store results as JSON
+    --compare FILE      compare to saved results, exit with 1 on regressions
+    --threshold PCT     allowed slowdown / extra allocations, default 10%
+
+Results are printed as JSON: for every benchmark best time in microseconds,
+bytes allocated by a single run and sampled peak heap usage.
+"""
+import sys
+import json
+
+curdir = sys.path[0]
+pardir = curdir + "/../.."
+sys.path.append(pardir + "/libs/common")
+sys.path.append(pardir + "/libs/unix")
+# native versions of hot loops, see bench_native.py
+sys.path.append(pardir + "/libs/native")
+
+import bench
+
+MODULES = [
+    "bench_hashes",
+    "bench_keys",
+    "bench_descriptor",
+    "bench_psbt",
+    "bench_ur",
+    "bench_native",
+    "bench_asyncio",
+    "bench_host",
+]
+# metrics to check for regressions
+METRICS = ["time_us", "alloc", "peak"]
+
+
+def run(prefixes=[]):
+    results = {}
+    for modname in MODULES:
+        mod = __import__(modname)
+        for name, fn, repeat in mod.benchmarks():
+            if prefixes and not any(name.startswith(p) for p in prefixes):
+                continue
+            res = bench.measure(fn, repeat)
+            print("%-26s %10d us" % (name, res["time_us"]), file=sys.stderr)
+            results[name] = res
+    return results
+
+
+def compare(results, baseline, threshold):
+    """Returns a list of regressions larger than threshold percents"""
+    regressions = []
+    for name in sorted(results):
+        if name not in baseline:
+            continue
+        for metric in METRICS:
+            old = baseline[name].get(metric)
+            new = results[name][metric]
+            if old is None or new is None or old == 0:
+                continue
+            change = (new - old) * 100 / old
+            if change > threshold:
+                regressions.append((name, metric, old, new, change))
+    return regressions
+
+
+def main(args):
+    save = None
+    baseline = None
+    threshold = 10
+    prefixes = []
+    while args:
+        arg = args.pop(0)
+        if arg == "--save":
+            save = args.pop(0)
+        elif arg == "--compare":
+            with open(args.pop(0)) as f:
+                baseline = json.load(f)
+        elif arg == "--threshold":
+            threshold = float(args.pop(0))
+        else:
+            prefixes.append(arg)
+    results = run(prefixes)
+    print(json.dumps(results))
+    if save:
+        with open(save, "w") as f:
+            json.dump(results, f)
+    if baseline is not None:
+        regressions = compare(results, baseline, threshold)
+        for name, metric, old, new, change in regressions:
+            print(
+                "REGRESSION %s %s: %d -> %d (+%d%%)" % (name, metric, old, new, change),
+                file=sys.stderr,
+            )
+        if regressions:
+            sys.exit(1)
+
+
+main(sys.argv[1:])
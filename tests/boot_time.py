@@ -0,0 +1,44 @@
+"""
+Cold-start profile: imports the modules a wallet needs on power-up
+and prints the boot trace. Run in a fresh interpreter:
+
+    bin/micropython_unix tests/boot_time.py [--gui]
+    mpremote run tests/boot_time.py            # on the board
+
+Compare total time before and after changes to import structure.
+"""
+import sys
+
+try:
+    curdir = sys.path[0]
+    pardir = curdir + "/.."
+    sys.path.append(pardir + "/libs/common")
+    sys.path.append(pardir + "/libs/unix")
+    sys.path.append(pardir + "/usermods/udisplay_f469/display_unixport")
+except (IndexError, TypeError):
+    # frozen modules on the board
+    pass
+
+import boottrace
+
+boottrace.start()
+
+if "--gui" in getattr(sys, "argv", []):
+    with boottrace.phase("display.init"):
+        import display
+
+        display.init(False)
+
+from embit import bip32, bip39, script
+from embit.psbt import PSBT
+from embit.descriptor import Descriptor
+
+boottrace.mark("embit ready")
+
+# first use of lazily imported parts
+with boottrace.phase("bip39 wordlist"):
+    bip39.mnemonic_is_valid("abandon " * 11 + "about")
+
+boottrace.stop()
+total = boottrace.report()
+print("Total: %d ms" % (total // 1000))
@@ -6,5 +6,13 @@ pardir = curdir + "/.."
 sys.path.append(pardir + "/libs/common")
 sys.path.append(pardir + "/libs/unix")
 sys.path.append(pardir + "/usermods/udisplay_f469/display_unixport")
+# native versions of hot loops, compared to pure ones in test_native
+sys.path.append(pardir + "/libs/native")
 
-unittest.main("tests")
+if len(sys.argv) > 1:
+    # single test module without the rest of the suite,
+    # i.e. test_memory with a limited heap
+    sys.path.append(curdir + "/tests")
+    unittest.main(sys.argv[1])
+else:
+    unittest.main("tests")
@@ -3,5 +3,17 @@ from .test_base58 import *
 from .test_bech32 import *
 from .test_bip32 import *
 from .test_psbt import *
+from .test_pset import *
+from .test_taptree import *
+from .test_miniscript import *
+from .test_descriptor import *
+from .test_addrindex import *
+from .test_sighash import *
 from .test_bip39 import *
-from .test_hmac import *
\ No newline at end of file
+from .test_hmac import *
+from .test_sdram import *
+from .test_tcphost import *
+from .test_boottrace import *
+from .test_asyncio import *
+from .test_memory import *
+from .test_native import *
@@ -0,0 +1,85 @@
+import os
+from unittest import TestCase
+from embit import bip32, script
+from embit.hashes import sha256
+from embit.descriptor import Descriptor
+from addrindex import AddressIndex
+import addrindex
+
+TMPDIR = "/tmp/f469_test_addrindex"
+XPUB = bip32.HDKey.from_seed(sha256(b"addrindex")).to_public().to_base58()
+DESC = "wpkh(%s/<0;1>/*)" % XPUB
+
+
+class CountingIndex(AddressIndex):
+    """Counts derived scripts"""
+
+    derived = 0
+
+    def derive_script(self, idx, branch_index):
+        self.derived += 1
+        return super().derive_script(idx, branch_index)
+
+
+def remove(path):
+    for b in range(2):
+        try:
+            os.remove("%s.%d" % (path, b))
+        except OSError:
+            pass
+
+
+class AddressIndexTest(TestCase):
+    def setUp(self):
+        try:
+            os.mkdir(TMPDIR)
+        except OSError:
+            pass
+        self.path = TMPDIR + "/wallet.idx"
+        remove(self.path)
+        self.desc = Descriptor.from_string(DESC)
+
+    def tearDown(self):
+        remove(self.path)
+
+    def test_find(self):
+        index = CountingIndex(self.desc)
+        addr = self.desc.derive(25, branch_index=1).address()
+        self.assertEqual(index.find(addr), (25, 1))
+        # branches are derived in turns
+        self.assertEqual(index.derived, 26 + 40)
+        spk = self.desc.derive(3, branch_index=0).script_pubkey()
+        self.assertEqual(index.find(spk), (3, 0))
+        # legacy address of the same key has the same hash160
+        key = self.desc.derive(3, branch_index=0).key.get_public_key()
+        self.assertEqual(index.find(script.p2pkh(key), limit=30), None)
+        # receive branch is already derived further, change up to the limit
+        self.assertEqual(len(index.prefixes(0)), 40 * addrindex.PREFIX_LEN)
+        self.assertEqual(len(index.prefixes(1)), 30 * addrindex.PREFIX_LEN)
+
+    def test_persistent(self):
+        addr = self.desc.derive(45, branch_index=0).address()
+        self.assertEqual(AddressIndex(self.desc, self.path).find(addr), (45, 0))
+        # second lookup derives only the candidate
+        index = CountingIndex(self.desc, self.path)
+        self.assertEqual(index.find(addr), (45, 0))
+        self.assertEqual(index.derived, 1)
+        # index of another descriptor is rebuilt
+        other = Descriptor.from_string("sh(%s)" % DESC)
+        index = CountingIndex(other, self.path)
+        self.assertEqual(index.find(other.derive(2).address()), (2, 0))
+        self.assertEqual(index.derived, 3)
+
+    def test_interrupted_write(self):
+        addr = self.desc.derive(10, branch_index=0).address()
+        AddressIndex(self.desc, self.path).find(addr)
+        with open(self.path + ".0", "ab") as f:
+            f.write(b"\x01\x02")
+        index = CountingIndex(self.desc, self.path)
+        self.assertEqual(index.find(addr), (10, 0))
+        self.assertEqual(index.derived, 1)
+        addr = self.desc.derive(30, branch_index=0).address()
+        self.assertEqual(index.find(addr), (30, 0))
+        index = CountingIndex(self.desc, self.path)
+        self.assertEqual(index.find(addr), (30, 0))
+        self.assertEqual(index.derived, 1)
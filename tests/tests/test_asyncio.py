@@ -0,0 +1,39 @@
+from unittest import TestCase
+import sys
+import time
+import asyncio
+import tickless
+
+
+class AsyncioTest(TestCase):
+    def test_native_taskqueue(self):
+        """Firmware is built with C TaskQueue"""
+        if sys.implementation.name != "micropython":
+            return
+        import _uasyncio
+        from asyncio import core
+
+        self.assertTrue(core.TaskQueue is _uasyncio.TaskQueue)
+
+    def test_idle_hook(self):
+        """Idle hook sleeps instead of poll, timers still fire on time"""
+        calls = []
+
+        def hook(dt):
+            calls.append(dt)
+            return tickless.sleep_ms(dt)
+
+        async def main():
+            t0 = time.ticks_ms()
+            await asyncio.sleep_ms(50)
+            return time.ticks_diff(time.ticks_ms(), t0)
+
+        asyncio.set_idle_hook(hook)
+        try:
+            dt = asyncio.run(main())
+        finally:
+            asyncio.set_idle_hook(None)
+        self.assertTrue(dt >= 50)
+        self.assertTrue(dt < 150)
+        self.assertTrue(len(calls) > 0)
+        self.assertTrue(all(0 < ms <= 50 for ms in calls))
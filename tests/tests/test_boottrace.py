@@ -0,0 +1,61 @@
+from unittest import TestCase
+import sys
+import boottrace
+from embit.wordlists.base import LazyWordlist
+
+
+class BootTraceTest(TestCase):
+    def tearDown(self):
+        boottrace.stop()
+
+    def test_imports(self):
+        """Imports are recorded while tracing is active"""
+        sys.modules.pop("embit.bip85", None)
+        boottrace.start()
+        import embit.bip85
+
+        boottrace.mark("done")
+        boottrace.stop()
+        names = [name.strip() for name, _, _ in boottrace.records()]
+        self.assertTrue("import embit.bip85" in names)
+        self.assertEqual(names[-1], "done")
+        # nothing is recorded after stop()
+        boottrace.mark("ignored")
+        self.assertEqual(boottrace.records()[-1][0], "done")
+
+    def test_ring(self):
+        """Only the last SIZE records are kept, oldest first"""
+        boottrace.start()
+        for i in range(boottrace.SIZE + 10):
+            boottrace.mark(str(i))
+        res = boottrace.records()
+        self.assertEqual(len(res), boottrace.SIZE)
+        self.assertEqual(res[0][0], "10")
+        self.assertEqual(res[-1][0], str(boottrace.SIZE + 9))
+        for a, b in zip(res, res[1:]):
+            self.assertTrue(a[1] <= b[1])
+
+    def test_phase(self):
+        boottrace.start()
+        with boottrace.phase("work"):
+            sum(range(1000))
+        name, start, duration = boottrace.records()[-1]
+        self.assertEqual(name, "work")
+        self.assertTrue(duration >= 0)
+
+    def test_lazy_wordlist(self):
+        """Wordlist is loaded on first use only"""
+        calls = []
+
+        def load():
+            calls.append(1)
+            return ["abandon", "ability", "able"]
+
+        words = LazyWordlist(load)
+        self.assertEqual(calls, [])
+        self.assertEqual(len(words), 3)
+        self.assertTrue("able" in words)
+        self.assertEqual(words.index("ability"), 1)
+        self.assertEqual(words[2], "able")
+        self.assertEqual(list(words), ["abandon", "ability", "able"])
+        self.assertEqual(calls, [1])
@@ -0,0 +1,135 @@
+from unittest import TestCase
+from embit import bip32, script
+from embit.descriptor import Descriptor
+from embit.hashes import sha256
+from embit.psbt import OutputScope, DerivationPath
+
+PATH = "m/48h/1h/0h/2h"
+HARDENED = 0x80000000
+
+
+def roots(tag, n=2):
+    return [bip32.HDKey.from_seed(sha256(tag + bytes([i]))) for i in range(n)]
+
+
+def multisig(keys):
+    args = []
+    for root in keys:
+        xpub = root.derive(PATH).to_public()
+        args.append("[%s%s]%s/<0;1>/*" % (root.my_fingerprint.hex(), PATH[1:], xpub))
+    return Descriptor.from_string("wsh(sortedmulti(2,%s))" % ",".join(args))
+
+
+def output(desc, keys, idx, branch, der_idx=None, der_branch=None):
+    """Output of desc at branch/idx with derivations to der_branch/der_idx"""
+    path = bip32.parse_path(PATH)
+    der_idx = idx if der_idx is None else der_idx
+    der_branch = branch if der_branch is None else der_branch
+    out = OutputScope()
+    d = desc.derive(idx, branch_index=branch)
+    out.script_pubkey = d.script_pubkey()
+    for root, k in zip(keys, d.keys):
+        der = DerivationPath(root.my_fingerprint, path + [der_branch, der_idx])
+        out.bip32_derivations[k.get_public_key()] = der
+    return out
+
+
+class DescriptorTest(TestCase):
+    def test_key_index(self):
+        """keys are indexed by origin and own fingerprints with path prefixes"""
+        keys = roots(b"mine")
+        desc = multisig(keys)
+        index = desc.key_index
+        self.assertEqual(len(index), 4)
+        path = tuple(bip32.parse_path(PATH))
+        for root, k in zip(keys, desc.keys):
+            self.assertEqual(index[(root.my_fingerprint, path)], [k])
+            self.assertEqual(index[(k.my_fingerprint, ())], [k])
+        # same root with another account
+        xpub = keys[0].derive("m/84h/1h/0h").to_public()
+        s = "[%s/84h/1h/0h]%s/<0;1>/*" % (keys[0].my_fingerprint.hex(), xpub)
+        both = str(desc).split("#")[0]
+        both = Descriptor.from_string(both.replace("(2,", "(2,%s," % s))
+        self.assertEqual(len(both.key_index[(keys[0].my_fingerprint, path)]), 1)
+        self.assertEqual(len(both.key_index), 6)
+        # non-extended keys are not indexed
+        pub = keys[0].derive(PATH).key.get_public_key()
+        desc = Descriptor.from_string("wpkh(%s)" % pub.sec().hex())
+        self.assertEqual(desc.key_index, {})
+
+    def test_owns(self):
+        keys = roots(b"mine")
+        desc = multisig(keys)
+        for branch in range(2):
+            for idx in [0, 7, HARDENED - 1]:
+                out = output(desc, keys, idx, branch)
+                self.assertEqual(desc.owns(out), True)
+                self.assertEqual(
+                    desc.check_derivation(list(out.bip32_derivations.values())[0]),
+                    (idx, branch),
+                )
+        # change output with derivation of the receiving one
+        self.assertEqual(desc.owns(output(desc, keys, 3, 1, der_branch=0)), False)
+        self.assertEqual(desc.owns(output(desc, keys, 3, 0, der_idx=4)), False)
+        # no script_pubkey
+        out = output(desc, keys, 3, 0)
+        out.script_pubkey = None
+        self.assertEqual(desc.owns(out), False)
+        # wrong length and type
+        out.script_pubkey = script.Script(b"\x00\x14" + bytes(20))
+        self.assertEqual(desc.owns(out), False)
+
+    def test_not_owned(self):
+        keys = roots(b"mine")
+        desc = multisig(keys)
+        other = roots(b"other")
+        self.assertEqual(desc.owns(output(multisig(other), other, 3, 0)), False)
+        # same cosigners with another threshold
+        out = output(multisig(keys), keys, 3, 0)
+        wide = str(desc).replace("sortedmulti(2,", "sortedmulti(1,")
+        wide = Descriptor.from_string(wide)
+        self.assertEqual(wide.owns(out), False)
+        # no derivations
+        out.bip32_derivations = {}
+        self.assertEqual(desc.owns(out), False)
+
+    def test_out_of_range(self):
+        """derivations outside of <0;1>/* don't match"""
+        keys = roots(b"mine")
+        desc = multisig(keys)
+        fgp = keys[0].my_fingerprint
+        path = bip32.parse_path(PATH)
+        for rest in [[2, 0], [0, HARDENED], [1, HARDENED + 5], [0], [0, 1, 2]]:
+            der = DerivationPath(fgp, path + rest)
+            self.assertEqual(desc.check_derivation(der), None)
+            out = output(desc, keys, 0, 0)
+            out.bip32_derivations = {desc.keys[0].get_public_key(): der}
+            self.assertEqual(desc.owns(out), False)
+
+    def test_branch_cache(self):
+        """derive() keeps a few public branch keys and no private ones"""
+        keys = roots(b"mine")
+        desc = multisig(keys)
+        for idx in range(3):
+            for branch in range(2):
+                d = desc.derive(idx, branch_index=branch)
+                k = keys[0].derive(PATH).derive([branch, idx]).to_public()
+                self.assertEqual(d.keys[0].key, k)
+        self.assertEqual(len(desc.keys[0]._parents), 2)
+        # many branches don't grow the cache unbounded
+        xpub = keys[0].derive(PATH).to_public()
+        branches = ";".join(str(i) for i in range(10))
+        desc = Descriptor.from_string("wpkh(%s/<%s>/*)" % (xpub, branches))
+        k = desc.keys[0]
+        for branch in range(10):
+            d = desc.derive(3, branch_index=branch)
+            self.assertEqual(d.keys[0].key, xpub.derive([branch, 3]))
+            self.assertTrue(len(k._parents) <= k.MAX_PARENTS)
+        # private keys are derived from the root every time
+        xprv = keys[0].derive(PATH)
+        desc = Descriptor.from_string(
+            "wpkh([%s%s]%s/<0;1>/*)" % (keys[0].my_fingerprint.hex(), PATH[1:], xprv)
+        )
+        d = desc.derive(5, branch_index=1)
+        self.assertEqual(d.keys[0].key, xprv.derive([1, 5]))
+        self.assertEqual(desc.keys[0]._parents, {})
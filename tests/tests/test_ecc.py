@@ -13,3 +13,65 @@ class SECPTest(TestCase):
         der = secp256k1.ec_pubkey_serialize(g, secp256k1.EC_UNCOMPRESSED)
         g_hex = hexlify(der)
         self.assertEqual(answer, g_hex)
+
+
+class PublicKeyTest(TestCase):
+    def setUp(self):
+        from embit import ec
+
+        self.ec = ec
+        self.prv = ec.PrivateKey(bytes([1] * 32))
+
+    def test_parse(self):
+        """Parsed key keeps its SEC bytes"""
+        sec = self.prv.sec()
+        pub = self.ec.PublicKey.parse(sec)
+        self.assertTrue(pub.sec() is pub.sec())
+        self.assertEqual(pub.sec(), sec)
+        self.assertEqual(pub, self.prv.get_public_key())
+        self.assertEqual(hash(pub), hash(self.prv.get_public_key()))
+        h = bytes(32)
+        self.assertTrue(pub.verify(self.prv.sign(h), h))
+
+    def test_invalid_point(self):
+        """Invalid keys are rejected when parsed"""
+        x = self.prv.xonly()
+        for sec in [
+            b"\x02" + bytes(32),  # not on the curve
+            b"\x07" + x,  # hybrid and unknown prefixes
+            b"\x05" + x,
+            b"\x02" + x[:31],  # truncated
+            b"\x04" + x + x,  # y doesn't match x
+        ]:
+            with self.assertRaises(self.ec.ECError):
+                self.ec.PublicKey.parse(sec)
+        with self.assertRaises(self.ec.ECError):
+            self.ec.PublicKey.from_xonly(bytes(32))
+        self.assertEqual(self.ec.PublicKey.from_xonly(x).xonly(), x)
+
+    def test_uncompressed(self):
+        pub = self.prv.get_public_key()
+        unc = self.ec.PublicKey(pub._point, compressed=False)
+        self.assertEqual(len(unc.sec()), 65)
+        self.assertEqual(self.ec.PublicKey.parse(unc.sec()).sec(), unc.sec())
+        unc.compressed = True
+        self.assertEqual(unc.sec(), pub.sec())
+
+    def test_cached_public_key(self):
+        self.assertTrue(self.prv.get_public_key() is self.prv.get_public_key())
+        self.prv.compressed = False
+        self.assertEqual(len(self.prv.sec()), 65)
+        self.prv.compressed = True
+        self.assertEqual(len(self.prv.sec()), 33)
+
+    def test_taproot_tweak(self):
+        """BIP-86 output key of the first receiving address"""
+        internal = unhexlify(
+            "cc8a4bc64d897bddc5fbc2f670f7a8ba0b386779106cf1223c6fc5d7cd6fc115"
+        )
+        output = "a60869f0dbcf1dc659c9cecbaf8050135ea9e8cdc487053f1dc6880949dc684c"
+        for prefix in [b"\x02", b"\x03"]:
+            pub = self.ec.PublicKey.parse(prefix + internal)
+            tweaked = pub.taproot_tweak()
+            self.assertEqual(hexlify(tweaked.xonly()).decode(), output)
+            self.assertEqual(tweaked.sec()[0], 2)
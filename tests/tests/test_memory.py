@@ -0,0 +1,166 @@
+"""
+Streaming code paths should use the same amount of RAM
+no matter how large the transaction is.
+Run with a limited heap to catch full materialization:
+
+    bin/micropython_unix -X heapsize=256K tests/run_tests.py test_memory
+"""
+from unittest import TestCase
+import os
+from embit import bip32, bip39, compact, script
+from embit.hashes import sha256
+from embit.psbt import InputScope, OutputScope, DerivationPath
+from embit.psbtview import PSBTView
+from embit.transaction import Transaction, TransactionInput, TransactionOutput
+from microur.encoder import UREncoder
+from microur.decoder import FileURDecoder
+from microur.util import cbor
+
+TMPDIR = "/tmp/f469_test_memory"
+# live heap allowed while signing, independent of number of inputs
+SIGN_BUDGET = 24 * 1024
+# extra heap allowed for 10x more inputs
+SIGN_GROWTH = 2048
+
+root = bip32.HDKey.from_seed(bip39.mnemonic_to_seed("abandon " * 11 + "about"))
+account_path = bip32.parse_path("m/84h/1h/0h")
+account = root.derive(account_path)
+
+
+def tmpfile(name):
+    try:
+        os.mkdir(TMPDIR)
+    except OSError:
+        pass
+    return TMPDIR + "/" + name
+
+
+def write_psbt(f, num_inputs):
+    """Writes PSBT with P2WPKH inputs scope by scope without keeping it in RAM"""
+    fgp = root.my_fingerprint
+    outputs = [
+        TransactionOutput(num_inputs * 1000 - 500, script.p2wpkh(account.derive([1, 0]).key)),
+    ]
+    out_len = sum(len(out.serialize()) for out in outputs)
+    # every input without script_sig takes 41 bytes
+    tx_len = 4 + len(compact.to_bytes(num_inputs)) + 41 * num_inputs
+    tx_len += len(compact.to_bytes(len(outputs))) + out_len + 4
+    f.write(b"psbt\xff\x01\x00")
+    f.write(compact.to_bytes(tx_len))
+    f.write((2).to_bytes(4, "little"))
+    f.write(compact.to_bytes(num_inputs))
+    for i in range(num_inputs):
+        TransactionInput(sha256(i.to_bytes(4, "little")), 0).write_to(f)
+    f.write(compact.to_bytes(len(outputs)))
+    for out in outputs:
+        out.write_to(f)
+    f.write(bytes(4))
+    # end of global scope
+    f.write(b"\x00")
+    for i in range(num_inputs):
+        pub = account.derive([0, i]).key.get_public_key()
+        inp = InputScope()
+        inp.witness_utxo = TransactionOutput(1000, script.p2wpkh(pub))
+        inp.bip32_derivations[pub] = DerivationPath(fgp, account_path + [0, i])
+        inp.write_to(f)
+    for _ in outputs:
+        OutputScope().write_to(f)
+
+
+def write_tx(f, num_outputs):
+    """Writes legacy transaction with many outputs"""
+    f.write((2).to_bytes(4, "little"))
+    f.write(b"\x01")
+    TransactionInput(sha256(b"in"), 0).write_to(f)
+    f.write(compact.to_bytes(num_outputs))
+    spk = script.p2wpkh(account.derive([0, 0]).key)
+    for i in range(num_outputs):
+        TransactionOutput(i, spk).write_to(f)
+    f.write(bytes(4))
+
+
+class SampledStream:
+    """Writable stream sampling heap usage on every write"""
+
+    def __init__(self, budget):
+        self.budget = budget
+        self.written = 0
+
+    def write(self, b):
+        self.budget.sample()
+        self.written += len(b)
+        return len(b)
+
+
+class MemoryTest(TestCase):
+    def sign_peak(self, num_inputs):
+        fname = tmpfile("psbt_%d.tmp" % num_inputs)
+        with open(fname, "wb") as f:
+            write_psbt(f, num_inputs)
+        try:
+            with open(fname, "rb") as f:
+                with self.assertMemoryBudget(SIGN_BUDGET) as budget:
+                    psbtv = PSBTView.view(f)
+                    sigs = SampledStream(budget)
+                    self.assertEqual(psbtv.sign_with(root, sigs), num_inputs)
+            return budget.peak
+        finally:
+            os.remove(fname)
+
+    def test_psbtview_sign(self):
+        """Signing with PSBTView doesn't depend on number of inputs"""
+        small = self.sign_peak(50)
+        large = self.sign_peak(500)
+        self.assertTrue(
+            large - small <= SIGN_GROWTH,
+            "500 inputs need %d bytes, 50 inputs - %d" % (large, small),
+        )
+
+    def test_read_vout(self):
+        """read_vout doesn't keep the transaction in memory"""
+        fname = tmpfile("tx.tmp")
+        with open(fname, "wb") as f:
+            write_tx(f, 2000)
+        try:
+            with open(fname, "rb") as f:
+                with self.assertMemoryBudget(4 * 1024):
+                    vout, txhash = Transaction.read_vout(f, 1999)
+            self.assertEqual(vout.value, 1999)
+        finally:
+            os.remove(fname)
+
+    def test_file_ur_decoder(self):
+        """FileURDecoder keeps parts in files, not in RAM"""
+        fname = tmpfile("psbt_ur.tmp")
+        with open(fname, "wb") as f:
+            write_psbt(f, 100)
+        tmpdir = tmpfile("ur")
+        try:
+            os.mkdir(tmpdir)
+        except OSError:
+            pass
+        try:
+            with open(fname, "rb") as f:
+                enc = UREncoder(UREncoder.CRYPTO_PSBT, f, 400)
+                dec = FileURDecoder(tmpdir)
+                with self.assertMemoryBudget(32 * 1024) as budget:
+                    for _ in range(enc.seq_len):
+                        dec.process_part(enc.next_part())
+                        budget.sample()
+                    self.assertTrue(dec.is_complete)
+                    with dec.result() as res:
+                        # result is wrapped as CBOR bytes
+                        prefix = cbor.encode_uint(enc.data_len, cbor.CBOR_BYTES)
+                        self.assertEqual(res.read(len(prefix)), prefix)
+                        f.seek(0)
+                        chunk = bytearray(256)
+                        while True:
+                            n = res.readinto(chunk)
+                            if not n:
+                                break
+                            self.assertEqual(f.read(n), chunk[:n])
+        finally:
+            os.remove(fname)
+            for name, *_ in os.ilistdir(tmpdir):
+                os.remove(tmpdir + "/" + name)
+            os.rmdir(tmpdir)
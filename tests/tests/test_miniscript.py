@@ -0,0 +1,56 @@
+from io import BytesIO
+from unittest import TestCase
+from embit import bip32
+from embit.hashes import sha256
+from embit.descriptor import Descriptor
+from embit.descriptor.miniscript import Miniscript
+from embit.descriptor.errors import MiniscriptError
+
+KEYS = [
+    bip32.HDKey.from_seed(sha256(bytes([i]))).to_public().to_base58() + "/<0;1>/*"
+    for i in range(4)
+]
+# v: and j: wrappers don't know their length without compiling
+POLICY = "andor(pk(%s),j:and_v(v:pk(%s),pk(%s)),thresh(1,pk(%s),sln:older(100)))" % tuple(
+    KEYS
+)
+
+
+def nodes(ms):
+    yield ms
+    for arg in ms.args:
+        if isinstance(arg, Miniscript):
+            for node in nodes(arg):
+                yield node
+
+
+class MiniscriptTest(TestCase):
+    def test_analysis_cache(self):
+        desc = Descriptor.from_string("wsh(%s)" % POLICY)
+        ms = desc.miniscript
+        # verified at parse time
+        for node in nodes(ms):
+            self.assertTrue(node._verified)
+        for node in nodes(ms):
+            node.type, node.properties, len(node)
+        derived = desc.derive(7, branch_index=1).miniscript
+        for node, orig in zip(nodes(derived), nodes(ms)):
+            # analysis is carried to the derived tree
+            self.assertTrue(node._verified)
+            self.assertEqual(node._type, orig._type)
+            self.assertEqual(node._props, orig._props)
+            self.assertEqual(node._len, orig._len)
+            # and matches the one computed from scratch
+            self.assertEqual(node.type, node.inner_type())
+            self.assertEqual(node.properties, node.inner_properties())
+            self.assertEqual(len(node), len(node.compile()))
+
+    def test_invalid(self):
+        # and_v requires V as the first argument
+        s = "and_v(pk(%s),pk(%s))" % (KEYS[0], KEYS[1])
+        ms = Miniscript.read_from(BytesIO(s.encode()))
+        with self.assertRaises(MiniscriptError):
+            ms.verify()
+        # failed check is not cached as valid
+        with self.assertRaises(MiniscriptError):
+            ms.verify()
@@ -0,0 +1,128 @@
+from unittest import TestCase, skipIf
+from io import BytesIO
+from embit import base58, bech32, slip39
+from microur.util import bytewords, xoshiro256
+
+try:
+    # frozen only by the native build profile, needs native emitter
+    import embit_native
+except ImportError:
+    embit_native = None
+
+NO_NATIVE = embit_native is None
+MSG = "no native emitter"
+
+
+def pure(name, fn):
+    """Pure-Python version, native firmware installs embit_native at boot"""
+    return embit_native.originals.get(name, fn)
+
+
+def words(n, bits, seed=1):
+    """Pseudo-random list of n numbers of `bits` bits"""
+    res = []
+    for i in range(n):
+        seed = (seed * 1103515245 + 12345) & 0x7FFFFFFF
+        res.append((seed >> 8) % (1 << bits))
+    return res
+
+
+class NativeTest(TestCase):
+    """Native versions of hot loops return the same as pure-Python ones"""
+
+    @skipIf(NO_NATIVE, MSG)
+    def test_polymod(self):
+        for n in [0, 1, 10, 90, 1000]:
+            values = words(n, 5, n)
+            self.assertEqual(
+                embit_native.bech32_polymod(values),
+                pure("bech32_polymod", bech32.bech32_polymod)(values),
+            )
+            values = words(n, 10, n)
+            self.assertEqual(
+                embit_native.rs1024_polymod(values),
+                pure("rs1024_polymod", slip39.rs1024_polymod)(values),
+            )
+        # checksum of a real address
+        values = bech32.bech32_hrp_expand("bc") + [0] * 38
+        self.assertEqual(
+            embit_native.bech32_polymod(values),
+            pure("bech32_polymod", bech32.bech32_polymod)(values),
+        )
+
+    @skipIf(NO_NATIVE, MSG)
+    def test_base58(self):
+        encode = pure("base58_encode", base58.encode)
+        decode = pure("base58_decode", base58.decode)
+        vectors = [
+            b"",
+            b"\x00",
+            b"\x00\x00hello world",
+            bytes(range(256)),
+            b"\xff" * 80,
+        ]
+        for data in vectors:
+            s = encode(data)
+            self.assertEqual(embit_native.base58_encode(data), s)
+            self.assertEqual(embit_native.base58_decode(s), decode(s))
+        for s in ["1", "111", "11StV1DL6CwTryKyV"]:
+            self.assertEqual(embit_native.base58_decode(s), decode(s))
+        for fn in [decode, embit_native.base58_decode]:
+            with self.assertRaises(ValueError):
+                fn("StV1DL6C0TryKyV")
+
+    @skipIf(NO_NATIVE, MSG)
+    def test_xoshiro(self):
+        next_ = pure("xoshiro_next", xoshiro256.Xoshiro256.next)
+        for seed in [bytes(32), bytes(range(32))]:
+            rng1 = xoshiro256.Xoshiro256.from_bytes(seed)
+            rng2 = xoshiro256.Xoshiro256.from_bytes(seed)
+            for _ in range(100):
+                self.assertEqual(embit_native.xoshiro_next(rng2), next_(rng1))
+
+    @skipIf(NO_NATIVE, MSG)
+    def test_bytewords(self):
+        encode = pure("bytewords_stream_encode", bytewords.stream_encode)
+        decode = pure("bytewords_stream_decode", bytewords.stream_decode)
+        data = bytes(range(256))
+        for l in [1, 17, 256]:
+            pure_out, native = BytesIO(), BytesIO()
+            self.assertEqual(
+                embit_native.bytewords_stream_encode(BytesIO(data), l, native),
+                encode(BytesIO(data), l, pure_out),
+            )
+            encoded = pure_out.getvalue()
+            self.assertEqual(native.getvalue(), encoded)
+            pure_out, native = BytesIO(), BytesIO()
+            self.assertEqual(
+                embit_native.bytewords_stream_decode(BytesIO(encoded), native),
+                decode(BytesIO(encoded), pure_out),
+            )
+            self.assertEqual(native.getvalue(), pure_out.getvalue())
+            self.assertEqual(native.getvalue(), data[:l])
+
+    @skipIf(NO_NATIVE, MSG)
+    def test_interpolate(self):
+        cls = slip39.ShareSet
+        interpolate = pure("slip39_interpolate", cls.interpolate)
+        share_data = [(i, bytes(words(32, 8, i))) for i in [0, 1, 5, 200]]
+        for x in [255, 254, 3]:
+            self.assertEqual(
+                embit_native.slip39_interpolate(cls, x, share_data),
+                interpolate(x, share_data),
+            )
+
+    @skipIf(NO_NATIVE, MSG)
+    def test_install(self):
+        """install() replaces functions once and keeps the originals"""
+        embit_native.install()
+        polymod = embit_native.originals["bech32_polymod"]
+        embit_native.install()
+        self.assertIs(embit_native.originals["bech32_polymod"], polymod)
+        self.assertIs(bech32.bech32_polymod, embit_native.bech32_polymod)
+        self.assertIs(base58.encode, embit_native.base58_encode)
+        self.assertIsNot(polymod, embit_native.bech32_polymod)
+        # modules call native versions internally
+        addr = "bc1qar0srrr7xfkvy5l643lydnw9re59gtzzwf5mdq"
+        ver, prog = bech32.decode("bc", addr)
+        self.assertEqual(bech32.encode("bc", ver, prog), addr)
@@ -5,8 +5,12 @@ from binascii import hexlify, unhexlify
 from embit.bip32 import HDKey
 from embit.ec import PublicKey
 from embit.psbt import PSBT
+from embit.script import Script
+from embit.transaction import SIGHASH
 from unittest import TestCase
 
+PUB = "029583bf39ae0a609747ad199addd634fa6108559d6c5cd39b4c2183f1ab96e07f"
+
 INVALID_VECTORS = [
     # Case: Network transaction, not PSBT format
     "0200000001268171371edff285e937adeea4b37b78000c0566cbb3ad64641713ca42171bf6000000006a473044022070b2245123e6bf474d60c5b50c043d4c691a5d2435f09a34a7662a9dc251790a022001329ca9dacf280bdf30740ec0390422422c81cb45839457aeb76fc12edd95b3012102657d118d3357b8e0f4c2cd46db7b39f6d9c38d9a70abcb9b2de5dc8dbfe4ce31feffffff02d3dff505000000001976a914d0c59903c5bac2868760e90fd521a4665aa7652088ac00e1f5050000000017a9143545e6e33b832c47050f24d3eeb93c9c03948bc787b32e1300",
@@ -113,3 +117,40 @@ class PSBTTest(TestCase):
                 self.assertEqual(
                     hexlify(act_sig).decode("utf-8"), exp_partial_sigs[i][act_pub_str]
                 )
+
+
+class SerializeTest(TestCase):
+    def check(self, obj, *args):
+        ser = obj.serialize(*args)
+        self.assertEqual(obj.serialized_len(*args), len(ser))
+        buf = bytearray(len(ser) + 3)
+        self.assertEqual(obj.serialize_into(buf, 3, *args), len(ser))
+        self.assertEqual(bytes(buf[3:]), ser)
+
+    def test_serialized_len(self):
+        """serialized_len() and serialize_into() match serialize()"""
+        for psbt_str in VALID_VECTORS:
+            psbt = PSBT.parse(unhexlify(psbt_str))
+            self.check(psbt)
+            tx = psbt.tx
+            self.check(tx)
+            for inp in tx.vin:
+                self.check(inp)
+                self.check(inp, Script(b""), SIGHASH.NONE)
+            for out in tx.vout:
+                self.check(out)
+                self.check(out.script_pubkey)
+            for xpub in psbt.xpubs:
+                self.check(xpub)
+                self.check(psbt.xpubs[xpub])
+            for scope in psbt.inputs + psbt.outputs:
+                self.check(scope)
+                for pub in scope.bip32_derivations:
+                    self.check(pub)
+                    self.check(scope.bip32_derivations[pub])
+            for inp in psbt.inputs:
+                if inp.final_scriptwitness is not None:
+                    self.check(inp.final_scriptwitness)
+                if inp.non_witness_utxo is not None:
+                    self.check(inp.non_witness_utxo)
+        self.check(PublicKey(PublicKey.parse(unhexlify(PUB))._point, compressed=False))
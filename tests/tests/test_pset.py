@@ -0,0 +1,175 @@
+from unittest import TestCase
+from io import BytesIO
+from embit import ec, script
+from embit.hashes import sha256
+from embit.liquid import pset as pset_module
+from embit.liquid.pset import PSET, LInputScope, LOutputScope, blinding_factors
+from embit.liquid.psetview import PSETView
+from embit.liquid.transaction import LSIGHASH, LTransactionOutput
+from embit.psbt import PSBTError
+
+SPK = script.Script(b"\x00\x14" + bytes(20))
+ASSET = sha256(b"asset")
+SEED = sha256(b"seed")
+# order of secp256k1 group
+N = 0xFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEBAAEDCE6AF48A03BBFD25E8CD0364141
+
+
+def make_pset(num_outputs):
+    """PSETv2 with fake commitments and proofs, enough for sighash"""
+    pset = PSET(version=2)
+    pset.tx_version = 2
+    pset.locktime = 0
+    for i in range(2):
+        inp = LInputScope()
+        inp.txid = sha256(bytes([i]))
+        inp.vout = i
+        inp.witness_utxo = LTransactionOutput(b"\x01" + bytes(32), 1000, SPK)
+        pset.inputs.append(inp)
+    for i in range(num_outputs):
+        out = LOutputScope()
+        out.script_pubkey = SPK
+        out.value = 10
+        out.asset = bytes(32)
+        # every other output is confidential
+        if i % 2 == 0:
+            out.value_commitment = b"\x08" + sha256(bytes([i]))
+            out.asset_commitment = b"\x0a" + sha256(bytes([i + 1]))
+            out.ecdh_pubkey = b"\x02" + bytes(32)
+            # longer than PSETView.HASH_CHUNK
+            out.range_proof = bytes(range(256)) * (3 + i)
+            out.surjection_proof = bytes(67 + i)
+        pset.outputs.append(out)
+    return pset
+
+
+def make_blindable_pset(num_outputs):
+    """PSETv2 with unconfidential inputs, confidential outputs and a fee"""
+    pset = PSET(version=2)
+    pset.tx_version = 2
+    pset.locktime = 0
+    for i in range(2):
+        inp = LInputScope()
+        inp.txid = sha256(bytes([i]))
+        inp.vout = i
+        inp.sequence = 0xFFFFFFFF
+        inp.witness_utxo = LTransactionOutput(ASSET, 1000, SPK)
+        pset.inputs.append(inp)
+    for i in range(num_outputs):
+        out = LOutputScope()
+        out.script_pubkey = SPK
+        out.value = (2000 - 100) // num_outputs
+        out.asset = ASSET
+        out.blinding_pubkey = ec.PrivateKey(sha256(bytes([i]))).sec()
+        pset.outputs.append(out)
+    fee = LOutputScope()
+    fee.script_pubkey = script.Script(b"")
+    fee.value = 2000 - sum(out.value for out in pset.outputs)
+    fee.asset = ASSET
+    pset.outputs.append(fee)
+    return pset
+
+
+def stream_blind(raw, start_output=0, prefix=b""):
+    """Runs PSETView.blind and returns written bytes and yielded offsets"""
+    psetv = PSETView.view(BytesIO(raw))
+    b = BytesIO(prefix)
+    b.seek(0, 2)
+    offsets = [
+        len(prefix) + res for _, res in psetv.blind(SEED, b, start_output=start_output)
+    ]
+    return b.getvalue(), offsets
+
+
+class PSETViewTest(TestCase):
+    def test_sighash(self):
+        """PSETView sighash with rangeproofs matches PSET"""
+        for n in [1, 5, 8]:
+            pset = make_pset(n)
+            psetv = PSETView.view(BytesIO(pset.serialize()))
+            for sh in [LSIGHASH.ALL, LSIGHASH.ALL | LSIGHASH.RANGEPROOF]:
+                for i in range(2):
+                    self.assertEqual(
+                        pset.sighash_segwit(i, SPK, 1000, sh),
+                        psetv.sighash_segwit(i, SPK, 1000, sh),
+                    )
+
+    def test_unblind_cache(self):
+        """Resumed blinding doesn't unblind inputs again"""
+        calls = []
+
+        def unblind(*args):
+            calls.append(args)
+            raise ValueError("Can't unblind")
+
+        pset = make_blindable_pset(2)
+        for inp in pset.inputs:
+            inp.range_proof = bytes(300)
+        raw = pset.serialize()
+        key = ec.PrivateKey(b"\x11" * 32)
+        orig = pset_module.unblind
+        pset_module.unblind = unblind
+        try:
+            psetv = PSETView.view(BytesIO(raw))
+            results = []
+            for start in range(3):
+                b = BytesIO()
+                for _ in psetv.blind(SEED, b, blinding_key=key, start_output=start):
+                    pass
+                results.append(b.getvalue())
+            self.assertEqual(len(calls), 2)
+            # same result as without the cache
+            pset = PSET.parse(raw)
+            pset.unblind(key)
+            pset.blind(SEED)
+            self.assertEqual(results[0], pset.serialize())
+            # other key unblinds again
+            psetv.unblind_input(0, ec.PrivateKey(b"\x22" * 32))
+            self.assertEqual(len(calls), 5)
+        finally:
+            pset_module.unblind = orig
+
+    def test_blind(self):
+        """Streaming blinding gives the same PSET as PSET.blind"""
+        for n in [1, 3]:
+            raw = make_blindable_pset(n).serialize()
+            pset = PSET.parse(raw)
+            pset.blind(SEED)
+            res, offsets = stream_blind(raw)
+            self.assertEqual(res, pset.serialize())
+            # one yield per output, including the fee
+            self.assertEqual(len(offsets), n + 1)
+            self.assertEqual(offsets[-1], len(res))
+
+    def test_blind_resume(self):
+        """Blinding can be resumed from any output"""
+        raw = make_blindable_pset(3).serialize()
+        full, offsets = stream_blind(raw)
+        for k in range(1, len(offsets)):
+            res, _ = stream_blind(raw, start_output=k, prefix=full[: offsets[k - 1]])
+            self.assertEqual(res, full)
+        with self.assertRaises(PSBTError):
+            stream_blind(raw, start_output=len(offsets) + 1)
+
+    def test_blinding_factors(self):
+        """Blinding factors of outputs balance unconfidential inputs"""
+        raw = make_blindable_pset(3).serialize()
+        pset = PSET.parse(stream_blind(raw)[0])
+        txseed = PSETView.view(BytesIO(raw)).txseed(SEED)
+        self.assertEqual(txseed, pset.txseed(SEED))
+        total = 0
+        for i, out in enumerate(pset.outputs[:-1]):
+            abf, vbf = blinding_factors(txseed, i)
+            self.assertEqual(out.asset_blinding_factor, abf)
+            # only the last blinded output gets a balancing factor
+            if i < 2:
+                self.assertEqual(out.value_blinding_factor, vbf)
+            else:
+                self.assertNotEqual(out.value_blinding_factor, vbf)
+            self.assertTrue(out.is_blinded)
+            total += out.value * int.from_bytes(abf, "big")
+            total += int.from_bytes(out.value_blinding_factor, "big")
+        # inputs are unconfidential - blinding factors are zero
+        self.assertEqual(total % N, 0)
+        # fee is not blinded
+        self.assertIsNone(pset.outputs[-1].value_blinding_factor)
@@ -0,0 +1,102 @@
+from unittest import TestCase
+import sdram
+
+
+class SDRAMTest(TestCase):
+    def test_heap(self):
+        """add_heap() takes the top of SDRAM from RAMDevice"""
+        # single test as SDRAM heap can be added only once
+        self.assertEqual(sdram.heap_info(), None)
+        with self.assertRaises(ValueError):
+            sdram.heap_first(True)
+        with self.assertRaises(ValueError):
+            sdram.add_heap(0)
+        # rounded up to 4K
+        size = sdram.add_heap(0x100001)
+        self.assertEqual(size, 0x101000)
+        start, heap_size = sdram.heap_info()
+        self.assertEqual(heap_size, size)
+        with self.assertRaises(ValueError):
+            sdram.add_heap(0x1000)
+
+        self.assertEqual(sdram.heap_first(True), False)
+        self.assertEqual(sdram.heap_first(False), True)
+        self.assertEqual(sdram.heap_first(), False)
+
+        bdev = sdram.RAMDevice(512)
+        self.assertEqual(bdev.ioctl(5, None), 512)
+        self.assertEqual(bdev.ioctl(4, None), (start - 0xC03EE000) // 512)
+        data = bytes(range(256)) * 4
+        bdev.writeblocks(3, data)
+        buf = bytearray(1024)
+        bdev.readblocks(3, buf)
+        self.assertEqual(bytes(buf), data)
+        with self.assertRaises(ValueError):
+            bdev.readblocks(bdev.ioctl(4, None) - 1, buf)
+
+        # extended block protocol: offset writes and ioctls used by littlefs
+        bdev.writeblocks(1, bytes(512))
+        # partial write across the block boundary
+        bdev.writeblocks(1, b"hello", 510)
+        buf = bytearray(4)
+        bdev.readblocks(2, buf)
+        self.assertEqual(bytes(buf), b"llo\x00")
+        buf = bytearray(2)
+        bdev.readblocks(1, buf, 510)
+        self.assertEqual(bytes(buf), b"he")
+        for op in (1, 2, 3):
+            self.assertEqual(bdev.ioctl(op, 0), 0)
+        self.assertEqual(bdev.ioctl(6, 1), 0)
+        self.assertNotEqual(bdev.ioctl(6, bdev.ioctl(4, None)), 0)
+        count = bdev.ioctl(4, None)
+        with self.assertRaises(ValueError):
+            bdev.writeblocks(count - 1, b"ab", 511)
+
+    def test_arena(self):
+        sdram.arena_reset()
+        a = sdram.alloc("a", 100)
+        self.assertEqual(len(a), 100)
+        a[0] = 0x42
+        # same name shares the memory
+        self.assertEqual(sdram.alloc("a", 50)[0], 0x42)
+        with self.assertRaises(ValueError):
+            sdram.alloc("a", 1000)
+        b = sdram.alloc("b", 1000)
+        stats = sdram.arena_stats()
+        self.assertEqual(stats["regions"], 2)
+        self.assertEqual(stats["used"], 128 + 1024)
+        # freed block is reused and split
+        sdram.free("a")
+        sdram.alloc("c", 32)
+        self.assertEqual(sdram.arena_stats()["used"], 32 + 1024)
+        # freeing everything returns memory to the bump pointer
+        sdram.free("b")
+        sdram.free("c")
+        stats = sdram.arena_stats()
+        self.assertEqual(stats["used"], 0)
+        self.assertEqual(stats["largest_free"], stats["size"])
+        with self.assertRaises(ValueError):
+            sdram.free("c")
+        with self.assertRaises(MemoryError):
+            sdram.alloc("big", stats["size"] + 1)
+        # names are copied into fixed-size slots
+        for name in ["", "x" * 32]:
+            with self.assertRaises(ValueError):
+                sdram.alloc(name, 64)
+        long_name = "x" * 31
+        self.assertEqual(len(sdram.alloc(long_name, 64)), 64)
+        sdram.free(long_name)
+        sdram.alloc("d", 64)
+        sdram.arena_reset()
+        self.assertEqual(sdram.arena_stats()["regions"], 0)
+
+    def test_ramdevice_shared(self):
+        """RAMDevice instances use the same SDRAM"""
+        a = sdram.RAMDevice(512)
+        b = sdram.RAMDevice(512)
+        a.writeblocks(5, b"\x42" * 512)
+        buf = bytearray(512)
+        b.readblocks(5, buf)
+        # unix port without ffi keeps blocks per instance
+        if getattr(a, "_mem", True) is not None:
+            self.assertEqual(bytes(buf), b"\x42" * 512)
@@ -0,0 +1,52 @@
+from unittest import TestCase
+from io import BytesIO
+from embit import script
+from embit.hashes import sha256, double_sha256
+from embit.psbt import PSBT
+from embit.psbtview import PSBTView
+from embit.transaction import Transaction, TransactionInput, TransactionOutput, SIGHASH
+
+NUM_INPUTS = 7
+SPK = script.Script(b"\x76\xa9\x14" + bytes(20) + b"\x88\xac")
+
+
+def make_tx():
+    vin = [
+        TransactionInput(sha256(bytes([i])), i, sequence=0xFFFFFFFF - i)
+        for i in range(NUM_INPUTS)
+    ]
+    vout = [TransactionOutput(1000 * (i + 1), SPK) for i in range(3)]
+    return Transaction(version=1, vin=vin, vout=vout, locktime=123)
+
+
+def reference(tx, i, sc, sighash):
+    """Serializes the whole tx with substituted script like Bitcoin Core"""
+    copy = Transaction.parse(tx.serialize())
+    for j, inp in enumerate(copy.vin):
+        inp.script_sig = sc if j == i else script.Script(b"")
+    return double_sha256(copy.serialize() + sighash.to_bytes(4, "little"))
+
+
+class LegacySighashTest(TestCase):
+    def test_transaction(self):
+        tx = make_tx()
+        sc = script.Script(b"\x51")
+        # in order, backwards and repeated to check midstate
+        order = list(range(NUM_INPUTS)) + list(reversed(range(NUM_INPUTS))) + [3, 3]
+        for sh in [SIGHASH.ALL, SIGHASH.DEFAULT]:
+            for i in order:
+                self.assertEqual(
+                    tx.sighash_legacy(i, sc, sh), reference(tx, i, sc, sh)
+                )
+
+    def test_psbtview(self):
+        tx = make_tx()
+        sc = script.Script(b"\x51")
+        for version in [None, 2]:
+            psbt = PSBT(tx)
+            psbt.version = version
+            psbtv = PSBTView.view(BytesIO(psbt.serialize()))
+            for i in [0, 4, 2, 6]:
+                self.assertEqual(
+                    psbtv.sighash_legacy(i, sc), reference(tx, i, sc, SIGHASH.ALL)
+                )
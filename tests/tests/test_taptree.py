@@ -0,0 +1,50 @@
+from unittest import TestCase
+from embit import bip32
+from embit.hashes import sha256, tagged_hash
+from embit.descriptor import Descriptor
+
+KEYS = [
+    bip32.HDKey.from_seed(sha256(bytes([i]))).to_public().to_base58()
+    for i in range(4)
+]
+# left branch has derivable and static leaves, right branch only derivable
+DESC = "tr(%s/<0;1>/*,{{pk(%s/<0;1>/*),and_v(v:pk(%s),older(10))},pk(%s/0/*)})" % (
+    KEYS[0],
+    KEYS[1],
+    KEYS[2],
+    KEYS[3],
+)
+
+
+class TapTreeTest(TestCase):
+    def test_derive_cache(self):
+        desc = Descriptor.from_string(DESC)
+        d1 = desc.derive(3, branch_index=1)
+        d2 = desc.derive(3, branch_index=1)
+        self.assertTrue(d1.taptree is d2.taptree)
+        d3 = desc.derive(4, branch_index=1)
+        # leaf without derivable keys is shared between indexes
+        static1 = d1.taptree.tree[0].tree[1].tree
+        static3 = d3.taptree.tree[0].tree[1].tree
+        self.assertTrue(static1 is static3)
+        self.assertFalse(d1.taptree.tree[1] is d3.taptree.tree[1])
+
+    def test_merkle_root(self):
+        """Cached tree gives the same script_pubkey as a freshly parsed one"""
+        desc = Descriptor.from_string(DESC)
+        for idx in range(3):
+            for branch in [0, 1]:
+                derived = desc.derive(idx, branch_index=branch)
+                # call twice to hit the cache
+                derived.script_pubkey()
+                fresh = Descriptor.from_string(str(derived))
+                self.assertEqual(derived.script_pubkey(), fresh.script_pubkey())
+                self.assertEqual(derived.taptree.tweak(), fresh.taptree.tweak())
+
+    def test_leaf_hashes(self):
+        tree = Descriptor.from_string(DESC).derive(1).taptree
+        hashes = tree.leaf_hashes()
+        self.assertEqual(len(hashes), 3)
+        for leaf, _ in tree.compile()[0]:
+            sc = leaf.script() + bytes([leaf.version])
+            self.assertEqual(hashes[sc], tagged_hash("TapLeaf", leaf.serialize()))
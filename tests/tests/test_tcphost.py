@@ -0,0 +1,178 @@
+from unittest import TestCase
+import hashlib
+import select
+import socket
+import time
+import pyb
+from io import BytesIO
+
+# size of a large PSBT transferred through the emulated UART
+PSBT_SIZE = 2 * 1024 * 1024
+CHUNK = 4096
+# fail instead of hanging the suite if the socket stalls
+TIMEOUT_MS = 30000
+
+
+class TCPHostTest(TestCase):
+    def setUp(self):
+        self.uart = None
+        self.client = None
+
+    def tearDown(self):
+        if self.client is not None:
+            self.client.close()
+        if self.uart is not None:
+            if self.uart.client is not None:
+                self.uart.client.close()
+            self.uart.socket.close()
+
+    def connect(self):
+        uart = pyb.UART("YA")
+        self.uart = uart
+        # nothing to poll until a client connects
+        self.assertEqual(uart.fileno(), -1)
+        client = socket.socket()
+        self.client = client
+        client.connect(socket.getaddrinfo("127.0.0.1", uart.port)[0][-1])
+        for _ in range(100):
+            if uart.isconnected():
+                break
+            time.sleep_ms(10)
+        self.assertEqual(uart.isconnected(), True)
+        self.assertEqual(uart.fileno(), uart.client.fileno())
+        return uart, client
+
+    def test_poll(self):
+        """host can be awaited with select.poll instead of busy polling"""
+        uart, client = self.connect()
+        self.assertEqual(uart.read(), None)
+        poller = select.poll()
+        poller.register(uart, select.POLLIN)
+        self.assertEqual(poller.poll(0), [])
+        client.write(b"hello")
+        self.assertEqual(len(poller.poll(1000)), 1)
+        self.assertEqual(uart.read(2), b"he")
+        buf = bytearray(10)
+        self.assertEqual(uart.readinto(buf), 3)
+        self.assertEqual(bytes(buf[:3]), b"llo")
+
+    def test_throughput(self):
+        """multi-megabyte PSBT goes through the ring buffer intact"""
+        uart, client = self.connect()
+        chunk = bytes(i % 251 for i in range(CHUNK))
+        # read size is not aligned to chunks, so the ring buffer wraps
+        buf = bytearray(3000)
+        h = hashlib.sha256()
+        received = 0
+        t0 = time.ticks_ms()
+        for i in range(PSBT_SIZE // CHUNK):
+            client.write(chunk)
+            # wait until the chunk arrives
+            while received + uart.any() < (i + 1) * CHUNK:
+                if time.ticks_diff(time.ticks_ms(), t0) > TIMEOUT_MS:
+                    self.fail("Timeout after %d bytes" % (received + uart.any()))
+            while uart.any() >= len(buf):
+                received += uart.readinto(buf)
+                h.update(buf)
+        while received < PSBT_SIZE:
+            n = uart.readinto(buf)
+            h.update(buf[:n])
+            received += n
+        self.assertEqual(received, PSBT_SIZE)
+        expected = hashlib.sha256()
+        for _ in range(PSBT_SIZE // CHUNK):
+            expected.update(chunk)
+        self.assertEqual(h.digest(), expected.digest())
+
+    def test_asyncio_stream(self):
+        """PSBT streams into a file and SDRAM while other tasks keep running"""
+        import asyncio
+        import sdram
+
+        uart, client = self.connect()
+        size = 256 * 1024
+        chunk = bytes(i % 251 for i in range(CHUNK))
+        reader, writer = asyncio.open_host(uart, rxbuf=1024)
+        ticks = [0]
+
+        async def send():
+            for _ in range(size // CHUNK):
+                client.write(chunk)
+                await asyncio.sleep_ms(0)
+
+        async def ui():
+            while True:
+                ticks[0] += 1
+                await asyncio.sleep_ms(0)
+
+        async def receive(out, progress=None):
+            asyncio.create_task(send())
+            return await reader.copy_to(out, size, progress)
+
+        async def main(out, progress=None):
+            t = asyncio.create_task(ui())
+            try:
+                return await receive(out, progress)
+            finally:
+                t.cancel()
+
+        # into a file
+        f = BytesIO()
+        steps = []
+        self.assertEqual(asyncio.run(main(f, steps.append)), size)
+        self.assertEqual(f.getvalue(), chunk * (size // CHUNK))
+        self.assertEqual(steps[-1], size)
+        self.assertTrue(ticks[0] >= len(steps))
+
+        # into SDRAM without intermediate copies
+        buf = sdram.alloc("test_stream", size)
+        try:
+            self.assertEqual(asyncio.run(main(buf)), size)
+            self.assertEqual(bytes(buf[: 2 * CHUNK]), chunk * 2)
+            self.assertEqual(bytes(buf[size - CHUNK :]), chunk)
+        finally:
+            sdram.free("test_stream")
+
+        # and back to the host
+        writer.write(b"ok")
+        asyncio.run(writer.drain())
+        self.assertEqual(asyncio.run(writer.copy_from(BytesIO(chunk))), CHUNK)
+        received = b""
+        while len(received) < CHUNK + 2:
+            received += client.recv(CHUNK)
+        self.assertEqual(received, b"ok" + chunk)
+
+    def test_asyncio_lines(self):
+        """readline() is limited, drain() keeps up to txlow bytes pending"""
+        import asyncio
+
+        uart, client = self.connect()
+        reader, writer = asyncio.open_host(uart, txlow=64)
+
+        async def lines():
+            res = [await reader.readline()]
+            try:
+                await reader.readline(16)
+            except ValueError:
+                res.append(None)
+            # the rest of the long line is still there
+            res.append(await reader.readline())
+            return res
+
+        client.write(b"hello\n" + b"x" * 20 + b"\nend\n")
+        self.assertEqual(asyncio.run(lines()), [b"hello\n", None, b"xxxx\n"])
+        self.assertEqual(asyncio.run(reader.readline()), b"end\n")
+
+        writer.write(b"a" * 10)
+        asyncio.run(writer.drain())
+        # below the watermark, nothing is sent yet
+        self.assertEqual(writer.out_buf, b"a" * 10)
+        writer.write(b"b" * 100)
+        asyncio.run(writer.drain())
+        self.assertTrue(len(writer.out_buf) <= 64)
+        asyncio.run(writer.flush())
+        self.assertEqual(writer.out_buf, b"")
+        received = b""
+        while len(received) < 110:
+            received += client.recv(110)
+        self.assertEqual(received, b"a" * 10 + b"b" * 100)
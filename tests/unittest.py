@@ -1,4 +1,5 @@
 import sys
+import gc
 
 
 class SkipTest(Exception):
@@ -20,6 +21,47 @@ class AssertRaisesContext:
         return False
 
 
+class MemoryBudgetContext:
+    """
+    Checks that heap usage above the level at enter stays below limit.
+    Call sample() where the code is expected to use the most memory,
+    i.e. from stream callbacks. Every sample collects garbage first,
+    so only live objects are counted.
+    """
+
+    def __init__(self, limit, msg=""):
+        self.limit = limit
+        self.msg = msg
+        self.peak = 0
+
+    def __enter__(self):
+        gc.collect()
+        self.start = gc.mem_alloc()
+        return self
+
+    def sample(self):
+        gc.collect()
+        used = gc.mem_alloc() - self.start
+        if used > self.peak:
+            self.peak = used
+
+    def __exit__(self, exc_type, exc_value, tb):
+        if exc_type is not None:
+            return False
+        self.sample()
+        if self.peak > self.limit:
+            # heap details help to find what was kept
+            try:
+                import micropython
+
+                micropython.mem_info()
+            except ImportError:
+                pass
+            msg = self.msg or "peak heap %d bytes is above %d" % (self.peak, self.limit)
+            assert False, msg
+        return False
+
+
 class TestCase:
     def fail(self, msg=""):
         assert False, msg
@@ -112,6 +154,9 @@ class TestCase:
     def assertIsInstance(self, x, y, msg=""):
         assert isinstance(x, y), msg
 
+    def assertMemoryBudget(self, limit, msg=""):
+        return MemoryBudgetContext(limit, msg)
+
     def assertRaises(self, exc, func=None, *args, **kwargs):
         if func is None:
             return AssertRaisesContext(exc)
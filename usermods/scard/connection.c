@@ -14,9 +14,12 @@
 #include "py/mperrno.h"
 #include "py/mphal.h"
 #include "py/smallint.h"
-#include "modmachine.h"
+#include "py/stream.h"
 #include "protocols.h"
 #include "scard.h"
+#if SCARD_HAS_MACHINE_TIMER
+#include "modmachine.h"
+#endif
 #include "connection.h"
 #include "reader.h"
 
@@ -58,6 +61,13 @@ typedef enum event_type_ {
   event_error      = MP_QSTR_error       ///< Error
 } event_type_t;
 
+/// Asynchronous operation awaited with uasyncio
+typedef enum async_op_ {
+  async_op_none = 0, ///< No operation
+  async_op_connect,  ///< Connection in progress
+  async_op_transmit  ///< Waiting for response APDU
+} async_op_t;
+
 /// Event as a set of arguments of observer
 typedef struct event_ {
   /// Buffer with arguments of observer
@@ -92,10 +102,23 @@ typedef struct connection_obj_ {
   mp_int_t next_protocol;        ///< ID of the protocol for the next op.
   uint16_t presence_cycles;      ///< Counter of card presence cycles (debounce)
   bool presence_state;           ///< Card presence state
+  async_op_t async_op;           ///< Pending asynchronous operation
+  const char* error_text;        ///< Text of the last error
+  bool rsp_raw;                  ///< Return response as a single bytes object
+  mp_obj_t rsp_into;             ///< Buffer receiving raw response or NULL
+  bool reset_pending;            ///< Warm reset requested by the protocol
 } connection_obj_t;
 
+/// Awaitable object returned by asynchronous methods of CardConnection
+typedef struct async_op_obj_ {
+  mp_obj_base_t base;            ///< Pointer to type of base class
+  connection_obj_t* connection;  ///< Connection performing the operation
+} async_op_obj_t;
+
 /// Type information for CardConnection class
 const mp_obj_type_t scard_CardConnection_type;
+/// Type information for awaitable object of asynchronous operation
+STATIC const mp_obj_type_t async_op_type;
 
 STATIC mp_obj_t connection_disconnect(mp_obj_t self_in);
 
@@ -200,6 +223,9 @@ static void notify_observers(connection_obj_t* self, event_type_t event_type) {
 static void notify_observers_text(connection_obj_t* self,
                                   event_type_t event_type,
                                   const char* text) {
+  if(!list_get_len(self->observers)) {
+    return; // Nobody listens, do not allocate event objects
+  }
   mp_obj_t text_obj = mp_obj_new_str(text, strlen(text));
   mp_obj_t args_list = mp_obj_new_list(1U, &text_obj);
   mp_obj_t args[] =  {
@@ -217,6 +243,9 @@ static void notify_observers_text(connection_obj_t* self,
  * @param bytes  command data
  */
 static void notify_observers_command(connection_obj_t* self, mp_obj_t bytes) {
+  if(!list_get_len(self->observers)) {
+    return; // Nobody listens, do not allocate event objects
+  }
   // Make a list with arguments [bytes, protocol]
   protocol_t protocol_id = self->protocol ? self->protocol->id : protocol_na;
   mp_obj_list_t* args_list = mp_obj_new_list(2U, NULL);
@@ -270,6 +299,32 @@ static mp_obj_t make_response_list(const uint8_t* data, size_t len) {
   return MP_OBJ_TO_PTR(response);
 }
 
+/**
+ * Creates a response in the format requested by transmit()
+ *
+ * Raw response is either a single bytes object [data..., sw1, sw2] or it is
+ * copied into the buffer provided by caller. In the last case no objects are
+ * allocated, the buffer receives as much as fits and full length of response
+ * is returned.
+ *
+ * @param self  instance of CardConnection class
+ * @param data  smart card response data
+ * @param len   number of data bytes
+ * @return      response object
+ */
+static mp_obj_t make_response(connection_obj_t* self, const uint8_t* data,
+                              size_t len) {
+  if(MP_OBJ_NULL != self->rsp_into) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(self->rsp_into, &bufinfo, MP_BUFFER_WRITE);
+    memcpy(bufinfo.buf, data, (len < bufinfo.len) ? len : bufinfo.len);
+    return MP_OBJ_NEW_SMALL_INT(len);
+  } else if(self->rsp_raw) {
+    return mp_obj_new_bytes(data, len);
+  }
+  return make_response_list(data, len);
+}
+
 /**
  * Callback function that outputs bytes to serial port
  *
@@ -283,6 +338,25 @@ static bool proto_cb_serial_out(mp_obj_t self_in, const uint8_t* buf,
   return scard_tx_write(self->sc_handle, buf, len);
 }
 
+/**
+ * Handles a connection error
+ *
+ * @param self  instance of CardConnection class
+ * @param text  error text
+ */
+static void handle_error(connection_obj_t* self, const char* text) {
+  connection_disconnect(self);
+  self->state = state_error;
+  self->error_text = text;
+  notify_observers_text(self, event_error, text);
+  // Error of asynchronous operation is raised in the awaiting task
+  if(self->raise_on_error ||
+     (self->blocking && async_op_none == self->async_op)) {
+    self->raise_on_error = false;
+    raise_SmartcardException(text);
+  }
+}
+
 /**
  * Callback function that handles protocol events
  *
@@ -313,24 +387,40 @@ static void proto_cb_handle_event(mp_obj_t self_in, proto_ev_code_t ev_code,
 
     case proto_ev_apdu_received:
       if(state_connected == self->state) {
-        mp_obj_t response = make_response_list(prm.apdu_received->apdu,
-                                                prm.apdu_received->len);
-        notify_observers_response(self, response);
-        if(self->blocking) {
+        const uint8_t* apdu = prm.apdu_received->apdu;
+        size_t len = prm.apdu_received->len;
+        mp_obj_t response = MP_OBJ_NULL;
+        if(self->blocking || async_op_transmit == self->async_op) {
+          response = make_response(self, apdu, len);
           self->response = response;
         }
+        // Observers always receive a list, it is shared when possible
+        if(list_get_len(self->observers)) {
+          if(MP_OBJ_NULL == response || self->rsp_raw) {
+            response = make_response_list(apdu, len);
+          }
+          notify_observers_response(self, response);
+        }
       }
       break;
 
-    case proto_ev_error:
-      connection_disconnect(self);
-      self->state = state_error;
-      notify_observers_text(self, event_error, prm.error);
-      if(self->raise_on_error || self->blocking) {
-        self->raise_on_error = false;
-        raise_SmartcardException(prm.error);
+    case proto_ev_rate_changed:
+      if(!scard_interface_set_etu(self->sc_handle, prm.rate_changed->f,
+                                  prm.rate_changed->d)) {
+        handle_error(self, "transmission rate not supported");
       }
       break;
+
+    case proto_ev_reset_request:
+      // The protocol is still running, the reset is done by timer_task()
+      if(state_connecting == self->state) {
+        self->reset_pending = true;
+      }
+      break;
+
+    case proto_ev_error:
+      handle_error(self, prm.error);
+      break;
   }
 }
 
@@ -356,8 +446,9 @@ static void handle_card_presence_change(connection_obj_t* self,
         // Handle unexpected card removal
         connection_disconnect(self);
         self->state = state_error;
+        self->error_text = err_unexp_removal;
         notify_observers_text(self, event_error, err_unexp_removal);
-        if(self->blocking) {
+        if(self->blocking && async_op_none == self->async_op) {
           raise_SmartcardException(err_unexp_removal);
         }
       }
@@ -414,6 +505,23 @@ static void card_detection_task(connection_obj_t* self) {
   }
 }
 
+/**
+ * Makes warm reset requested by the protocol
+ *
+ * The protocol continues to wait for ATR.
+ * @param self  instance of CardConnection class
+ */
+static void warm_reset(connection_obj_t* self) {
+  self->reset_pending = false;
+  if(state_connecting == self->state && self->protocol) {
+    scard_pin_write(&self->rst_pin, ACT);
+    mp_hal_delay_ms(RESET_TIME_MS);
+    self->protocol->reset(self->proto_handle, true);
+    scard_interface_reset(self->sc_handle);
+    scard_pin_write(&self->rst_pin, INACT);
+  }
+}
+
 /**
  * Timer task
  *
@@ -425,6 +533,10 @@ static void timer_task(connection_obj_t* self) {
     mp_uint_t elapsed = scard_ticks_diff(ticks_ms, self->prev_ticks_ms);
     self->prev_ticks_ms = ticks_ms;
 
+    if(self->reset_pending) {
+      warm_reset(self);
+    }
+
     // Run protocol timer task only when we are connecting or connected
     if(state_connecting == self->state || state_connected == self->state) {
       if(self->protocol) {
@@ -439,6 +551,90 @@ static void timer_task(connection_obj_t* self) {
   }
 }
 
+/**
+ * Receives data from smart card interface and runs timer task
+ *
+ * Drives the protocol when there is no data callback from interface or no
+ * timer, namely in blocking loops and while polled by uasyncio.
+ *
+ * @param self  instance of CardConnection class
+ */
+static void poll_task(connection_obj_t* self) {
+  if(state_connecting == self->state || state_connected == self->state) {
+    uint8_t rx_buf[WAIT_LOOP_RX_BUF_SIZE];
+    size_t n_bytes = scard_rx_readinto(self->sc_handle, rx_buf, sizeof(rx_buf));
+    if(n_bytes == SCARD_RX_OVERRUN) {
+      if(self->protocol) {
+        self->protocol->serial_error(self->proto_handle);
+      }
+    } else if(n_bytes && self->protocol) {
+      self->protocol->serial_in(self->proto_handle, rx_buf, n_bytes);
+    }
+  }
+  timer_task(self);
+}
+
+/**
+ * Checks if pending asynchronous operation is completed
+ *
+ * @param self  instance of CardConnection class
+ * @return      true if operation is completed or there is no operation
+ */
+static bool async_op_done(const connection_obj_t* self) {
+  switch(self->async_op) {
+    case async_op_connect:
+      return state_connecting != self->state;
+
+    case async_op_transmit:
+      return MP_OBJ_NULL != self->response || state_connected != self->state;
+
+    default:
+      return true;
+  }
+}
+
+/**
+ * Completes asynchronous operation returning its result
+ *
+ * Raises SmartcardException if the operation failed.
+ *
+ * @param self  instance of CardConnection class
+ * @return      result of the operation
+ */
+static mp_obj_t async_op_result(connection_obj_t* self) {
+  async_op_t op = self->async_op;
+  self->async_op = async_op_none;
+
+  if(state_connected == self->state) {
+    if(async_op_transmit == op) {
+      // Do not keep references to allow GC to remove objects later
+      mp_obj_t response = self->response;
+      self->response = MP_OBJ_NULL;
+      self->rsp_into = MP_OBJ_NULL;
+      return response;
+    }
+    return mp_const_none;
+  }
+  raise_SmartcardException(self->error_text ? self->error_text :
+                                              "card not connected");
+  return mp_const_none;
+}
+
+/**
+ * Creates awaitable object for asynchronous operation
+ *
+ * @param self  instance of CardConnection class
+ * @param op    operation
+ * @return      awaitable object
+ */
+static mp_obj_t new_async_op(connection_obj_t* self, async_op_t op) {
+  async_op_obj_t* op_obj = m_new_obj(async_op_obj_t);
+  op_obj->base.type = &async_op_type;
+  op_obj->connection = self;
+  self->async_op = op;
+  return MP_OBJ_FROM_PTR(op_obj);
+}
+
 /**
  * __call__ special method running background tasks, usually by timer
  * @param self_in  instance of CardConnection class casted to mp_obj_t
@@ -462,6 +658,7 @@ STATIC mp_obj_t connection_call(mp_obj_t self_in, size_t n_args, size_t n_kw,
  * @return          new instance of machine.Timer
  */
 static mp_obj_t create_timer(connection_obj_t* self, mp_int_t timer_id) {
+#if SCARD_HAS_MACHINE_TIMER
   mp_obj_t args[] =  {
     // Positional arguments
     MP_OBJ_NEW_SMALL_INT(timer_id), // id
@@ -470,6 +667,12 @@ static mp_obj_t create_timer(connection_obj_t* self, mp_int_t timer_id) {
     MP_OBJ_NEW_QSTR(MP_QSTR_period), MP_OBJ_NEW_SMALL_INT(TIMER_PERIOD_MS)
   };
   return machine_timer_type.make_new(&machine_timer_type, 1, 2, args);
+#else
+  // Background tasks run only within blocking calls or by calling the object
+  (void)self;
+  (void)timer_id;
+  return MP_OBJ_NULL;
+#endif
 }
 
 /**
@@ -484,7 +687,11 @@ static void cb_data_rx(mp_obj_t self_in, const uint8_t* buf, size_t len) {
   if(state_connecting == self->state ||
      state_connected  == self->state ) {
     if(self->protocol) {
-      self->protocol->serial_in(self->proto_handle, buf, len);
+      if(len == SCARD_RX_OVERRUN) {
+        self->protocol->serial_error(self->proto_handle);
+      } else {
+        self->protocol->serial_in(self->proto_handle, buf, len);
+      }
     }
   }
 }
@@ -592,6 +799,11 @@ STATIC mp_obj_t connection_make_new(const mp_obj_type_t* type, size_t n_args,
   self->next_protocol = protocol_na;
   self->presence_cycles = 0;
   self->presence_state = false;
+  self->async_op = async_op_none;
+  self->error_text = NULL;
+  self->rsp_raw = false;
+  self->rsp_into = MP_OBJ_NULL;
+  self->reset_pending = false;
   connection_init(self, conn_params);
 
   return MP_OBJ_FROM_PTR(self);
@@ -653,65 +865,54 @@ static void change_protocol(connection_obj_t* self, mp_int_t protocol_id,
  * @param self  instance of CardConnection class
  */
 static inline void wait_connect_blocking(connection_obj_t* self) {
-  uint8_t rx_buf[WAIT_LOOP_RX_BUF_SIZE];
-
   // Loop while the state is not changed in the handler of protocol events or
   // exception is not raised.
   while(self->state == state_connecting) {
-    size_t n_bytes = scard_rx_readinto(self->sc_handle, rx_buf, sizeof(rx_buf));
-    self->protocol->serial_in(self->proto_handle, rx_buf, n_bytes);
-    timer_task(self);
+    poll_task(self);
     MICROPY_EVENT_POLL_HOOK
   }
 }
 
 /**
- * @brief Connects to a smart card
- *
- * .. method:: CardConnection.connect(protocol=None)
+ * Checks that no asynchronous operation is in progress
  *
- *  Connects to a smart card. Arguments:
- *    - *protocol* protocol identifier, if None uses previously selected
- *      protocol (if any), or default protocol if nothing selected
+ * Operation abandoned by a cancelled task does not block the connection once
+ * it is completed.
  *
- * @param n_args    number of arguments
- * @param pos_args  positional arguments
- * @param kw_args   keyword arguments
- * @return          None
+ * @param self  instance of CardConnection class
  */
-STATIC mp_obj_t connection_connect(size_t n_args, const mp_obj_t *pos_args,
-                                   mp_map_t *kw_args) {
-  // Get self
-  assert(n_args >= 1U);
-  connection_obj_t* self = (connection_obj_t*)MP_OBJ_TO_PTR(pos_args[0]);
-
-  // Parse and check arguments
-  enum { ARG_protocol = 0 };
-  static const mp_arg_t allowed_args[] = {
-    { MP_QSTR_protocol, MP_ARG_INT, { .u_int = protocol_na } },
-  };
-  mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
-  mp_arg_parse_all(n_args - 1U, pos_args + 1U, kw_args,
-                   MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+static void check_no_async_op(connection_obj_t* self) {
+  if(async_op_none != self->async_op && !async_op_done(self)) {
+    raise_SmartcardException("operation in progress");
+  }
+  self->async_op = async_op_none;
+}
 
+/**
+ * Starts connection to a smart card
+ *
+ * @param self      instance of CardConnection class
+ * @param protocol  protocol identifier or protocol_na
+ */
+static void start_connect(connection_obj_t* self, mp_int_t protocol) {
   // Check if the state allows connection
   switch(self->state) {
     case state_closed:
       raise_CardConnectionException("connection is closed");
-      return mp_const_none;
+      return;
 
     case state_connecting:
     case state_connected:
       raise_CardConnectionException("already connected");
-      return mp_const_none;
+      return;
 
     default:
       break;
   }
 
   // Change smart card protocol if requested
-  mp_int_t new_protocol = (protocol_na != args[ARG_protocol].u_int) ?
-    args[ARG_protocol].u_int : self->next_protocol;
+  mp_int_t new_protocol = (protocol_na != protocol) ?
+    protocol : self->next_protocol;
   self->next_protocol = protocol_na;
   // If protocol not defined, use default protocol
   new_protocol = (protocol_na == new_protocol) ? protocol_any : new_protocol;
@@ -724,11 +925,46 @@ STATIC mp_obj_t connection_connect(size_t n_args, const mp_obj_t *pos_args,
   scard_pin_write(&self->rst_pin, ACT);
   scard_pin_write(&self->pwr_pin, ACT);
   mp_hal_delay_ms(RESET_TIME_MS);
+  scard_interface_reset(self->sc_handle);
   scard_pin_write(&self->rst_pin, INACT);
 
   // Update state
+  self->error_text = NULL;
+  self->reset_pending = false;
   self->state = state_connecting;
+}
+
+/**
+ * @brief Connects to a smart card
+ *
+ * .. method:: CardConnection.connect(protocol=None)
+ *
+ *  Connects to a smart card. Arguments:
+ *    - *protocol* protocol identifier, if None uses previously selected
+ *      protocol (if any), or default protocol if nothing selected
+ *
+ * @param n_args    number of arguments
+ * @param pos_args  positional arguments
+ * @param kw_args   keyword arguments
+ * @return          None
+ */
+STATIC mp_obj_t connection_connect(size_t n_args, const mp_obj_t *pos_args,
+                                   mp_map_t *kw_args) {
+  // Get self
+  assert(n_args >= 1U);
+  connection_obj_t* self = (connection_obj_t*)MP_OBJ_TO_PTR(pos_args[0]);
 
+  // Parse and check arguments
+  enum { ARG_protocol = 0 };
+  static const mp_arg_t allowed_args[] = {
+    { MP_QSTR_protocol, MP_ARG_INT, { .u_int = protocol_na } },
+  };
+  mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+  mp_arg_parse_all(n_args - 1U, pos_args + 1U, kw_args,
+                   MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+  check_no_async_op(self);
+  start_connect(self, args[ARG_protocol].u_int);
   if(self->blocking) {
     wait_connect_blocking(self);
   }
@@ -736,6 +972,46 @@ STATIC mp_obj_t connection_connect(size_t n_args, const mp_obj_t *pos_args,
   return mp_const_none;
 }
 
+/**
+ * @brief Connects to a smart card asynchronously
+ *
+ * .. method:: CardConnection.connect_async(protocol=None)
+ *
+ *  Awaitable version of connect() for use within uasyncio tasks, works
+ *  regardless of blocking mode:
+ *
+ *  await connection.connect_async()
+ *
+ *  Arguments are the same as for connect(). The protocol is driven by the
+ *  event loop polling the connection, SmartcardException is raised in the
+ *  awaiting task on failure.
+ *
+ * @param n_args    number of arguments
+ * @param pos_args  positional arguments
+ * @param kw_args   keyword arguments
+ * @return          awaitable object
+ */
+STATIC mp_obj_t connection_connect_async(size_t n_args,
+                                         const mp_obj_t *pos_args,
+                                         mp_map_t *kw_args) {
+  // Get self
+  assert(n_args >= 1U);
+  connection_obj_t* self = (connection_obj_t*)MP_OBJ_TO_PTR(pos_args[0]);
+
+  // Parse and check arguments
+  enum { ARG_protocol = 0 };
+  static const mp_arg_t allowed_args[] = {
+    { MP_QSTR_protocol, MP_ARG_INT, { .u_int = protocol_na } },
+  };
+  mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+  mp_arg_parse_all(n_args - 1U, pos_args + 1U, kw_args,
+                   MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+  check_no_async_op(self);
+  start_connect(self, args[ARG_protocol].u_int);
+  return new_async_op(self, async_op_connect);
+}
+
 /**
  * @brief Checks if smart card is inserted
  *
@@ -851,14 +1127,10 @@ STATIC mp_obj_t connection_setTimeouts(size_t n_args, const mp_obj_t *pos_args,
  * @param self  instance of CardConnection class
  */
 static void wait_response_blocking(connection_obj_t* self) {
-  uint8_t rx_buf[WAIT_LOOP_RX_BUF_SIZE];
-
   // Loop while there is no response from the smart card. May be interrupted by
   // an exception raised inside handler of the protocol as well.
   while(self->response == MP_OBJ_NULL) {
-    size_t n_bytes = scard_rx_readinto(self->sc_handle, rx_buf, sizeof(rx_buf));
-    self->protocol->serial_in(self->proto_handle, rx_buf, n_bytes);
-    timer_task(self);
+    poll_task(self);
     MICROPY_EVENT_POLL_HOOK
   }
 }
@@ -891,46 +1163,37 @@ static bool objects_to_buf(uint8_t* buf, const mp_obj_t* objects,
 }
 
 /**
- * @brief Transmit an APDU to the smart card
- *
- * .. method:: CardConnection.transmit(bytes, protocol=None)
- *
- *  Transmit an APDU to the smart card. Arguments:
- *    - *bytes* buffer containing APDU
- *    - *protocol* protocol identifier, if None uses previously selected
- *      protocol (if any), or default protocol if nothing selected
- *
- * @param n_args    number of arguments
- * @param pos_args  positional arguments
- * @param kw_args   keyword arguments
- * @return          None
+ * Starts transmission of an APDU
+ *
+ * @param self          instance of CardConnection class
+ * @param bytes_obj     APDU, a list of integers or object supporting buffer
+ *                      protocol
+ * @param protocol_obj  protocol identifier or None
+ * @param raw           if true response is returned as a single bytes object
+ * @param into_obj      buffer receiving raw response or None
  */
-STATIC mp_obj_t connection_transmit(size_t n_args, const mp_obj_t *pos_args,
-                                    mp_map_t *kw_args) {
-  // Get self
-  assert(n_args >= 1U);
-  connection_obj_t* self = (connection_obj_t*)MP_OBJ_TO_PTR(pos_args[0]);
-
-  // Parse and check arguments
-  enum { ARG_bytes = 0, ARG_protocol };
-  static const mp_arg_t allowed_args[] = {
-    { MP_QSTR_bytes,    MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none}},
-    { MP_QSTR_protocol, MP_ARG_OBJ,                   {.u_obj = mp_const_none}}
-  };
-  mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
-  mp_arg_parse_all(n_args - 1U, pos_args + 1U, kw_args,
-                   MP_ARRAY_SIZE(allowed_args), allowed_args, args);
-
+static void start_transmit(connection_obj_t* self, mp_obj_t bytes_obj,
+                           mp_obj_t protocol_obj, bool raw, mp_obj_t into_obj) {
   // Check connection state
   if(state_connected != self->state) {
     raise_SmartcardException("card not connected");
   }
 
+  // Select format of response
+  self->rsp_raw = raw;
+  self->rsp_into = MP_OBJ_NULL;
+  if(!mp_obj_is_type(into_obj, &mp_type_NoneType)) {
+    mp_buffer_info_t into_info;
+    mp_get_buffer_raise(into_obj, &into_info, MP_BUFFER_WRITE);
+    self->rsp_raw = true;
+    self->rsp_into = into_obj;
+  }
+
   // Change smart card protocol if requested
   mp_int_t new_protocol = self->next_protocol;
   self->next_protocol = protocol_na;
-  if(!mp_obj_is_type(args[ARG_protocol].u_obj, &mp_type_NoneType)) {
-    new_protocol = mp_obj_get_int(args[ARG_protocol].u_obj);
+  if(!mp_obj_is_type(protocol_obj, &mp_type_NoneType)) {
+    new_protocol = mp_obj_get_int(protocol_obj);
   }
   if(new_protocol != protocol_na) {
     change_protocol(self, new_protocol, false, false);
@@ -940,17 +1203,17 @@ STATIC mp_obj_t connection_transmit(size_t n_args, const mp_obj_t *pos_args,
   }
 
   // Notify observers of transmitted command
-  notify_observers_command(self, args[ARG_bytes].u_obj);
+  notify_observers_command(self, bytes_obj);
 
   // Get data buffer of 'bytes' argument
   mp_buffer_info_t bufinfo = { .buf = NULL, .len = 0U };
   uint8_t static_buf[32];
   uint8_t* dynamic_buf = NULL;
   // Check if bytes is a list
-  if(mp_obj_is_type(args[ARG_bytes].u_obj, &mp_type_list)) { // 'bytes' is list
+  if(mp_obj_is_type(bytes_obj, &mp_type_list)) { // 'bytes' is list
     // Get properties of the list
     mp_obj_t* items;
-    mp_obj_list_get(args[ARG_bytes].u_obj, &bufinfo.len, &items);
+    mp_obj_list_get(bytes_obj, &bufinfo.len, &items);
     // Chose static buffer or allocate dynamic buffer if needed
     if(bufinfo.len <= sizeof(static_buf)) {
       bufinfo.buf = static_buf;
@@ -963,7 +1226,7 @@ STATIC mp_obj_t connection_transmit(size_t n_args, const mp_obj_t *pos_args,
       mp_raise_ValueError("incorrect data format");
     }
   } else { // 'bytes' is bytes array or anything supporting buffer protocol
-    mp_get_buffer_raise(args[ARG_bytes].u_obj, &bufinfo, MP_BUFFER_READ);
+    mp_get_buffer_raise(bytes_obj, &bufinfo, MP_BUFFER_READ);
   }
 
   // Transmit APDU
@@ -974,17 +1237,111 @@ STATIC mp_obj_t connection_transmit(size_t n_args, const mp_obj_t *pos_args,
     m_del(uint8_t, dynamic_buf, bufinfo.len);
     dynamic_buf = NULL;
   }
+}
+
+/**
+ * @brief Transmit an APDU to the smart card
+ *
+ * .. method:: CardConnection.transmit(bytes, protocol=None, *, raw=False,
+ *                                    into=None)
+ *
+ *  Transmit an APDU to the smart card. Arguments:
+ *    - *bytes* buffer containing APDU
+ *    - *protocol* protocol identifier, if None uses previously selected
+ *      protocol (if any), or default protocol if nothing selected
+ *    - *raw* if True response is returned as a single bytes object
+ *      containing data followed by SW1 SW2, instead of [data, sw1, sw2] list
+ *    - *into* writable buffer receiving raw response; as much as fits is
+ *      copied, full length of response is returned and no objects are
+ *      allocated
+ *
+ *  Response is returned only in blocking mode, in non-blocking mode it is
+ *  passed to observers as a list.
+ *
+ * @param n_args    number of arguments
+ * @param pos_args  positional arguments
+ * @param kw_args   keyword arguments
+ * @return          response or None in non-blocking mode
+ */
+STATIC mp_obj_t connection_transmit(size_t n_args, const mp_obj_t *pos_args,
+                                    mp_map_t *kw_args) {
+  // Get self
+  assert(n_args >= 1U);
+  connection_obj_t* self = (connection_obj_t*)MP_OBJ_TO_PTR(pos_args[0]);
+
+  // Parse and check arguments
+  enum { ARG_bytes = 0, ARG_protocol, ARG_raw, ARG_into };
+  static const mp_arg_t allowed_args[] = {
+    { MP_QSTR_bytes,    MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none}},
+    { MP_QSTR_protocol, MP_ARG_OBJ,                   {.u_obj = mp_const_none}},
+    { MP_QSTR_raw,      MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = false}       },
+    { MP_QSTR_into,     MP_ARG_KW_ONLY | MP_ARG_OBJ,  {.u_obj = mp_const_none}}
+  };
+  mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+  mp_arg_parse_all(n_args - 1U, pos_args + 1U, kw_args,
+                   MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+  check_no_async_op(self);
+  start_transmit(self, args[ARG_bytes].u_obj, args[ARG_protocol].u_obj,
+                 args[ARG_raw].u_bool, args[ARG_into].u_obj);
   if(self->blocking) {
     wait_response_blocking(self);
-    // Do not keep the reference to allow GC to remove response later
+    // Do not keep references to allow GC to remove objects later
     mp_obj_t response = self->response;
     self->response = MP_OBJ_NULL;
+    self->rsp_into = MP_OBJ_NULL;
     return response;
   }
 
   return mp_const_none;
 }
 
+/**
+ * @brief Transmits an APDU to the smart card asynchronously
+ *
+ * .. method:: CardConnection.transmit_async(bytes, protocol=None, *,
+ *                                          raw=False, into=None)
+ *
+ *  Awaitable version of transmit() for use within uasyncio tasks, works
+ *  regardless of blocking mode:
+ *
+ *  response = await connection.transmit_async(apdu)
+ *
+ *  Arguments and response are the same as for transmit() in blocking mode,
+ *  SmartcardException is raised in the awaiting task on failure.
+ *
+ * @param n_args    number of arguments
+ * @param pos_args  positional arguments
+ * @param kw_args   keyword arguments
+ * @return          awaitable object
+ */
+STATIC mp_obj_t connection_transmit_async(size_t n_args,
+                                          const mp_obj_t *pos_args,
+                                          mp_map_t *kw_args) {
+  // Get self
+  assert(n_args >= 1U);
+  connection_obj_t* self = (connection_obj_t*)MP_OBJ_TO_PTR(pos_args[0]);
+
+  // Parse and check arguments
+  enum { ARG_bytes = 0, ARG_protocol, ARG_raw, ARG_into };
+  static const mp_arg_t allowed_args[] = {
+    { MP_QSTR_bytes,    MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none}},
+    { MP_QSTR_protocol, MP_ARG_OBJ,                   {.u_obj = mp_const_none}},
+    { MP_QSTR_raw,      MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = false}       },
+    { MP_QSTR_into,     MP_ARG_KW_ONLY | MP_ARG_OBJ,  {.u_obj = mp_const_none}}
+  };
+  mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+  mp_arg_parse_all(n_args - 1U, pos_args + 1U, kw_args,
+                   MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+  check_no_async_op(self);
+  // Operation is registered first to keep the response in non-blocking mode
+  self->async_op = async_op_transmit;
+  start_transmit(self, args[ARG_bytes].u_obj, args[ARG_protocol].u_obj,
+                 args[ARG_raw].u_bool, args[ARG_into].u_obj);
+  return new_async_op(self, async_op_transmit);
+}
+
 /**
  * @brief Checks if connection is active
  *
@@ -1219,6 +1576,7 @@ STATIC mp_obj_t connection_disconnect(mp_obj_t self_in) {
 
     self->atr = MP_OBJ_NULL;
     self->response = MP_OBJ_NULL;
+    self->rsp_into = MP_OBJ_NULL;
 
     // Apply reset and remove power
     scard_pin_write(&self->rst_pin, ACT);
@@ -1297,12 +1655,92 @@ STATIC void connection_print(const mp_print_t *print, mp_obj_t self_in,
           list_get_len(self->observers) );
 }
 
+/**
+ * Handles ioctl requests of stream protocol
+ *
+ * Makes the connection pollable by uasyncio. Each poll request drives the
+ * protocol, the connection becomes readable when pending asynchronous
+ * operation is completed.
+ *
+ * @param self_in  instance of CardConnection class
+ * @param request  request code
+ * @param arg      request argument
+ * @param errcode  pointer to variable receiving error code
+ * @return         result of request or MP_STREAM_ERROR
+ */
+STATIC mp_uint_t connection_ioctl(mp_obj_t self_in, mp_uint_t request,
+                                  uintptr_t arg, int *errcode) {
+  connection_obj_t* self = (connection_obj_t*)self_in;
+
+  if(MP_STREAM_POLL == request) {
+    mp_uint_t ret = 0U;
+    if(state_closed != self->state) {
+      poll_task(self);
+    }
+    if((arg & MP_STREAM_POLL_RD) && async_op_done(self)) {
+      ret |= MP_STREAM_POLL_RD;
+    }
+    return ret;
+  }
+
+  *errcode = MP_EINVAL;
+  return MP_STREAM_ERROR;
+}
+
+/**
+ * __next__ method of awaitable object
+ *
+ * Suspends the awaiting task in uasyncio IO queue until the connection is
+ * readable, then completes the operation raising StopIteration with result.
+ *
+ * @param self_in  awaitable object
+ * @return         None while the operation is in progress
+ */
+STATIC mp_obj_t async_op_next(mp_obj_t self_in) {
+  async_op_obj_t* self = (async_op_obj_t*)MP_OBJ_TO_PTR(self_in);
+  connection_obj_t* conn = self->connection;
+
+  if(state_closed != conn->state) {
+    poll_task(conn);
+  }
+  if(!async_op_done(conn)) {
+    // Equivalent of "yield asyncio.core._io_queue.queue_read(connection)"
+    mp_obj_t asyncio = mp_import_name(MP_QSTR_asyncio, mp_const_none,
+                                      MP_OBJ_NEW_SMALL_INT(0));
+    mp_obj_t core = mp_load_attr(asyncio, MP_QSTR_core);
+    mp_obj_t io_queue = mp_load_attr(core, MP_QSTR__io_queue);
+    mp_obj_t queue_read = mp_load_attr(io_queue, MP_QSTR_queue_read);
+    (void)mp_call_function_1(queue_read, MP_OBJ_FROM_PTR(conn));
+    return mp_const_none;
+  }
+
+  mp_obj_t result = async_op_result(conn);
+  nlr_raise(mp_obj_new_exception_arg1(&mp_type_StopIteration, result));
+}
+
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(async_op_next_obj, async_op_next);
+
+STATIC const mp_rom_map_elem_t async_op_locals_dict_table[] = {
+  { MP_ROM_QSTR(MP_QSTR___next__),        MP_ROM_PTR(&async_op_next_obj)               },
+};
+STATIC MP_DEFINE_CONST_DICT(async_op_locals_dict, async_op_locals_dict_table);
+
+/// Awaitable object, result is passed via StopIteration to support "await"
+STATIC const mp_obj_type_t async_op_type = {
+  { &mp_type_type },
+  .name = MP_QSTR_AsyncOperation,
+  .getiter = mp_identity_getiter,
+  .locals_dict = (void*)&async_op_locals_dict,
+};
+
 STATIC MP_DEFINE_CONST_FUN_OBJ_KW(connection_connect_obj, 1, connection_connect);
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(connection_connect_async_obj, 1, connection_connect_async);
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(connection_isCardInserted_obj, connection_isCardInserted);
 STATIC MP_DEFINE_CONST_FUN_OBJ_2(connection_setBlocking_obj, connection_setBlocking);
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(connection_isBlocking_obj, connection_isBlocking);
 STATIC MP_DEFINE_CONST_FUN_OBJ_KW(connection_setTimeouts_obj, 1, connection_setTimeouts);
 STATIC MP_DEFINE_CONST_FUN_OBJ_KW(connection_transmit_obj, 1, connection_transmit);
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(connection_transmit_async_obj, 1, connection_transmit_async);
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(connection_isActive_obj, connection_isActive);
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(connection_getState_obj, connection_getState);
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(connection_getATR_obj, connection_getATR);
@@ -1323,11 +1761,13 @@ STATIC const mp_rom_map_elem_t connection_locals_dict_table[] = {
   { MP_ROM_QSTR(MP_QSTR___enter__),       MP_ROM_PTR(&mp_identity_obj)                 },
   { MP_ROM_QSTR(MP_QSTR___exit__),        MP_ROM_PTR(&connection_close_obj)            },
   { MP_ROM_QSTR(MP_QSTR_connect),         MP_ROM_PTR(&connection_connect_obj)          },
+  { MP_ROM_QSTR(MP_QSTR_connect_async),   MP_ROM_PTR(&connection_connect_async_obj)    },
   { MP_ROM_QSTR(MP_QSTR_isCardInserted),  MP_ROM_PTR(&connection_isCardInserted_obj)   },
   { MP_ROM_QSTR(MP_QSTR_setBlocking),     MP_ROM_PTR(&connection_setBlocking_obj)      },
   { MP_ROM_QSTR(MP_QSTR_isBlocking),      MP_ROM_PTR(&connection_isBlocking_obj)       },
   { MP_ROM_QSTR(MP_QSTR_setTimeouts),     MP_ROM_PTR(&connection_setTimeouts_obj)      },
   { MP_ROM_QSTR(MP_QSTR_transmit),        MP_ROM_PTR(&connection_transmit_obj)         },
+  { MP_ROM_QSTR(MP_QSTR_transmit_async),  MP_ROM_PTR(&connection_transmit_async_obj)   },
   { MP_ROM_QSTR(MP_QSTR_isActive),        MP_ROM_PTR(&connection_isActive_obj)         },
   { MP_ROM_QSTR(MP_QSTR_getState),        MP_ROM_PTR(&connection_getState_obj)         },
   { MP_ROM_QSTR(MP_QSTR_getATR),          MP_ROM_PTR(&connection_getATR_obj)           },
@@ -1347,12 +1787,18 @@ STATIC const mp_rom_map_elem_t connection_locals_dict_table[] = {
 };
 STATIC MP_DEFINE_CONST_DICT(connection_locals_dict, connection_locals_dict_table);
 
+/// Stream protocol of CardConnection, only polling is supported
+STATIC const mp_stream_p_t connection_stream_p = {
+  .ioctl = connection_ioctl,
+};
+
 const mp_obj_type_t scard_CardConnection_type = {
   { &mp_type_type },
   .name = MP_QSTR_CardConnection,
   .print = connection_print,
   .make_new = connection_make_new,
   .call = connection_call,
+  .protocol = &connection_stream_p,
   .locals_dict = (void*)&connection_locals_dict,
 };
 
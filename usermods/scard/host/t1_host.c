@@ -0,0 +1,520 @@
+/**
+ * @file       t1_host.c
+ * @brief      Host-side harness of T=1 protocol with a virtual card
+ *
+ * Runs the reader side of T=1 protocol (t1_protocol.c) against the virtual
+ * card (vcard.c) using a virtual clock. First a set of conformance scenarios
+ * is executed, then throughput is measured for a range of block and payload
+ * sizes. Usage: t1_host [number of APDUs per benchmark point]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "t1_protocol.h"
+#include "vcard.h"
+
+/// Default number of APDUs per benchmark point
+#define DEF_BENCH_APDUS                 2000U
+/// Smart card clock assumed for on-wire estimates, STM32F469 @ 180MHz
+#define WIRE_CLK_HZ                     4500000.0
+/// Maximal D supported by host in PPS negotiation
+#define HOST_MAX_D                      64
+/// Character frame duration in ETU, including guard time
+#define WIRE_CHAR_ETU                   12.0
+/// Virtual time limit for a single operation
+#define OP_TIMEOUT_MS                   (60U * 1000U)
+/// Limit of data transfers without idle time, catches endless block exchange
+#define OP_MAX_TRANSFERS                100000U
+/// Maximal size of command APDU, extended length
+#define HOST_MAX_CMD_SIZE               (4U + 3U + 65535U)
+/// Maximal size of response APDU including status bytes, extended length
+#define HOST_MAX_RSP_SIZE               (65536U + 2U)
+/// Size of transmit FIFO fitting the longest command APDU with IFSC = 16
+#define HOST_TX_FIFO_SIZE               (128U * 1024U)
+
+/// Reader and card wired together
+typedef struct host_ {
+  t1_inst_t t1;              ///< Reader side protocol instance
+  vcard_t card;              ///< Virtual card
+  uint32_t time_ms;          ///< Virtual time in ms
+  t1_rate_t rate;            ///< Transmission rate in use
+  unsigned pps_fallbacks;    ///< Reconnections at default rate
+  bool reset_pending;        ///< Warm reset requested after failed PPS
+  unsigned lose_period;      ///< Every n-th received chunk is lost, 0 - none
+  unsigned rx_chunks;        ///< Counter of received chunks
+  bool connected;            ///< Connection established
+  bool has_error;            ///< Error event received
+  t1_ev_code_t error;        ///< Last error event
+  bool has_response;         ///< Response APDU received
+  const uint8_t* rsp;        ///< Last response APDU
+  size_t rsp_len;            ///< Length of last response APDU
+} host_t;
+
+/// Transmit FIFO buffer provided to reader side protocol instance
+static uint8_t host_tx_fifo[HOST_TX_FIFO_SIZE];
+/// Buffer receiving response APDU, provided to protocol instance
+static uint8_t host_rx_apdu[HOST_MAX_RSP_SIZE];
+
+/// Number of failed checks
+static int failures = 0;
+
+/**
+ * Checks condition and reports failure
+ * @param cond  condition
+ * @param what  description of the check
+ */
+static void check(bool cond, const char* what) {
+  printf("  %-56s %s\n", what, cond ? "ok" : "FAIL");
+  if(!cond) {
+    ++failures;
+  }
+}
+
+/**
+ * T=1 protocol: outputs bytes to the virtual card
+ * @param buf         buffer containing data to transmit
+ * @param len         length of data block in bytes
+ * @param p_user_prm  host instance
+ * @return            true
+ */
+static bool cb_serial_out(const uint8_t* buf, size_t len, void* p_user_prm) {
+  host_t* host = (host_t*)p_user_prm;
+  vcard_write(&host->card, buf, len);
+  return true;
+}
+
+/**
+ * T=1 protocol: handles protocol events
+ * @param ev_code     event code
+ * @param ev_prm      event parameter
+ * @param p_user_prm  host instance
+ */
+static void cb_handle_event(t1_ev_code_t ev_code, const void* ev_prm,
+                            void* p_user_prm) {
+  host_t* host = (host_t*)p_user_prm;
+
+  if(ev_code == t1_ev_pps_failed && t1_get_config(&host->t1, t1_cfg_max_d) > 1) {
+    // Like CardConnection, the protocol is reset after it returns
+    host->reset_pending = true;
+  } else if(t1_is_error_event(ev_code)) {
+    host->has_error = true;
+    host->error = ev_code;
+  } else if(ev_code == t1_ev_connect) {
+    host->connected = true;
+  } else if(ev_code == t1_ev_rate_changed) {
+    host->rate = *(const t1_rate_t*)ev_prm;
+  } else if(ev_code == t1_ev_apdu_received) {
+    const t1_apdu_t* p_apdu = (const t1_apdu_t*)ev_prm;
+    host->rsp = p_apdu->apdu;
+    host->rsp_len = p_apdu->len;
+    host->has_response = true;
+  }
+}
+
+/**
+ * Makes warm reset after failed PPS exchange, the next one uses default rate
+ * @param host  host instance
+ */
+static void host_warm_reset(host_t* host) {
+  host->reset_pending = false;
+  host->rate = (t1_rate_t) { .f = 372U, .d = 1U };
+  t1_set_config(&host->t1, t1_cfg_max_d, 1);
+  t1_reset(&host->t1, true);
+  vcard_reset(&host->card);
+  ++host->pps_fallbacks;
+}
+
+/**
+ * Moves bytes between reader and card until flag is set, error occurs or
+ * virtual time limit is reached
+ *
+ * Data transfer is instantaneous, virtual time advances only when the line is
+ * idle. Requested reset is made there as well, like by timer task of
+ * CardConnection.
+ * @param host  host instance
+ * @param flag  pointer to the flag to wait for
+ * @return      true if flag is set
+ */
+static bool run_until(host_t* host, const bool* flag) {
+  uint32_t start_ms = host->time_ms;
+  uint32_t transfers = 0;
+
+  while(!*flag && !host->has_error && host->time_ms - start_ms < OP_TIMEOUT_MS) {
+    uint8_t buf[64];
+    size_t len = vcard_read(&host->card, buf, sizeof(buf));
+    if(len) {
+      if(++transfers > OP_MAX_TRANSFERS) {
+        break;
+      }
+      if(host->lose_period && ++host->rx_chunks % host->lose_period == 0) {
+        t1_serial_error(&host->t1); // Like overrun of DMA receive buffer
+      } else {
+        t1_serial_in(&host->t1, buf, len);
+      }
+    } else if(host->reset_pending) {
+      host_warm_reset(host);
+    } else {
+      transfers = 0;
+      ++host->time_ms;
+      vcard_timer_task(&host->card, 1U);
+      t1_timer_task(&host->t1, 1U);
+    }
+  }
+  return *flag;
+}
+
+/**
+ * Initializes reader and card, connects to the card
+ *
+ * Like CardConnection, resets the card and connects at default rate if PPS
+ * exchange proposing a new rate fails, see host_warm_reset().
+ * @param host      host instance
+ * @param p_config  card configuration
+ * @param max_d     maximal D supported by host
+ * @return          true if connected
+ */
+static bool host_connect_d(host_t* host, const vcard_config_t* p_config,
+                           int32_t max_d) {
+  memset(host, 0, sizeof(host_t));
+  if(!t1_init(&host->t1, cb_serial_out, cb_handle_event, host) ||
+     !t1_set_tx_buffer(&host->t1, host_tx_fifo, sizeof(host_tx_fifo)) ||
+     !t1_set_rx_buffer(&host->t1, host_rx_apdu, sizeof(host_rx_apdu)) ||
+     !vcard_init(&host->card, p_config)) {
+    return false;
+  }
+  host->rate = (t1_rate_t) { .f = 372U, .d = 1U };
+  t1_set_config(&host->t1, t1_cfg_max_d, max_d);
+  t1_reset(&host->t1, true);
+  vcard_reset(&host->card);
+  return run_until(host, &host->connected);
+}
+
+/**
+ * Initializes reader and card, connects to the card with all rates enabled
+ * @param host      host instance
+ * @param p_config  card configuration
+ * @return          true if connected
+ */
+static bool host_connect(host_t* host, const vcard_config_t* p_config) {
+  return host_connect_d(host, p_config, HOST_MAX_D);
+}
+
+/**
+ * Transmits APDU and waits for response
+ * @param host     host instance
+ * @param cmd      command APDU
+ * @param cmd_len  length of command APDU in bytes
+ * @return         true if response is received
+ */
+static bool host_transmit(host_t* host, const uint8_t* cmd, size_t cmd_len) {
+  host->has_response = false;
+  return t1_transmit_apdu(&host->t1, cmd, cmd_len) &&
+         run_until(host, &host->has_response);
+}
+
+/**
+ * Transmits echo APDU and waits for response
+ *
+ * Payload above 255 bytes is sent in extended length APDU.
+ * @param host     host instance
+ * @param payload  number of data bytes in command and response
+ * @return         true if response is correct
+ */
+static bool host_echo(host_t* host, size_t payload) {
+  static uint8_t cmd[HOST_MAX_CMD_SIZE];
+  size_t hdr_len = 5U;
+
+  cmd[0] = 0x00;
+  cmd[1] = 0xEE;
+  cmd[2] = 0x00;
+  cmd[3] = 0x00;
+  cmd[4] = (uint8_t)payload;
+  if(payload > 255U) {
+    cmd[4] = 0x00;
+    cmd[5] = (uint8_t)(payload >> 8);
+    cmd[6] = (uint8_t)payload;
+    hdr_len = 7U;
+  }
+  for(size_t i = 0; i < payload; i++) {
+    cmd[hdr_len + i] = (uint8_t)(i * 7U + 3U);
+  }
+  size_t cmd_len = payload ? hdr_len + payload : 4U;
+
+  if(!host_transmit(host, cmd, cmd_len)) {
+    return false;
+  }
+  return host->rsp_len == payload + 2U &&
+         memcmp(host->rsp, cmd + hdr_len, payload) == 0 &&
+         host->rsp[payload] == 0x90 && host->rsp[payload + 1U] == 0x00;
+}
+
+/**
+ * Requests response of given length with extended length APDU, case 2E
+ * @param host  host instance
+ * @param le    expected response length, 1...65536
+ * @return      true if response is correct
+ */
+static bool host_get_extended(host_t* host, size_t le) {
+  const uint8_t cmd[] = {
+    0x00, 0xEE, 0x00, 0x00, 0x00, (uint8_t)(le >> 8), (uint8_t)le
+  };
+
+  if(!host_transmit(host, cmd, sizeof(cmd)) || host->rsp_len != le + 2U) {
+    return false;
+  }
+  for(size_t i = 0; i < le; i++) {
+    if(host->rsp[i] != (uint8_t)i) {
+      return false;
+    }
+  }
+  return host->rsp[le] == 0x90 && host->rsp[le + 1U] == 0x00;
+}
+
+/**
+ * Runs conformance scenarios
+ */
+static void run_scenarios(void) {
+  static host_t host;
+  vcard_config_t config;
+
+  printf("Conformance:\n");
+
+  vcard_default_config(&config);
+  check(host_connect(&host, &config), "connect, ATR + PPS + IFSD");
+  check(host.card.ifsd == T1_MAX_LEN_VALUE, "IFSD negotiated");
+  check(t1_get_config(&host.t1, t1_cfg_ifsc) == config.ifsc,
+        "IFSC taken from ATR");
+  check(host_echo(&host, 0), "case 1 APDU");
+  check(host_echo(&host, 200), "single block APDU");
+  check(host_echo(&host, 255), "response chained by card");
+  check(host.rate.f == 372U && host.rate.d == 1U, "default rate without TA1");
+
+  vcard_default_config(&config);
+  config.ta1 = 0x13;
+  check(host_connect(&host, &config) && host.card.fidi == 0x13 &&
+        host.rate.f == 372U && host.rate.d == 4U && host_echo(&host, 200),
+        "PPS selects rate of TA1, F = 372, D = 4");
+
+  vcard_default_config(&config);
+  config.ta1 = 0x97;
+  check(host_connect_d(&host, &config, 20) && host.card.fidi == 0x99 &&
+        host.rate.f == 512U && host.rate.d == 20U && host_echo(&host, 200),
+        "PPS limits D to host maximum, F = 512, D = 20");
+
+  vcard_default_config(&config);
+  config.ta1 = 0x17;
+  check(host_connect(&host, &config) && host.card.fidi == 0x16 &&
+        host.rate.f == 372U && host.rate.d == 32U && host_echo(&host, 200),
+        "PPS keeps F/D >= 8, F = 372, D = 32 instead of 64");
+
+  vcard_default_config(&config);
+  config.ta1 = 0x13;
+  config.ignore_pps1 = true;
+  check(host_connect(&host, &config) && host.pps_fallbacks == 1U &&
+        host.card.fidi == 0x11 && host.rate.d == 1U && host_echo(&host, 200),
+        "PPS failure, reconnected at default rate");
+  config.ta1 = 0x11;
+  check(host_connect_d(&host, &config, 1) && !host.has_error &&
+        host.pps_fallbacks == 0U, "no reset without rate proposal");
+  vcard_default_config(&config);
+  config.ta1 = 0x97;
+  config.ignore_pps1 = true;
+  check(host_connect(&host, &config) && !host.has_error &&
+        host.pps_fallbacks == 1U && host.rate.d == 1U &&
+        host_echo(&host, 16), "PPS failure at D = 64, deferred reset");
+
+  vcard_default_config(&config);
+  config.ifsc = 16;
+  check(host_connect(&host, &config) && host_echo(&host, 200),
+        "command chained by reader, IFSC = 16");
+  check(host_echo(&host, 65535), "extended APDU, 65535 bytes, IFSC = 16");
+
+  vcard_default_config(&config);
+  config.ifsc = 254;
+  check(host_connect(&host, &config) && host_echo(&host, 4096) &&
+        host_echo(&host, 20) && host_echo(&host, 1000),
+        "extended APDU, 4096 bytes, IFSC = 254");
+  check(host_get_extended(&host, 65536), "extended response, Le = 65536");
+
+  uint8_t small_fifo[512];
+  check(t1_set_tx_buffer(&host.t1, small_fifo, sizeof(small_fifo)) &&
+        !host_echo(&host, 1000) && !host.has_error &&
+        t1_set_tx_buffer(&host.t1, host_tx_fifo, sizeof(host_tx_fifo)) &&
+        host_echo(&host, 1000), "command exceeding TX FIFO rejected");
+
+  vcard_default_config(&config);
+  config.use_crc = true;
+  check(host_connect(&host, &config) && host_echo(&host, 100),
+        "CRC error detection code");
+
+  vcard_default_config(&config);
+  config.specific_mode = true;
+  check(host_connect(&host, &config) && host_echo(&host, 32),
+        "card in specific mode");
+  config.ta1 = 0x13;
+  check(host_connect(&host, &config) && host.rate.d == 4U &&
+        host_echo(&host, 32), "card in specific mode, rate of TA1");
+
+  vcard_default_config(&config);
+  config.ifsc = 32;
+  config.corrupt_period = 3;
+  bool ok = host_connect(&host, &config);
+  for(int i = 0; ok && i < 20; i++) {
+    ok = host_echo(&host, 100);
+  }
+  check(ok && host.card.stats.retransmissions > 0,
+        "R-block retransmission of corrupted blocks");
+
+  vcard_default_config(&config);
+  config.ifsc = 32;
+  ok = host_connect(&host, &config);
+  host.lose_period = 7;
+  for(int i = 0; ok && i < 20; i++) {
+    ok = host_echo(&host, 100);
+  }
+  host.lose_period = 0;
+  check(ok && host.card.stats.retransmissions > 0,
+        "R-block retransmission after lost received data");
+
+  vcard_default_config(&config);
+  config.bwt_ms = 500;
+  ok = host_connect(&host, &config);
+  uint32_t start_ms = host.time_ms;
+  ok = ok && host_echo(&host, 16);
+  check(ok && host.time_ms - start_ms >= config.bwt_ms &&
+        host.card.stats.ignored == 0, "BWT within response timeout");
+
+  vcard_default_config(&config);
+  config.bwt_ms = 3000;
+  ok = host_connect(&host, &config);
+  check(ok && host_echo(&host, 16) && host.card.stats.ignored > 0,
+        "BWT exceeding response timeout, recovered");
+  ok = host_connect(&host, &config);
+  ok = ok && t1_set_config(&host.t1, t1_cfg_tm_response, 4000);
+  check(ok && host_echo(&host, 16) && host.card.stats.ignored == 0,
+        "BWT with extended response timeout");
+
+  vcard_default_config(&config);
+  config.bwt_ms = OP_TIMEOUT_MS;
+  ok = host_connect(&host, &config);
+  check(ok && !host_echo(&host, 16) && host.has_error,
+        "mute card reported as failure");
+}
+
+/// Result of one benchmark point
+typedef struct bench_result_ {
+  bool ok;             ///< All APDUs exchanged successfully
+  t1_rate_t rate;      ///< Transmission rate in use
+  double cpu_s;        ///< CPU time spent by host stack, s
+  double wire_s;       ///< Estimated time on the wire, s
+  double app_bytes;    ///< Payload bytes in both directions
+  double wire_bytes;   ///< Bytes on the wire in both directions
+} bench_result_t;
+
+/**
+ * Runs throughput benchmark for one combination of parameters
+ * @param ifsc     IFSC of the card
+ * @param ta1      TA1 advertised by the card, 0 - absent
+ * @param payload  number of data bytes in command and response
+ * @param n_apdus  number of APDUs to exchange
+ * @return         benchmark result
+ */
+static bench_result_t bench_point(uint8_t ifsc, uint8_t ta1, size_t payload,
+                                  unsigned n_apdus) {
+  static host_t host;
+  vcard_config_t config;
+  bench_result_t res = { .ok = false };
+
+  vcard_default_config(&config);
+  config.ifsc = ifsc;
+  config.ta1 = ta1;
+  if(!host_connect(&host, &config)) {
+    ++failures;
+    return res;
+  }
+  uint32_t wire_bytes = host.card.stats.bytes_in + host.card.stats.bytes_out;
+
+  clock_t start = clock();
+  for(unsigned i = 0; i < n_apdus; i++) {
+    if(!host_echo(&host, payload)) {
+      ++failures;
+      return res;
+    }
+  }
+  res.cpu_s = (double)(clock() - start) / CLOCKS_PER_SEC;
+  res.cpu_s = res.cpu_s > 0.0 ? res.cpu_s : 1e-9;
+  wire_bytes = host.card.stats.bytes_in + host.card.stats.bytes_out -
+               wire_bytes;
+
+  // Payload counted in both directions, as an application sees it
+  res.ok = true;
+  res.rate = host.rate;
+  res.app_bytes = 2.0 * payload * n_apdus;
+  res.wire_bytes = wire_bytes;
+  res.wire_s = wire_bytes * WIRE_CHAR_ETU * host.rate.f /
+               (host.rate.d * WIRE_CLK_HZ);
+  return res;
+}
+
+/**
+ * Runs throughput benchmarks
+ * @param n_apdus  number of APDUs per benchmark point
+ */
+static void run_benchmarks(unsigned n_apdus) {
+  static const uint8_t ifsc_list[] = { 16, 32, 64, 128, 254 };
+  static const size_t payload_list[] = { 16, 64, 128, 255, 1024, 4096 };
+  static const uint8_t ta1_list[] = { 0x11, 0x12, 0x13, 0x18, 0x94, 0x95, 0x96 };
+
+  printf("\nThroughput, %u APDUs per point, echo APDU (Lc = payload):\n",
+         n_apdus);
+  printf("                   host stack            wire @ %.1f MHz, F=372\n",
+         WIRE_CLK_HZ / 1e6);
+  printf(" IFSC payload       APDU/s          B/s     APDU/s        B/s  overhead\n");
+  for(size_t i = 0; i < sizeof(ifsc_list); i++) {
+    for(size_t j = 0; j < sizeof(payload_list) / sizeof(payload_list[0]); j++) {
+      bench_result_t r = bench_point(ifsc_list[i], 0, payload_list[j], n_apdus);
+      if(!r.ok) {
+        printf("%5u %7u  failed\n", ifsc_list[i], (unsigned)payload_list[j]);
+        continue;
+      }
+      printf("%5u %7u %12.0f %12.0f %10.1f %10.0f %9.1f%%\n",
+             ifsc_list[i], (unsigned)payload_list[j],
+             n_apdus / r.cpu_s, r.app_bytes / r.cpu_s,
+             n_apdus / r.wire_s, r.app_bytes / r.wire_s,
+             100.0 * (r.wire_bytes - r.app_bytes) / r.wire_bytes);
+    }
+  }
+
+  printf("\nRate negotiated by PPS, IFSC = 254, payload = 255, wire @ %.1f MHz:\n",
+         WIRE_CLK_HZ / 1e6);
+  printf("  TA1     F   D     APDU/s        B/s  speedup\n");
+  double base_s = 0.0;
+  for(size_t i = 0; i < sizeof(ta1_list); i++) {
+    bench_result_t r = bench_point(254, ta1_list[i], 255, n_apdus);
+    if(!r.ok) {
+      printf(" 0x%02X  failed\n", ta1_list[i]);
+      continue;
+    }
+    base_s = (base_s > 0.0) ? base_s : r.wire_s;
+    printf(" 0x%02X %5u %3u %10.1f %10.0f %7.1fx\n", ta1_list[i],
+           r.rate.f, r.rate.d, n_apdus / r.wire_s, r.app_bytes / r.wire_s,
+           base_s / r.wire_s);
+  }
+}
+
+int main(int argc, char** argv) {
+  unsigned n_apdus = (argc > 1) ? (unsigned)atoi(argv[1]) : DEF_BENCH_APDUS;
+
+  run_scenarios();
+  if(n_apdus) {
+    run_benchmarks(n_apdus);
+  }
+
+  if(failures) {
+    printf("\n%d check(s) failed\n", failures);
+    return 1;
+  }
+  return 0;
+}
@@ -3,8 +3,8 @@ SCARD_IO_MOD_DIR := $(USERMOD_DIR)
 # disable for simulator
 ifeq ($(UNAME_S),)
 
-# Reduce FIFO size for T=1 protocol
-CFLAGS_USERMOD += -DT1_TX_FIFO_SIZE=600
+# Buffers of T=1 protocol are allocated on heap, see protocols.c
+CFLAGS_USERMOD += -DT1_TX_FIFO_SIZE=0 -DT1_MAX_APDU_SIZE=0
 
 # Only STM32 series is currently supported
 ifeq ($(MCU_SERIES),$(filter $(MCU_SERIES),f0 f4 f7 l0 l4 wb))
@@ -33,4 +33,26 @@ $(error Unsupported platform)
 
 endif # MCU_SERIES == [f0, f4, f7, l0, l4, wb]
 
-endif
\ No newline at end of file
+else # UNAME_S
+
+# Unix port talking to a virtual card, enabled with SCARD_VIRTUAL=1. Otherwise
+# uscard module is provided by the frozen simulator in libs/unix.
+ifeq ($(SCARD_VIRTUAL),1)
+
+SRC_USERMOD += $(SCARD_IO_MOD_DIR)/scard.c
+SRC_USERMOD += $(SCARD_IO_MOD_DIR)/reader.c
+SRC_USERMOD += $(SCARD_IO_MOD_DIR)/connection.c
+SRC_USERMOD += $(SCARD_IO_MOD_DIR)/protocols.c
+SRC_USERMOD += $(SCARD_IO_MOD_DIR)/t1_protocol/t1_protocol.c
+SRC_USERMOD += $(SCARD_IO_MOD_DIR)/vcard/vcard.c
+SRC_USERMOD += $(SCARD_IO_MOD_DIR)/ports/unix/scard_io.c
+
+CFLAGS_USERMOD += -I$(SCARD_IO_MOD_DIR)
+CFLAGS_USERMOD += -I$(SCARD_IO_MOD_DIR)/t1_protocol
+CFLAGS_USERMOD += -I$(SCARD_IO_MOD_DIR)/vcard
+CFLAGS_USERMOD += -I$(SCARD_IO_MOD_DIR)/ports/unix -DMODULE_SCARD_ENABLED=1
+CFLAGS_USERMOD += -DT1_TX_FIFO_SIZE=0 -DT1_MAX_APDU_SIZE=0
+
+endif # SCARD_VIRTUAL
+
+endif # UNAME_S
\ No newline at end of file
@@ -6,6 +6,7 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 #include "py/obj.h"
 #include "py/runtime.h"
 #include "py/builtin.h"
@@ -17,8 +18,8 @@
 #include "t1_protocol.h"
 #include "scard.h"
 
-/// Length of receive buffer
-#define RX_BUF_LEN                      (270)
+/// Length of UART software receive buffer, not used: data is received by DMA
+#define RX_BUF_LEN                      (0)
 
 /// USART transmission/reception mode
 typedef enum usart_mode_ {
@@ -29,16 +30,73 @@ typedef enum usart_mode_ {
 /// Type information for smart card interface instance
 const mp_obj_type_t scard_inst_type;
 
+/// Configuration of receive DMA streams: circular, byte-wide
+static const DMA_InitTypeDef rx_dma_init = {
+  .Channel             = 0U, // Replaced by scard_usart_dsc_t::rx_dma_channel
+  .Direction           = DMA_PERIPH_TO_MEMORY,
+  .PeriphInc           = DMA_PINC_DISABLE,
+  .MemInc              = DMA_MINC_ENABLE,
+  .PeriphDataAlignment = DMA_PDATAALIGN_BYTE,
+  .MemDataAlignment    = DMA_MDATAALIGN_BYTE,
+  .Mode                = DMA_CIRCULAR,
+  .Priority            = DMA_PRIORITY_HIGH,
+  .FIFOMode            = DMA_FIFOMODE_DISABLE
+};
+
+/*
+ * Receive DMA streams, request mapping from STM32F469 reference manual
+ * (RM0386, tables "DMA1/DMA2 request mapping").
+ *
+ * dma.c exports no USART descriptors. A stream is registered in dma.c with
+ * the public descriptor of another peripheral on the same stream, so dma.c
+ * counts the stream as in use, keeps the DMA clock on and routes the stream
+ * interrupt to our handle. Then the stream is switched to the USART channel.
+ *
+ * Users of DMA streams in STM32F469DISC configuration, streams from dma.c:
+ *  - UART2, UART3, UART6 (mpconfigboard.h): uart.c is interrupt-driven and
+ *    uses no DMA.
+ *  - SPI2: DMA1 Stream3 (RX) and Stream4 (TX).
+ *  - I2C1: DMA1 Stream0 (RX) and Stream6 (TX).
+ *  - SDIO (MICROPY_HW_ENABLE_SDCARD): DMA2 Stream3.
+ *  - DAC channel 1 (MICROPY_HW_ENABLE_DAC): DMA1 Stream5. Its output PA4 is
+ *    USART2_CK, the card clock, so both can't be used at the same time.
+ * SPI1 (DMA2 Stream2 and Stream5) and SPI6 (DMA2 Stream5) are not configured
+ * on this board. Reception DMA is not provided if a board configures them.
+ * USART3 RX is on DMA1 Stream1 only, which has no public descriptor.
+ */
+#if defined(USART1) && !defined(MICROPY_HW_SPI1_SCK) && \
+    !defined(MICROPY_HW_SPI6_SCK)
+  #define SCARD_USART1_RX_DMA \
+    .rx_dma = &dma_SPI_1_TX, .rx_dma_stream = DMA2_Stream5, \
+    .rx_dma_channel = DMA_CHANNEL_4
+#else
+  #define SCARD_USART1_RX_DMA .rx_dma = NULL
+#endif
+#if defined(USART2) && MICROPY_HW_ENABLE_DAC
+  #define SCARD_USART2_RX_DMA \
+    .rx_dma = &dma_DAC_1_TX, .rx_dma_stream = DMA1_Stream5, \
+    .rx_dma_channel = DMA_CHANNEL_4
+#else
+  #define SCARD_USART2_RX_DMA .rx_dma = NULL
+#endif
+#if defined(USART6) && !defined(MICROPY_HW_SPI1_SCK)
+  #define SCARD_USART6_RX_DMA \
+    .rx_dma = &dma_SPI_1_RX, .rx_dma_stream = DMA2_Stream2, \
+    .rx_dma_channel = DMA_CHANNEL_5
+#else
+  #define SCARD_USART6_RX_DMA .rx_dma = NULL
+#endif
+
 /// Table of USART descriptors
 static const scard_usart_dsc_t usart_dsc_table[] = {
   #ifdef USART0
     { .id = 0U, .handle = USART0 },
   #endif
   #ifdef USART1
-    { .id = 1U, .handle = USART1 },
+    { .id = 1U, .handle = USART1, SCARD_USART1_RX_DMA },
   #endif
   #ifdef USART2
-    { .id = 2U, .handle = USART2 },
+    { .id = 2U, .handle = USART2, SCARD_USART2_RX_DMA },
   #endif
   #ifdef USART3
     { .id = 3U, .handle = USART3 },
@@ -50,7 +108,7 @@ static const scard_usart_dsc_t usart_dsc_table[] = {
     { .id = 5U, .handle = USART5 },
   #endif
   #ifdef USART6
-    { .id = 6U, .handle = USART6 },
+    { .id = 6U, .handle = USART6, SCARD_USART6_RX_DMA },
   #endif
   #ifdef USART7
     { .id = 7U, .handle = USART7 },
@@ -148,6 +206,38 @@ static void set_usart_mode(scard_handle_t handle, usart_mode_t mode) {
 #endif // STM32F4
 }
 
+/**
+ * Programs USART baud rate for given duration of elementary time unit
+ *
+ * Frequency of CLK provided to the card is not changed because reprogramming
+ * of the prescaler stops the clock.
+ *
+ * @param sc_handle  handle of smart card low-level driver
+ * @param usart_id   USART identifier, like 3 for USART3
+ * @param f          clock rate conversion integer, Fi
+ * @param d          baud rate adjustment integer, Di
+ * @return           true if successful
+ */
+static bool set_baudrate(SMARTCARD_HandleTypeDef* sc_handle, uint8_t usart_id,
+                         uint32_t f, uint32_t d) {
+#if defined(STM32F4)
+  if(!f || !d || f < d * 8U) { // Less than 8 clock cycles per etu is too fast
+    return false;
+  }
+  uint32_t clk_in = get_usart_clock(usart_id);
+  uint32_t card_clk = clk_in / (2U * sc_handle->Init.Prescaler);
+  uint32_t baudrate = (card_clk * d + f / 2U) / f;
+
+  uint32_t irq_state = disable_irq();
+  sc_handle->Init.BaudRate = baudrate;
+  sc_handle->Instance->BRR = SMARTCARD_BRR(clk_in, baudrate);
+  enable_irq(irq_state);
+  return true;
+#else // STM32F4
+  #error MCU series is not supported by smart card interface yet
+#endif // STM32F4
+}
+
 /**
  * Initializes USART in smart card mode
  * @param sc_handle     handle of smart card low-level driver
@@ -222,6 +312,153 @@ static bool init_pins(mp_obj_t io_pin, mp_obj_t clk_pin, uint8_t usart_id) {
   return ok;
 }
 
+/**
+ * Counts wraps of DMA circular buffer, called from DMA interrupt
+ * @param hdma  HAL handle of receive DMA
+ */
+static void rx_dma_wrapped(DMA_HandleTypeDef* hdma) {
+  scard_inst_t* self = (scard_inst_t*)hdma->Parent;
+  ++self->rx_dma_wraps;
+}
+
+/**
+ * Releases receive DMA stream in dma.c
+ *
+ * Stream configuration is invalidated, so the peripheral owning the dma.c
+ * descriptor fully reprograms the stream on its next transfer.
+ * @param self  smart card interface instance
+ */
+static void stop_rx_dma_stream(scard_inst_t* self) {
+  dma_deinit(self->p_usart_dsc->rx_dma);
+  dma_invalidate_channel(self->p_usart_dsc->rx_dma);
+  self->rx_dma.Instance = NULL;
+}
+
+/**
+ * Starts reception of USART data into circular buffer using DMA
+ *
+ * Reception is never stopped until the interface is deinitialized, received
+ * data is taken directly from the buffer by rx_dma_read().
+ * @param self  smart card interface instance
+ * @return      true if successful
+ */
+static bool start_rx_dma(scard_inst_t* self) {
+#if defined(STM32F4)
+  const scard_usart_dsc_t* p_dsc = self->p_usart_dsc;
+  USART_TypeDef* usart = p_dsc->handle;
+  DMA_HandleTypeDef* hdma = &self->rx_dma;
+
+  // Do not take the stream over from a driver that is using it
+  if(!p_dsc->rx_dma || (p_dsc->rx_dma_stream->CR & DMA_SxCR_EN)) {
+    return false;
+  }
+
+  // Registers the stream in dma.c, enables its clock and interrupt
+  dma_init(hdma, p_dsc->rx_dma, DMA_PERIPH_TO_MEMORY, self);
+  // Reprograms the stream for USART, descriptor belongs to another peripheral
+  hdma->Init = rx_dma_init;
+  hdma->Init.Channel = p_dsc->rx_dma_channel;
+  self->rx_dma_wraps = 0;
+  self->rx_dma_rd_pos = 0;
+  if(hdma->Instance != p_dsc->rx_dma_stream || HAL_OK != HAL_DMA_Init(hdma)) {
+    stop_rx_dma_stream(self);
+    return false;
+  }
+  hdma->XferCpltCallback = rx_dma_wrapped;
+  if(HAL_OK != HAL_DMA_Start_IT(hdma, (uint32_t)&usart->DR,
+                                (uint32_t)self->rx_dma_buf,
+                                sizeof(self->rx_dma_buf))) {
+    stop_rx_dma_stream(self);
+    return false;
+  }
+
+  // Clear stale data and errors, then pass RX requests to DMA. RXNE interrupt
+  // is disabled to prevent UART driver from taking bytes from DMA.
+  uint32_t irq_state = disable_irq();
+  (void)usart->SR;
+  (void)usart->DR;
+  usart->CR1 &= ~USART_CR1_RXNEIE;
+  usart->CR3 |= USART_CR3_DMAR;
+  enable_irq(irq_state);
+  return true;
+#else // STM32F4
+  #error MCU series is not supported by smart card interface yet
+#endif // STM32F4
+}
+
+/**
+ * Stops DMA reception
+ * @param self  smart card interface instance
+ */
+static void stop_rx_dma(scard_inst_t* self) {
+  if(self->rx_dma.Instance) {
+    self->p_usart_dsc->handle->CR3 &= ~USART_CR3_DMAR;
+    (void)HAL_DMA_Abort(&self->rx_dma);
+    stop_rx_dma_stream(self);
+  }
+}
+
+/**
+ * Returns total number of bytes written by DMA, modulo 2^32
+ * @param self  smart card interface instance
+ * @return      write position
+ */
+static uint32_t rx_dma_wr_pos(scard_inst_t* self) {
+  DMA_HandleTypeDef* hdma = &self->rx_dma;
+
+  uint32_t irq_state = disable_irq();
+  uint32_t wraps = self->rx_dma_wraps;
+  // NDTR counts down and is reloaded with buffer size after reaching zero
+  uint32_t ndtr = __HAL_DMA_GET_COUNTER(hdma);
+  if(__HAL_DMA_GET_FLAG(hdma, __HAL_DMA_GET_TC_FLAG_INDEX(hdma))) {
+    // Wrap is not counted by the interrupt yet, NDTR could be read before it
+    ++wraps;
+    ndtr = __HAL_DMA_GET_COUNTER(hdma);
+  }
+  enable_irq(irq_state);
+
+  return wraps * SCARD_RX_DMA_BUF_SIZE + (SCARD_RX_DMA_BUF_SIZE - ndtr);
+}
+
+/**
+ * Reads received bytes from DMA circular buffer
+ *
+ * Loopback echo of transmitted bytes is suppressed by advancing the read
+ * position. If DMA has overwritten unread data, all received data is dropped.
+ * @param self    smart card interface instance
+ * @param buf     buffer receiving data
+ * @param nbytes  maximum number of bytes to read
+ * @return        number of bytes read or SCARD_RX_OVERRUN
+ */
+static size_t rx_dma_read(scard_inst_t* self, uint8_t* buf, size_t nbytes) {
+  const size_t mask = SCARD_RX_DMA_BUF_SIZE - 1U;
+  uint32_t wr_pos = rx_dma_wr_pos(self);
+  size_t avail = wr_pos - self->rx_dma_rd_pos;
+
+  if(avail > SCARD_RX_DMA_BUF_SIZE) {
+    // Drop everything, loopback echo precedes lost data and is dropped too
+    self->rx_dma_rd_pos = wr_pos;
+    self->skip_bytes = 0;
+    return SCARD_RX_OVERRUN;
+  }
+
+  // Skip loopback echo
+  size_t skip = min_mp_uint_t(avail, self->skip_bytes);
+  self->skip_bytes -= skip;
+  avail -= skip;
+  self->rx_dma_rd_pos += skip;
+
+  // Copy data, up to two fragments if data is wrapped around end of buffer
+  size_t rd_idx = self->rx_dma_rd_pos & mask;
+  size_t len = min_mp_uint_t(avail, nbytes);
+  size_t len_1 = min_mp_uint_t(len, SCARD_RX_DMA_BUF_SIZE - rd_idx);
+  memcpy(buf, self->rx_dma_buf + rd_idx, len_1);
+  memcpy(buf + len_1, self->rx_dma_buf, len - len_1);
+  self->rx_dma_rd_pos += len;
+
+  return len;
+}
+
 /**
  * Create a machine.UART object and sets callback
  *
@@ -313,6 +550,11 @@ scard_handle_t scard_interface_init(mp_const_obj_t iface_id, mp_obj_t io_pin,
         raise_CardConnectionException("failed to configure USART pins");
       }
 
+      // Start reception
+      if(!start_rx_dma(self)) {
+        raise_CardConnectionException("failed to start USART DMA");
+      }
+
       // Save callback and self parameter
       self->cb_data_rx = cb_data_rx;
       self->cb_self = cb_self;
@@ -331,20 +573,7 @@ scard_handle_t scard_interface_init(mp_const_obj_t iface_id, mp_obj_t io_pin,
 }
 
 size_t scard_rx_readinto(scard_handle_t handle, uint8_t* buf, size_t nbytes) {
-  size_t bytes_read = 0;
-  uint8_t* p_data = buf;
-
-  while(bytes_read <= nbytes && uart_rx_any(handle->uart_obj)) {
-    if(handle->skip_bytes) {
-      volatile int dummy = uart_rx_char(handle->uart_obj);
-      (void)dummy;
-      --handle->skip_bytes;
-    } else {
-      *p_data++ = uart_rx_char(handle->uart_obj);
-      ++bytes_read;
-    }
-  }
-  return bytes_read;
+  return rx_dma_read(handle, buf, nbytes);
 }
 
 bool scard_tx_write(scard_handle_t handle, const uint8_t* buf, size_t nbytes) {
@@ -366,9 +595,26 @@ bool scard_tx_write(scard_handle_t handle, const uint8_t* buf, size_t nbytes) {
   return (errcode == 0 && bytes_written == nbytes);
 }
 
+void scard_interface_reset(scard_handle_t handle) {
+  // Restore default rate that could be changed by PPS exchange
+  set_baudrate(&handle->sc_handle, handle->p_usart_dsc->id, SCARD_ETU, 1U);
+  handle->skip_bytes = 0;
+  handle->rx_dma_rd_pos = rx_dma_wr_pos(handle);
+}
+
+bool scard_interface_set_etu(scard_handle_t handle, uint32_t f, uint32_t d) {
+  if(scard_module_debug) {
+    printf("\r\nSC interface rate: F = %lu, D = %lu", (unsigned long)f,
+           (unsigned long)d);
+  }
+  return set_baudrate(&handle->sc_handle, handle->p_usart_dsc->id, f, d);
+}
+
 void scard_interface_deinit(scard_handle_t handle) {
   scard_inst_t* self = (scard_inst_t*)handle;
 
+  stop_rx_dma(self);
+
   // Deinitialize machine.UART
   if(self->machine_uart_obj) {
     deinit_machine_uart(self->machine_uart_obj);
@@ -433,8 +679,9 @@ scard_pin_state_t scard_pin_read_debounce(scard_pin_dsc_t* p_pin,
 }
 
 /**
- * Callback method for UART interrupt
+ * Callback method for UART idle line interrupt
  *
+ * Passes all data collected by DMA to the handler of received data.
  * @param self_in  an instance of smart card interface
  * @param unused   UART object (unused)
  * @return         None
@@ -444,25 +691,15 @@ STATIC mp_obj_t uart_callback(mp_obj_t self_in, mp_obj_t unused) {
   (void)unused;
 
   uint8_t buf[32];
-  uint8_t* p_buf = buf;
+  size_t len;
 
-  while(uart_rx_any(self->uart_obj)) {
-    if(self->skip_bytes) {
-      volatile int dummy = uart_rx_char(self->uart_obj);
-      (void)dummy;
-      --self->skip_bytes;
+  while((len = rx_dma_read(self, buf, sizeof(buf))) != 0) {
+    if(len == SCARD_RX_OVERRUN) {
+      self->cb_data_rx(self->cb_self, NULL, SCARD_RX_OVERRUN);
     } else {
-      *p_buf++ = uart_rx_char(self->uart_obj);
-      if(p_buf >= buf + sizeof(buf)) {
-        self->cb_data_rx(self->cb_self, buf, sizeof(buf));
-        p_buf = buf;
-      }
+      self->cb_data_rx(self->cb_self, buf, len);
     }
   }
-
-  if(p_buf > buf) {
-    self->cb_data_rx(self->cb_self, buf, p_buf - buf);
-  }
   return mp_const_none;
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_2(uart_callback_obj, uart_callback);
@@ -10,11 +10,22 @@
 #define SCARD_IO_H_INCLUDED
 
 #include "uart.h"
+#include "dma.h"
+
+/// machine.Timer is used to run background tasks
+#define SCARD_HAS_MACHINE_TIMER         (1)
+
+/// Size of DMA receive buffer, power of 2 fitting loopback echo of maximal
+/// T=1 block followed by maximal response block (2 x 259 bytes)
+#define SCARD_RX_DMA_BUF_SIZE           (1024U)
 
 /// USART descriptor
 typedef struct scard_usart_dsc_ {
-  uint8_t id;                ///< USART identifier, e.g. 3 for USART3
-  USART_TypeDef* handle;     ///< USART handle
+  uint8_t id;                         ///< USART identifier, e.g. 3 for USART3
+  USART_TypeDef* handle;              ///< USART handle
+  const dma_descr_t* rx_dma;          ///< dma.c descriptor of the RX stream
+  DMA_Stream_TypeDef* rx_dma_stream;  ///< DMA stream used to receive data
+  uint32_t rx_dma_channel;            ///< DMA channel of USART RX request
 } scard_usart_dsc_t;
 
 /// Smart card interface instance and handle
@@ -28,6 +39,10 @@ typedef struct scard_inst_ {
   mp_obj_t cb_self;                      ///< Self parameter for callback(s)
   bool suppress_loopback;                ///< If true suppresses loopback echo
   size_t skip_bytes;                     ///< Counter of skipped bytes
+  DMA_HandleTypeDef rx_dma;              ///< HAL handle of receive DMA
+  volatile uint32_t rx_dma_wraps;        ///< Number of DMA buffer wraps
+  uint32_t rx_dma_rd_pos;                ///< Total number of bytes read
+  uint8_t rx_dma_buf[SCARD_RX_DMA_BUF_SIZE]; ///< DMA circular buffer
 } scard_inst_t, *scard_handle_t;
 
 /// Pin descriptor
@@ -0,0 +1,141 @@
+/**
+ * @file       scard_io.c
+ * @brief      MicroPython uscard module: unix port
+ *
+ * Each interface is bound to its own virtual card implemented in vcard.c.
+ * Interface IDs are integers 0...SCARD_VIRTUAL_INTERFACES-1.
+ */
+
+#include <stdio.h>
+#include "py/obj.h"
+#include "py/runtime.h"
+#include "py/builtin.h"
+#include "py/mperrno.h"
+#include "py/mphal.h"
+#include "py/smallint.h"
+#include "scard.h"
+
+/// Number of virtual interfaces
+#define SCARD_VIRTUAL_INTERFACES        (4)
+
+/// Type information for smart card interface instance
+const mp_obj_type_t scard_inst_type;
+
+bool scard_interface_exists(mp_const_obj_t iface_id) {
+  if(mp_obj_is_int(iface_id)) {
+    mp_int_t id = mp_obj_get_int(iface_id);
+    return id >= 0 && id < SCARD_VIRTUAL_INTERFACES;
+  }
+  return false;
+}
+
+void scard_interface_print_by_id(const mp_print_t *print, mp_const_obj_t iface_id) {
+  if(mp_obj_is_int(iface_id)) {
+    mp_printf(print, "VCARD%d", mp_obj_get_int(iface_id));
+  } else {
+    mp_print_str(print, "unknown");
+  }
+}
+
+void scard_interface_print(const mp_print_t *print, scard_handle_t handle) {
+  if(handle) {
+    scard_interface_print_by_id(print, MP_OBJ_NEW_SMALL_INT(handle->id));
+  } else {
+    mp_print_str(print, "NULL");
+  }
+}
+
+scard_handle_t scard_interface_init(mp_const_obj_t iface_id, mp_obj_t io_pin,
+                                    mp_obj_t clk_pin,
+                                    scard_cb_data_rx_t cb_data_rx,
+                                    mp_obj_t cb_self) {
+  scard_handle_t self = NULL;
+  (void)io_pin;
+  (void)clk_pin;
+
+  if(mp_obj_is_int(iface_id)) {
+    if(scard_interface_exists(iface_id)) {
+      // Create a new interface instance
+      self = m_new0(scard_inst_t, 1);
+      self->base.type = &scard_inst_type;
+      self->id = mp_obj_get_int(iface_id);
+      if(!vcard_init(&self->card, NULL)) {
+        raise_CardConnectionException("failed to initialize virtual card");
+      }
+      self->prev_ticks_ms = mp_hal_ticks_ms();
+
+      // Save callback and self parameter
+      self->cb_data_rx = cb_data_rx;
+      self->cb_self = cb_self;
+
+      if(scard_module_debug) {
+        printf("\r\nVirtual SC interface created");
+      }
+    } else {
+      mp_raise_ValueError("interface does not exists");
+    }
+  } else {
+    mp_raise_TypeError("interface id is not an integer");
+  }
+
+  return self;
+}
+
+size_t scard_rx_readinto(scard_handle_t handle, uint8_t* buf, size_t nbytes) {
+  // Advance time of the virtual card
+  mp_uint_t ticks_ms = mp_hal_ticks_ms();
+  mp_uint_t elapsed = scard_ticks_diff(ticks_ms, handle->prev_ticks_ms);
+  handle->prev_ticks_ms = ticks_ms;
+  vcard_timer_task(&handle->card, (uint32_t)elapsed);
+
+  return vcard_read(&handle->card, buf, nbytes);
+}
+
+bool scard_tx_write(scard_handle_t handle, const uint8_t* buf, size_t nbytes) {
+  vcard_write(&handle->card, buf, nbytes);
+  return true;
+}
+
+void scard_interface_reset(scard_handle_t handle) {
+  handle->prev_ticks_ms = mp_hal_ticks_ms();
+  vcard_reset(&handle->card);
+}
+
+bool scard_interface_set_etu(scard_handle_t handle, uint32_t f, uint32_t d) {
+  // Virtual card has no physical line, any rate is accepted
+  (void)handle;
+  return f && d;
+}
+
+void scard_interface_deinit(scard_handle_t handle) {
+  // Delete interface instance
+  m_del(scard_inst_t, handle, 1);
+
+  if(scard_module_debug) {
+    printf("\r\nVirtual SC interface deleted");
+  }
+}
+
+scard_pin_dsc_t scard_pin(mp_obj_t user_obj, mp_int_t polarity, bool output,
+                          scard_pin_state_t def_state) {
+  scard_pin_dsc_t pin = {
+    .user_obj = user_obj,
+    .invert = polarity ? 0U : 1U,
+    .output = output ? 1U : 0U,
+    .state = 0U
+  };
+  if(output) {
+    scard_pin_write(&pin, def_state);
+  }
+  return pin;
+}
+
+scard_pin_state_t scard_pin_read_debounce(scard_pin_dsc_t* p_pin,
+                                          uint32_t time_ms) {
+  (void)time_ms;
+  return scard_pin_read(p_pin);
+}
+
+const mp_obj_type_t scard_inst_type = {
+  { &mp_type_type },
+};
@@ -0,0 +1,59 @@
+/**
+ * @file       scard_io.h
+ * @brief      MicroPython uscard module: unix port definitions
+ *
+ * The unix port connects CardConnection to a virtual T=1 card (vcard.c)
+ * running in the same process, so that the complete module may be exercised
+ * without hardware.
+ */
+
+#ifndef SCARD_IO_H_INCLUDED
+/// Avoids multiple inclusion of this file
+#define SCARD_IO_H_INCLUDED
+
+#include "vcard.h"
+
+/// machine.Timer is not available, background tasks run in blocking calls
+#define SCARD_HAS_MACHINE_TIMER         (0)
+
+/// Smart card interface instance and handle
+typedef struct scard_inst_ {
+  mp_obj_base_t base;                    ///< Pointer to type of base class
+  mp_int_t id;                           ///< Interface identifier
+  vcard_t card;                          ///< Virtual card
+  mp_uint_t prev_ticks_ms;               ///< Ticks of previous card time update
+  scard_cb_data_rx_t cb_data_rx;         ///< Callback for received data
+  mp_obj_t cb_self;                      ///< Self parameter for callback(s)
+} scard_inst_t, *scard_handle_t;
+
+/// Pin descriptor, pins are emulated
+typedef struct scard_pin_dsc_ {
+  mp_obj_t user_obj;        ///< User-provided pin object, unused
+  unsigned int invert : 1;  ///< Logic: 0 - normal, 1 - inverted
+  unsigned int output : 1;  ///< Pin is an output
+  unsigned int state : 1;   ///< Physical state of an output pin
+} scard_pin_dsc_t;
+
+/**
+ * Writes state to output register of a pin
+ * @param p_pin  pointer to pin descriptor
+ * @param state  pin state
+ */
+static inline void scard_pin_write(scard_pin_dsc_t* p_pin, scard_pin_state_t state) {
+  p_pin->state = (unsigned int)state ^ p_pin->invert;
+}
+
+/**
+ * Returns state of a pin
+ *
+ * Input pins are always active: the virtual card is always inserted.
+ * @param p_pin  pointer to pin descriptor
+ */
+static inline scard_pin_state_t scard_pin_read(scard_pin_dsc_t* p_pin) {
+  if(p_pin->output) {
+    return (scard_pin_state_t)(p_pin->state ^ p_pin->invert);
+  }
+  return ACT;
+}
+
+#endif // SCARD_IO_H_INCLUDED
@@ -12,6 +12,10 @@
 
 /// Maximal number sequential of TX errors for T=1 protocol
 #define MAX_TX_ERRORS_T1                (2U)
+/// Default size of T=1 transmit FIFO, fits short APDU with any IFSC >= 32
+#define DEF_TX_BUF_SIZE_T1              (600U)
+/// Default size of T=1 receive buffer, fits short response APDU
+#define DEF_RX_BUF_SIZE_T1              (256U + 2U)
 
 /// Error descriptor
 typedef struct error_dsc_ {
@@ -107,6 +111,16 @@ static void t1_cb_handle_event(t1_ev_code_t ev_code, const void* ev_prm,
                                void* p_user_prm) {
   proto_handle_t handle = (proto_handle_t)p_user_prm;
 
+  // Failed PPS exchange: if the card was asked for a higher rate, request
+  // a reset and negotiate again at default rate
+  if(t1_ev_pps_failed == ev_code &&
+     t1_get_config(handle->ctx.t1, t1_cfg_max_d) > 1) {
+    handle->pps_fallback = true;
+    proto_ev_prm_t prm = { .reset_request = NULL };
+    handle->cb_handle_event(handle->cb_self, proto_ev_reset_request, prm);
+    return;
+  }
+
   if(t1_is_error_event(ev_code) && t1_ev_err_incompatible != ev_code) {
     emit_error(handle, error_text(errors_t1, ev_code));
   } else {
@@ -140,12 +154,108 @@ static void t1_cb_handle_event(t1_ev_code_t ev_code, const void* ev_prm,
         }
         break;
 
+      case t1_ev_rate_changed: {
+          const t1_rate_t* p_rate = (const t1_rate_t*)ev_prm;
+          proto_rate_t rate = {
+            .f = p_rate->f, .d = p_rate->d, .f_max_hz = p_rate->f_max_hz
+          };
+          proto_ev_prm_t prm = { .rate_changed = &rate };
+          handle->cb_handle_event(handle->cb_self, proto_ev_rate_changed, prm);
+        }
+        break;
+
       default:
         break; // Ignore unknown event
     }
   }
 }
 
+/**
+ * Returns expected length of response APDU including status bytes
+ *
+ * Command APDU is decoded according to ISO/IEC 7816-4 both in short and
+ * extended length forms.
+ * @param apdu  buffer containing command APDU
+ * @param len   length of command APDU in bytes
+ * @return      expected length of response APDU, 0 if not known
+ */
+static size_t expected_response_len(const uint8_t* apdu, size_t len) {
+  size_t le = 0U;
+
+  if(len == 5U) {                                   // Case 2S
+    le = apdu[4] ? apdu[4] : 256U;
+  } else if(len > 5U && apdu[4]) {
+    if(len == 6U + apdu[4]) {                       // Case 4S
+      le = apdu[len - 1U] ? apdu[len - 1U] : 256U;
+    }
+  } else if(len == 7U) {                            // Case 2E
+    le = ((size_t)apdu[5] << 8) | apdu[6];
+    le = le ? le : 65536U;
+  } else if(len > 7U) {
+    size_t lc = ((size_t)apdu[5] << 8) | apdu[6];
+    if(len == 9U + lc) {                            // Case 4E
+      le = ((size_t)apdu[len - 2U] << 8) | apdu[len - 1U];
+      le = le ? le : 65536U;
+    }
+  }
+  return le + 2U;
+}
+
+/**
+ * T=1: replaces transmit buffer if a larger one is needed or if the buffer
+ * should be returned to default size
+ *
+ * New buffer is allocated before the old one is released, so the protocol
+ * keeps its buffer if the replacement is not possible at the moment.
+ *
+ * @param handle  protocol handle
+ * @param size    required size of the buffer in bytes
+ * @param shrink  if true the buffer may be reduced to the given size
+ * @return        true if the buffer has enough space
+ */
+static bool fit_tx_buf_t1(proto_handle_t handle, size_t size, bool shrink) {
+  if(size > handle->tx_buf_size ||
+     (shrink && size != handle->tx_buf_size)) {
+    uint8_t* buf = m_new(uint8_t, size);
+    if(!t1_set_tx_buffer(handle->ctx.t1, buf, size)) {
+      m_del(uint8_t, buf, size);
+      return size <= handle->tx_buf_size;
+    }
+    if(handle->tx_buf) {
+      m_del(uint8_t, handle->tx_buf, handle->tx_buf_size);
+    }
+    handle->tx_buf = buf;
+    handle->tx_buf_size = size;
+  }
+  return true;
+}
+
+/**
+ * T=1: replaces receive buffer if a larger one is needed or if the buffer
+ * should be returned to default size
+ *
+ * @param handle  protocol handle
+ * @param size    required size of the buffer in bytes
+ * @param shrink  if true the buffer may be reduced to the given size
+ * @return        true if the buffer has enough space
+ */
+static bool fit_rx_buf_t1(proto_handle_t handle, size_t size, bool shrink) {
+  if(size > handle->rx_buf_size ||
+     (shrink && size != handle->rx_buf_size)) {
+    uint8_t* buf = m_new(uint8_t, size);
+    if(!t1_set_rx_buffer(handle->ctx.t1, buf, size)) {
+      m_del(uint8_t, buf, size);
+      return size <= handle->rx_buf_size;
+    }
+    if(handle->rx_buf) {
+      m_del(uint8_t, handle->rx_buf, handle->rx_buf_size);
+    }
+    handle->rx_buf = buf;
+    handle->rx_buf_size = size;
+  }
+  return true;
+}
+
 /**
  * T=1: releases protocol context
  *
@@ -157,6 +267,12 @@ static void deinit_t1(proto_handle_t handle) {
       m_del(t1_inst_t, handle->ctx.t1, 1);
       handle->ctx.t1 = NULL;
     }
+    if(handle->tx_buf) {
+      m_del(uint8_t, handle->tx_buf, handle->tx_buf_size);
+    }
+    if(handle->rx_buf) {
+      m_del(uint8_t, handle->rx_buf, handle->rx_buf_size);
+    }
     m_del(proto_inst_t, handle, 1);
   }
 }
@@ -180,8 +296,12 @@ static proto_handle_t init_t1(proto_cb_serial_out_t cb_serial_out,
   handle->cb_handle_event = cb_handle_event;
   handle->cb_self = cb_self;
   handle->tx_errors = 0U;
+  handle->pps_fallback = false;
 
-  if(!t1_init(handle->ctx.t1, t1_cb_serial_out, t1_cb_handle_event, handle)) {
+  if(!t1_init(handle->ctx.t1, t1_cb_serial_out, t1_cb_handle_event, handle) ||
+     !t1_set_config(handle->ctx.t1, t1_cfg_max_d, SCARD_MAX_D) ||
+     !fit_tx_buf_t1(handle, DEF_TX_BUF_SIZE_T1, true) ||
+     !fit_rx_buf_t1(handle, DEF_RX_BUF_SIZE_T1, true)) {
     deinit_t1(handle);
     return NULL;
   }
@@ -197,7 +317,16 @@ static proto_handle_t init_t1(proto_cb_serial_out_t cb_serial_out,
  */
 static void reset_t1(proto_handle_t handle, bool wait_atr) {
   if(handle) {
+    // After failed PPS exchange the next session uses default rate
+    if(wait_atr) {
+      t1_set_config(handle->ctx.t1, t1_cfg_max_d,
+                    handle->pps_fallback ? 1 : SCARD_MAX_D);
+      handle->pps_fallback = false;
+    }
     t1_reset(handle->ctx.t1, wait_atr);
+    // Release memory taken by extended length APDUs
+    fit_tx_buf_t1(handle, DEF_TX_BUF_SIZE_T1, true);
+    fit_rx_buf_t1(handle, DEF_RX_BUF_SIZE_T1, true);
   }
 }
 
@@ -235,6 +364,21 @@ static void serial_in_t1(proto_handle_t handle, const uint8_t* buf,
   }
 }
 
+/**
+ * T=1: handles loss of received bytes
+ *
+ * @param handle  protocol handle
+ */
+static void serial_error_t1(proto_handle_t handle) {
+  if(scard_module_debug) {
+    printf(" <rx overrun>");
+  }
+
+  if(handle) {
+    t1_serial_error(handle->ctx.t1);
+  }
+}
+
 /**
  * T=1: transmits APDU
  *
@@ -246,7 +390,13 @@ static void serial_in_t1(proto_handle_t handle, const uint8_t* buf,
 static void transmit_apdu_t1(proto_handle_t handle, const uint8_t* apdu,
                              size_t len) {
   if(handle) {
-    if(!t1_transmit_apdu(handle->ctx.t1, apdu, len)) {
+    // Buffers grow on demand to fit extended length APDUs
+    size_t tx_size = t1_tx_buffer_size(handle->ctx.t1, len);
+    size_t rx_size = expected_response_len(apdu, len);
+    rx_size = (rx_size > DEF_RX_BUF_SIZE_T1) ? rx_size : DEF_RX_BUF_SIZE_T1;
+    if(!fit_tx_buf_t1(handle, tx_size, false) ||
+       !fit_rx_buf_t1(handle, rx_size, false) ||
+       !t1_transmit_apdu(handle->ctx.t1, apdu, len)) {
       emit_error(handle, "error transmitting APDU");
     }
   }
@@ -305,6 +455,7 @@ const proto_impl_t protocols[] = {
     .reset         = reset_t1,
     .timer_task    = timer_task_t1,
     .serial_in     = serial_in_t1,
+    .serial_error  = serial_error_t1,
     .transmit_apdu = transmit_apdu_t1,
     .set_timeouts  = set_timeouts_t1
   }
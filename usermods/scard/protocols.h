@@ -38,6 +38,8 @@ typedef enum proto_ev_code_ {
   proto_ev_atr_received,  ///< ATR is received; parameter: proto_atr_t*
   proto_ev_connect,       ///< Connection established
   proto_ev_apdu_received, ///< APDU is received; parameter: proto_apdu_t*
+  proto_ev_rate_changed,  ///< Transmission rate changed; param.: proto_rate_t*
+  proto_ev_reset_request, ///< Protocol requests card reset to recover
   proto_ev_error          ///< Error; parameter: const char string
 } proto_ev_code_t;
 
@@ -53,11 +55,23 @@ typedef struct proto_apdu_ {
   size_t len;          ///< Length of APDU in bytes
 } proto_apdu_t;
 
+/// Parameter of proto_ev_rate_changed
+///
+/// New rate must be applied to the interface before the next call of timer
+/// task function.
+typedef struct proto_rate_ {
+  uint16_t f;          ///< Clock rate conversion integer, Fi
+  uint8_t d;           ///< Baud rate adjustment integer, Di
+  uint32_t f_max_hz;   ///< Maximal clock frequency supported by card, Hz
+} proto_rate_t;
+
 typedef union proto_ev_prm_ {
   void* none;                        ///< Parameter of proto_ev_none
   const proto_atr_t* atr_received;   ///< Parameter of proto_ev_atr_received
   void* connect;                     ///< Parameter of proto_ev_connect (n/a)
   const proto_apdu_t* apdu_received; ///< Parameter of proto_ev_apdu_received
+  const proto_rate_t* rate_changed;  ///< Parameter of proto_ev_rate_changed
+  void* reset_request;               ///< Parameter of proto_ev_reset_request
   const char* error;                 ///< Parameter of proto_ev_error
 } proto_ev_prm_t;
 
@@ -98,6 +112,11 @@ typedef struct proto_inst_ {
   proto_cb_handle_event_t cb_handle_event;  ///< Callback handling events
   mp_obj_t cb_self;                         ///< Self parameter for callback
   uint8_t tx_errors;                        ///< Counter of transmit errors
+  bool pps_fallback;                        ///< Use default rate after reset
+  uint8_t* tx_buf;                          ///< Protocol transmit buffer
+  size_t tx_buf_size;                       ///< Size of tx_buf in bytes
+  uint8_t* rx_buf;                          ///< Protocol receive buffer
+  size_t rx_buf_size;                       ///< Size of rx_buf in bytes
 } proto_inst_t, *proto_handle_t;
 
 /**
@@ -148,6 +167,14 @@ typedef void (*proto_timer_task_t)(proto_handle_t handle, uint32_t elapsed_ms);
 typedef void (*proto_serial_in_t)(proto_handle_t handle, const uint8_t* buf,
                                   size_t len);
 
+/**
+ * Notifies protocol that received bytes were lost
+ *
+ * The block being received is handled as corrupted.
+ * @param handle  protocol handle
+ */
+typedef void (*proto_serial_error_t)(proto_handle_t handle);
+
 /**
  * Transmits APDU
  *
@@ -183,6 +210,7 @@ typedef struct proto_implementation_ {
   proto_reset_t         reset;         ///< Reset function
   proto_timer_task_t    timer_task;    ///< Timer task function
   proto_serial_in_t     serial_in;     ///< Serial input function
+  proto_serial_error_t  serial_error;  ///< Serial input error function
   proto_transmit_apdu_t transmit_apdu; ///< APDU transmission function
   proto_set_timeouts_t  set_timeouts;  ///< Timeout configuration function
 } proto_impl_t;
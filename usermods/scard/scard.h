@@ -20,6 +20,11 @@
 /// Elementary time unit, etu, equals to 372 clock cycles
 #define SCARD_ETU                       (372U)
 
+#ifndef SCARD_MAX_D
+/// Maximal baud rate adjustment factor, Di, requested from a card with PPS
+#define SCARD_MAX_D                     (64)
+#endif
+
 /** @defgroup scard_ansi ANSI colors, used for debug output
  * @{ */
 /// Red
@@ -46,12 +51,17 @@ typedef enum scard_pin_state_ {
   ACT   = 1, ///< Inactive state
 } scard_pin_state_t;
 
+/// Length of received data reported when the interface has lost some bytes
+#define SCARD_RX_OVERRUN                ((size_t)-1)
+
 /**
  * Callback function handling received data
  *
  * This function is called by smart card interface when any data is received
  * from the card. It is guaranteed that this callback function is called from
  * a normal context, not from an interrupt service routine.
+ * If received data was lost, it is called with buf = NULL and
+ * len = SCARD_RX_OVERRUN.
  * @param self  instance of a class which method is called
  * @param buf   buffer containing received data
  * @param len   length of data block in bytes
@@ -128,7 +138,8 @@ extern scard_handle_t scard_interface_init(mp_const_obj_t iface_id,
  * @param handle  handle to smart card interface
  * @param buf     buffer receiving received data
  * @param nbytes  maximum number of bytes to read
- * @return        actual number of received bytes, 0 if no data available
+ * @return        actual number of received bytes, 0 if no data available,
+ *                SCARD_RX_OVERRUN if received data was lost
  */
 extern size_t scard_rx_readinto(scard_handle_t handle, uint8_t* buf,
                                 size_t nbytes);
@@ -147,6 +158,31 @@ extern size_t scard_rx_readinto(scard_handle_t handle, uint8_t* buf,
 extern bool scard_tx_write(scard_handle_t handle, const uint8_t* buf,
                            size_t nbytes);
 
+/**
+ * Prepares smart card interface for a new session
+ *
+ * Called while RST line is still asserted, straight before its release.
+ * Discards any stale received data.
+ *
+ * @param handle  handle to smart card interface
+ */
+extern void scard_interface_reset(scard_handle_t handle);
+
+/**
+ * Changes transmission rate of smart card interface
+ *
+ * Frequency of CLK is not changed, only the duration of elementary time unit
+ * becomes equal to f/d clock cycles. Default rate is restored by
+ * scard_interface_reset().
+ *
+ * @param handle  handle to smart card interface
+ * @param f       clock rate conversion integer, Fi
+ * @param d       baud rate adjustment integer, Di
+ * @return        true if successful
+ */
+extern bool scard_interface_set_etu(scard_handle_t handle, uint32_t f,
+                                    uint32_t d);
+
 /**
  * Deinitializes smart card interface
  *
@@ -43,7 +43,7 @@
 /// Maximum overhead of I-block
 #define MAX_IBLOCK_OVH                  (prologue_size + MAX_EDC_LEN)
 /// Maximum size of I-block
-#define MAX_IBLOCK_SIZE                 (T1_MAX_APDU_SIZE + MAX_IBLOCK_OVH)
+#define MAX_IBLOCK_SIZE                 (T1_MAX_LEN_VALUE + MAX_IBLOCK_OVH)
 
 /// Minimal number of bytes for a valid ATR
 #define ATR_MIN_BYTES                   2
@@ -76,6 +76,24 @@
 
 /// Identifier of PPS request and response
 #define PPSS                            0xFFU
+/// Minimal size of PPS request/response: PPSS, PPS0 and PCK
+#define PPS_MIN_SIZE                    3
+/// PPS0: bit indicating presence of PPS1
+#define PPS0_PPS1_BIT                   (1 << 4)
+/// PPS0: bit indicating presence of PPS2
+#define PPS0_PPS2_BIT                   (1 << 5)
+/// PPS0: bit indicating presence of PPS3
+#define PPS0_PPS3_BIT                   (1 << 6)
+/// TA2: bit indicating that transmission parameters are defined implicitly
+#define TA2_IMPLICIT_BIT                (1 << 4)
+/// Default value of clock rate conversion integer, Fd
+#define DEF_F                           372
+/// Default value of baud rate adjustment integer, Dd
+#define DEF_D                           1
+/// Default maximal clock frequency, fmax
+#define DEF_F_MAX_HZ                    5000000UL
+/// Minimal ratio F/D, USART needs at least 8 clock cycles per etu
+#define MIN_F_PER_D                     8U
 
 /// MAximal number of events in a list
 #define MAX_EVENTS                      3
@@ -97,10 +115,10 @@ enum {
 
 // PPS request/response fields
 enum {
-  pps_ppss = 0, ///< PPS request/response identifier
-  pps_pps0,     ///< PPS0 byte
-  pps_pck,      ///< PCK, XOR checksum
-  pps_size      ///< Size of PPS request/response
+  pps_ppss = 0,     ///< PPS request/response identifier
+  pps_pps0,         ///< PPS0 byte
+  pps_pps1,         ///< PPS1 byte, optional
+  pps_max_size = 6  ///< Maximal size of PPS request/response
 };
 
 /// One entry in extended configuration data table
@@ -183,9 +201,43 @@ static const ext_config_entry_t ext_config[t1_config_size] = {
   [t1_cfg_tm_response_max] = { .min = 1,       .max = TM_MAX,  .def = 4000   },
   [t1_cfg_use_crc]         = { .min = 0,       .max = 1,       .def = 0      },
   [t1_cfg_ifsc]            = { .min = IFS_MIN, .max = IFS_MAX, .def = 32     },
-  [t1_cfg_rx_skip_bytes]   = { .min = 0,       .max = 255,     .def = 0      }
+  [t1_cfg_rx_skip_bytes]   = { .min = 0,       .max = 255,     .def = 0      },
+  [t1_cfg_max_d]           = { .min = 1,       .max = 64,      .def = 1      }
 };
 
+/// Clock rate conversion integer Fi indexed by FI, 0 - RFU
+static const uint16_t fi_table[16] = {
+  372, 372, 558, 744, 1116, 1488, 1860, 0, 0, 512, 768, 1024, 1536, 2048, 0, 0
+};
+
+/// Maximal clock frequency in kHz indexed by FI, 0 - RFU
+static const uint16_t f_max_khz_table[16] = {
+  4000, 5000, 6000, 8000, 12000, 16000, 20000, 0, 0,
+  5000, 7500, 10000, 15000, 20000, 0, 0
+};
+
+/// Baud rate adjustment integer Di indexed by DI, 0 - RFU
+static const uint8_t di_table[16] = {
+  0, 1, 2, 4, 8, 16, 32, 64, 12, 20, 0, 0, 0, 0, 0, 0
+};
+
+/**
+ * Sets parameter of t1_ev_rate_changed event
+ * @param inst  protocol instance
+ * @param pps1  PPS1 byte coding transmission rate, -1 for default rate
+ */
+static void set_rate(t1_inst_t* inst, int16_t pps1) {
+  if(pps1 != -1) {
+    inst->rate.f = fi_table[(pps1 >> 4) & 0x0F];
+    inst->rate.d = di_table[pps1 & 0x0F];
+    inst->rate.f_max_hz = f_max_khz_table[(pps1 >> 4) & 0x0F] * 1000UL;
+  } else {
+    inst->rate.f = DEF_F;
+    inst->rate.d = DEF_D;
+    inst->rate.f_max_hz = DEF_F_MAX_HZ;
+  }
+}
+
 /**
  * Returns minimal of two size_t operands
  * @param a  operand A
@@ -385,6 +437,9 @@ void t1_reset(t1_inst_t* inst, bool wait_atr) {
     inst->rx_bad_block = false;
     inst->tmr_atr_timeout = wait_atr ? inst->config[t1_cfg_tm_atr] : 0;
     inst->tmr_response_timeout = 0;
+    inst->pps_pps1 = -1;
+    set_rate(inst, -1);
+    inst->ifsd_req_pending = false;
   }
 }
 
@@ -475,7 +530,8 @@ static bool push_iblock(t1_inst_t* inst, const uint8_t* inf, size_t inf_len,
 static inline size_t iblock_chain_size(const t1_inst_t* inst, size_t apdu_len,
                                        size_t ifsc) {
   if(ifsc) {
-    size_t iblock_overhead = prologue_size + edc_size(inst);
+    size_t iblock_overhead = sizeof(block_hdr_t) + prologue_size +
+                             edc_size(inst);
     size_t whole_blocks = apdu_len / ifsc;
     size_t extra_bytes = apdu_len % ifsc;
 
@@ -630,6 +686,28 @@ static event_t tx_fifo_send_last_block(t1_inst_t* inst) {
   return event_none;
 }
 
+/**
+ * Checks if the block at the head of transmit FIFO buffer is a part of chain
+ * still waiting for acknowledgment
+ *
+ * Block parameters are read from FIFO instead of tx_prev_block_prm because
+ * the latter is overwritten when reader sends R-block requesting
+ * retransmission of a corrupted acknowledgment.
+ * @param inst        protocol instance
+ * @param seq_number  sequence number "N(R)" of received R-block
+ * @return            true if block has "more data" bit and is acknowledged
+ */
+static bool tx_fifo_chained_block_acked(t1_inst_t* inst, uint8_t seq_number) {
+  if(tx_fifo_has_block(inst)) {
+    size_t read_idx = fifo_get_read_idx(&inst->tx_fifo);
+    block_hdr_t hdr;
+    fifo_read_buf(&inst->tx_fifo, &read_idx, (uint8_t*)&hdr, sizeof(hdr),
+                  sizeof(hdr));
+    return hdr.more_data && seq_number != hdr.seq_number;
+  }
+  return false;
+}
+
 /**
  * Removes last block from transmit FIFO buffer
  * @param inst  protocol instance
@@ -654,7 +732,18 @@ bool t1_init(t1_inst_t* inst, t1_cb_serial_out_t cb_serial_out,
     for(int i = 0; i < t1_config_size; i++) {
       inst->config[i] = ext_config[i].def;
     }
+#if T1_TX_FIFO_SIZE
     fifo_init(&inst->tx_fifo, inst->tx_fifo_buf, T1_TX_FIFO_SIZE);
+#else
+    fifo_init(&inst->tx_fifo, NULL, 0);
+#endif
+#if T1_MAX_APDU_SIZE
+    inst->rx_apdu = inst->rx_apdu_buf;
+    inst->rx_apdu_size = sizeof(inst->rx_apdu_buf);
+#else
+    inst->rx_apdu = NULL;
+    inst->rx_apdu_size = 0;
+#endif
     inst->rx_apdu_prm.apdu = inst->rx_apdu;
     t1_reset(inst, true);
     return true;
@@ -662,6 +751,37 @@ bool t1_init(t1_inst_t* inst, t1_cb_serial_out_t cb_serial_out,
   return false;
 }
 
+bool t1_set_tx_buffer(t1_inst_t* inst, uint8_t* buf, size_t size) {
+  if(inst && buf && size > MAX_IBLOCK_SIZE + sizeof(block_hdr_t) &&
+     !fifo_nused(&inst->tx_fifo)) {
+    fifo_init(&inst->tx_fifo, buf, size);
+    inst->tx_fifo_nblock = 0;
+    return true;
+  }
+  return false;
+}
+
+bool t1_set_rx_buffer(t1_inst_t* inst, uint8_t* buf, size_t size) {
+  if(inst && buf && size >= 2U &&
+     (inst->rx_new_apdu || !inst->rx_apdu_prm.len)) {
+    inst->rx_apdu = buf;
+    inst->rx_apdu_size = size;
+    inst->rx_apdu_prm.apdu = buf;
+    inst->rx_apdu_prm.len = 0;
+    return true;
+  }
+  return false;
+}
+
+size_t t1_tx_buffer_size(const t1_inst_t* inst, size_t apdu_len) {
+  if(inst) {
+    size_t size = iblock_chain_size(inst, apdu_len, inst->config[t1_cfg_ifsc]);
+    // FIFO buffer keeps one element unused
+    return size ? size + 1U : 0U;
+  }
+  return 0U;
+}
+
 bool t1_set_config(t1_inst_t* inst, t1_config_prm_id_t prm_id, int32_t value) {
   if(inst && prm_id >= 0 &&  prm_id < t1_config_size) {
     // Ensure that range is defined and value is within allowed range
@@ -829,8 +949,51 @@ static bool parse_atr(const uint8_t *buf, size_t len, t1_atr_decoded_t* p_atr) {
   return false;
 }
 
+/**
+ * Selects transmission rate from TA1 byte of ATR
+ *
+ * Fi is always taken from TA1. In negotiable mode D is the highest value not
+ * exceeding Di of the card and the maximal D supported by host, keeping at
+ * least MIN_F_PER_D clock cycles per etu. In specific mode the card uses Di as
+ * is, so it must be supported by host.
+ * @param inst      protocol instance
+ * @param ta1       TA1 byte, -1 if absent
+ * @param specific  true if card is in specific mode
+ * @return          PPS1 byte coding selected rate, -1 for default rate
+ */
+static int16_t select_rate(const t1_inst_t* inst, int16_t ta1, bool specific) {
+  if(ta1 != -1 && inst->config[t1_cfg_max_d] > DEF_D) {
+    uint8_t fi = (ta1 >> 4) & 0x0F;
+    uint8_t di_card = ta1 & 0x0F;
+    int32_t d_max = inst->config[t1_cfg_max_d];
+
+    if(fi_table[fi] && di_table[di_card]) {
+      if(specific) {
+        return (di_table[di_card] <= d_max &&
+                fi_table[fi] >= MIN_F_PER_D * di_table[di_card]) ? ta1 : -1;
+      }
+      uint8_t di_best = 0;
+      for(uint8_t di = 1; di < sizeof(di_table); di++) {
+        if(di_table[di] && di_table[di] <= di_table[di_card] &&
+           di_table[di] <= d_max && di_table[di] > di_table[di_best] &&
+           fi_table[fi] >= MIN_F_PER_D * di_table[di]) {
+          di_best = di;
+        }
+      }
+      if(fi_table[fi] != DEF_F || di_table[di_best] != DEF_D) {
+        return (int16_t)((fi << 4) | di_best);
+      }
+    }
+  }
+  return -1;
+}
+
 /**
  * Handles ATR message checking compatibility of the smart card
+ *
+ * If the card is in specific mode with transmission rate defined by TA1, the
+ * rate is saved in inst->rate and IFSD request is postponed until the host
+ * applies it.
  * @param inst          protocol instance
  * @param p_atr         pointer to ATR structure filled by this function
  * @param p_needs_ppsx  pointer to flag requesting PPS exchange
@@ -850,9 +1013,21 @@ static bool handle_atr(t1_inst_t* inst, t1_atr_decoded_t* p_atr,
       inst->config[t1_cfg_use_crc] = p_atr->t1_bytes[t1_atr_tc1] & 1;
     }
 
-    // If card is in negotiable mode we need to start PPS exchange
-    if(p_atr->t1_bytes[t1_atr_ta2] == -1 && p_needs_ppsx) {
-      *p_needs_ppsx = true;
+    int16_t ta1 = p_atr->global_bytes[t1_atr_ta1];
+    int16_t ta2 = p_atr->global_bytes[t1_atr_ta2];
+    if(ta2 == -1) {
+      // Card is in negotiable mode, we need to start PPS exchange
+      inst->pps_pps1 = select_rate(inst, ta1, false);
+      if(p_needs_ppsx) {
+        *p_needs_ppsx = true;
+      }
+    } else if(!(ta2 & TA2_IMPLICIT_BIT)) {
+      // Card is in specific mode using rate defined by TA1
+      int16_t pps1 = select_rate(inst, ta1, true);
+      if(pps1 != -1) {
+        set_rate(inst, pps1);
+        inst->ifsd_req_pending = true;
+      }
     }
     return true;
   }
@@ -964,15 +1139,25 @@ static bool timer_elapsed(uint32_t *p_timer, uint32_t elapsed_ms) {
  * @return      event or empty event with event_t::code = t1_ev_none
  */
 static event_t send_pps_request(t1_inst_t* inst) {
-  uint8_t buf[pps_size];
+  uint8_t buf[pps_max_size];
+  size_t len = 0;
 
   // Create request
-  buf[pps_ppss] = PPSS;               // PPS identifier
-  buf[pps_pps0] = atr_prot_t1;        // T=1 protocol, PPS1-PPS3 are absent
-  buf[pps_pck ] = PPSS ^ atr_prot_t1; // XOR checksum
+  buf[len++] = PPSS;                                      // PPS identifier
+  if(inst->pps_pps1 != -1) {
+    buf[len++] = PPS0_PPS1_BIT | atr_prot_t1;             // T=1, PPS1
+    buf[len++] = (uint8_t)inst->pps_pps1;                 // FI, DI
+  } else {
+    buf[len++] = atr_prot_t1;                             // T=1 protocol only
+  }
+  uint8_t pck = 0;
+  for(size_t i = 0; i < len; i++) {
+    pck ^= buf[i];
+  }
+  buf[len++] = pck;                                       // XOR checksum
 
   // Transmit request
-  if(!inst->cb_serial_out(buf, sizeof(buf), inst->p_user_prm)) {
+  if(!inst->cb_serial_out(buf, len, inst->p_user_prm)) {
     return event(t1_ev_err_serial_out);
   }
   inst->tmr_response_timeout = inst->config[t1_cfg_tm_response];
@@ -1011,22 +1196,53 @@ static event_t send_block_if_available(t1_inst_t* inst) {
       return event_none;
     }
   }
+  return event_none;
+}
+
+/**
+ * Returns expected size of PPS response
+ * @param buf   buffer holding beginning of PPS response
+ * @param size  number of received bytes
+ * @return      expected size of PPS response, 0 if not known yet
+ */
+static size_t pps_response_size(const uint8_t* buf, size_t size) {
+  if(size > pps_pps0) {
+    uint8_t pps0 = buf[pps_pps0];
+    return PPS_MIN_SIZE + ((pps0 & PPS0_PPS1_BIT) ? 1 : 0) +
+           ((pps0 & PPS0_PPS2_BIT) ? 1 : 0) + ((pps0 & PPS0_PPS3_BIT) ? 1 : 0);
+  }
+  return 0;
 }
 
 /**
  * Checks PPS response
- * @param inst  protocol instance
- * @param buf   buffer holding PPS response
- * @param size  size of PPS response
- * @return      true if PPS response is valid
+ *
+ * The card either confirms PPS1 by echoing it or omits PPS1 to continue at
+ * default rate.
+ * @param inst    protocol instance
+ * @param buf     buffer holding PPS response
+ * @param size    size of PPS response
+ * @param p_pps1  pointer to variable receiving PPS1 accepted by the card or -1
+ * @return        true if PPS response is valid
  */
 static bool check_pps_response(t1_inst_t* inst, const uint8_t* buf,
-                               size_t size) {
-  if( pps_size == size &&
+                               size_t size, int16_t* p_pps1) {
+  uint8_t pck = 0;
+  for(size_t i = 0; i < size; i++) {
+    pck ^= buf[i];
+  }
+
+  if( size >= PPS_MIN_SIZE && 0U == pck &&
       PPSS == buf[pps_ppss] &&
-      atr_prot_t1 == buf[pps_pps0] &&
-      0U == buf[pps_ppss] ^ buf[pps_pps0] ^ buf[pps_pck ] ) {
-    return true;
+      atr_prot_t1 == (buf[pps_pps0] & 0x0F) &&
+      !(buf[pps_pps0] & (PPS0_PPS2_BIT | PPS0_PPS3_BIT)) ) {
+    if(!(buf[pps_pps0] & PPS0_PPS1_BIT)) {
+      *p_pps1 = -1;
+      return true;
+    } else if(inst->pps_pps1 != -1 && buf[pps_pps1] == inst->pps_pps1) {
+      *p_pps1 = inst->pps_pps1;
+      return true;
+    }
   }
   return false;
 }
@@ -1042,17 +1258,29 @@ static bool check_pps_response(t1_inst_t* inst, const uint8_t* buf,
 static void handle_pps_data(t1_inst_t* inst, const uint8_t* buf,
                             size_t len, event_list_t* p_events) {
 
-  if(pps_size <= T1_RX_BUF_SIZE && inst->rx_buf_idx < T1_RX_BUF_SIZE) {
+  if(pps_max_size <= T1_RX_BUF_SIZE && inst->rx_buf_idx < T1_RX_BUF_SIZE) {
     const uint8_t* p_byte = buf;
-    while(inst->rx_buf_idx < pps_size && p_byte < (buf + len)) {
+    size_t exp_size = 0;
+    while(p_byte < (buf + len)) {
       inst->rx_buf[inst->rx_buf_idx++] = *p_byte++;
+      exp_size = pps_response_size(inst->rx_buf, inst->rx_buf_idx);
+      if(exp_size && inst->rx_buf_idx >= exp_size) {
+        break;
+      }
     }
-    if(inst->rx_buf_idx == pps_size) { // Handle PPS response
+    if(exp_size && inst->rx_buf_idx == exp_size) { // Handle PPS response
+      int16_t pps1 = -1;
       inst->tmr_response_timeout = 0U;
-      if(check_pps_response(inst, inst->rx_buf, inst->rx_buf_idx)) {
+      if(check_pps_response(inst, inst->rx_buf, inst->rx_buf_idx, &pps1)) {
         reset_rx(inst);
-        event_add(p_events, send_ifsd_request(inst));
         inst->fsm_state = t1_st_ifsd_setup;
+        if(pps1 != -1) { // Wait until host changes rate
+          set_rate(inst, pps1);
+          inst->ifsd_req_pending = true;
+          event_add(p_events, event_ext(t1_ev_rate_changed, &inst->rate));
+        } else {
+          event_add(p_events, send_ifsd_request(inst));
+        }
       } else {
         event_add(p_events, event(t1_ev_pps_failed));
       }
@@ -1067,16 +1295,26 @@ void t1_timer_task(t1_inst_t* inst, uint32_t elapsed_ms) {
     event_list_t events = { .len = 0U };
     t1_atr_decoded_t atr_decoded;
 
+    // Send IFSD request postponed until the host has changed transmission rate
+    if(inst->ifsd_req_pending && inst->fsm_state == t1_st_ifsd_setup) {
+      inst->ifsd_req_pending = false;
+      event_add(&events, send_ifsd_request(inst));
+    }
+
     // Process all timers
     if(timer_elapsed(&inst->tmr_interbyte_timeout, elapsed_ms)) {
       if(inst->fsm_state == t1_st_wait_atr) {
-        if(parse_atr(inst->rx_buf, inst->rx_buf_idx, &atr_decoded)) {
+        if(inst->rx_state != t1_rxs_drop &&
+           parse_atr(inst->rx_buf, inst->rx_buf_idx, &atr_decoded)) {
           bool needs_ppsx = false;
           if(handle_atr(inst, &atr_decoded, &needs_ppsx)) {
             event_add(&events, event_ext(t1_ev_atr_received, &atr_decoded));
             if(needs_ppsx) {
               event_add(&events, send_pps_request(inst));
               inst->fsm_state = t1_st_pps_exchange;
+            } else if(inst->ifsd_req_pending) { // Specific mode, new rate
+              event_add(&events, event_ext(t1_ev_rate_changed, &inst->rate));
+              inst->fsm_state = t1_st_ifsd_setup;
             } else { // needs_ppsx
               event_add(&events, send_ifsd_request(inst));
               inst->fsm_state = t1_st_ifsd_setup;
@@ -1121,7 +1359,8 @@ uint32_t t1_can_sleep_ms(const t1_inst_t* inst) {
   if(inst) {
     if(inst->tmr_interbyte_timeout ||
        inst->tmr_atr_timeout ||
-       inst->tmr_response_timeout) {
+       inst->tmr_response_timeout ||
+       inst->ifsd_req_pending) {
       return DEF_SLEEP_TIME_MS;
     }
   }
@@ -1166,7 +1405,7 @@ static bool save_apdu_data(t1_inst_t* inst, const uint8_t* inf,
     inst->rx_apdu_prm.len = 0;
   }
 
-  if(inst->rx_apdu_prm.len + inf_len <= sizeof(inst->rx_apdu)) {
+  if(inst->rx_apdu_prm.len + inf_len <= inst->rx_apdu_size) {
     const uint8_t *p_inf = inf;
     uint8_t *p_apdu = inst->rx_apdu + inst->rx_apdu_prm.len;
     for(size_t i = 0; i < inf_len; i++) {
@@ -1250,13 +1489,10 @@ static event_t resend_prev_block(t1_inst_t* inst) {
  */
 static event_t handle_rblock(t1_inst_t* inst, uint8_t seq_number,
                              t1_rblock_ack_t ack_code) {
-  const t1_block_prm_t *p_prev = &inst->tx_prev_block_prm;
-
   if(inst->fsm_state == t1_st_wait_response) {
     switch(ack_code) {
       case t1_rblock_ack_ok:
-        if(p_prev->block_type == t1_block_i && p_prev->iblock_prm.more_data &&
-           seq_number != inst->tx_last_seq_number) {
+        if(tx_fifo_chained_block_acked(inst, seq_number)) {
           tx_fifo_remove_last_block(inst);
           return send_block_if_available(inst);
         }
@@ -1518,6 +1754,9 @@ static event_t handle_t1_data(t1_inst_t* inst, const uint8_t* buf, size_t len) {
           reset_rx(inst);
         }
         break;
+
+      case t1_rxs_drop: // Not reached, bytes are ignored by t1_serial_in()
+        break;
     }
   }
   return ev;
@@ -1527,6 +1766,12 @@ void t1_serial_in(t1_inst_t* inst, const uint8_t* buf, size_t len) {
   if(inst && buf && len && inst->fsm_state != t1_st_error) {
     event_list_t events = { .len = 0U };
 
+    // Ignore the rest of a block with lost data
+    if(inst->rx_state == t1_rxs_drop) {
+      inst->tmr_interbyte_timeout = inst->config[t1_cfg_tm_interbyte];
+      return;
+    }
+
     // Handle received data
     switch(inst->fsm_state) {
       case t1_st_wait_atr:
@@ -1554,6 +1799,14 @@ void t1_serial_in(t1_inst_t* inst, const uint8_t* buf, size_t len) {
   }
 }
 
+void t1_serial_error(t1_inst_t* inst) {
+  if(inst && inst->fsm_state != t1_st_error) {
+    // Block is handled as corrupted by interbyte timeout
+    inst->rx_state = t1_rxs_drop;
+    inst->tmr_interbyte_timeout = inst->config[t1_cfg_tm_interbyte];
+  }
+}
+
 bool t1_transmit_apdu(t1_inst_t* inst, const uint8_t* apdu, size_t len) {
   if(inst && apdu && len && inst->fsm_state != t1_st_error) {
     if(push_iblock_chain(inst, apdu, len)) {
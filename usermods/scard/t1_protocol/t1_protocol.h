@@ -18,11 +18,14 @@
 
 // Compile-time settings
 #ifndef T1_TX_FIFO_SIZE
-  /// Transmit FIFO size
+  /// Size of transmit FIFO embedded in protocol instance, 0 - none, the buffer
+  /// must be provided with t1_set_tx_buffer()
   #define T1_TX_FIFO_SIZE               1024
 #endif
 #ifndef T1_MAX_APDU_SIZE
-  /// Maximal size of APDU supported by protocol implementation
+  /// Maximal size of received APDU supported by the buffer embedded in
+  /// protocol instance, 0 - none, the buffer must be provided with
+  /// t1_set_rx_buffer()
   #define T1_MAX_APDU_SIZE              255
 #endif
 #ifndef T1_MAX_TIMEOUT_MS
@@ -38,6 +41,8 @@ typedef enum {
   t1_ev_atr_received,       ///< ATR is received; parameter: t1_atr_decoded_t*
   t1_ev_connect,            ///< Connection established
   t1_ev_apdu_received,      ///< APDU is received; parameter: t1_apdu_t*
+  t1_ev_rate_changed,       ///< Card uses new transmission rate; parameter:
+                            ///< t1_rate_t*
   t1_ev_err_internal = 100, ///< Internal error, also beginning of error codes
   t1_ev_err_serial_out,     ///< Serial output error
   t1_ev_err_comm_failure,   ///< Smart card connection failed
@@ -58,6 +63,8 @@ typedef enum {
   t1_cfg_use_crc,          ///< Error detection code: 0 - LRC, 1 - CRC
   t1_cfg_ifsc,             ///< IFSC, card's maximum information block size
   t1_cfg_rx_skip_bytes,    ///< Number of dummy bytes to skip while receiving
+  t1_cfg_max_d,            ///< Maximal bit rate adjustment factor D supported
+                           ///< by host, 1 - default rate only
   t1_config_size           ///< Size of configuration, not an identifier
 } t1_config_prm_id_t;
 
@@ -132,6 +139,16 @@ typedef struct {
   size_t hist_nbytes;
 } t1_atr_decoded_t;
 
+/// Parameter of t1_ev_rate_changed event
+///
+/// Host must apply new rate before the next call of t1_timer_task(), ETU
+/// equals to F / (D * f) seconds where f is clock frequency of the card.
+typedef struct {
+  uint16_t f;         ///< Clock rate conversion integer, F
+  uint8_t d;          ///< Baud rate adjustment integer, D
+  uint32_t f_max_hz;  ///< Maximal clock frequency supported by the card
+} t1_rate_t;
+
 /// Parameter of t1_ev_apdu_received event
 typedef struct {
   const uint8_t *apdu; ///< Pointer to buffer containing APDU
@@ -161,6 +178,45 @@ typedef struct {
 T1_EXTERN bool t1_init(t1_inst_t* inst, t1_cb_serial_out_t cb_serial_out,
                        t1_cb_handle_event_t cb_handle_event, void* p_user_prm);
 
+/**
+ * Provides memory buffer for transmit FIFO
+ *
+ * Replaces the buffer embedded in protocol instance (if any). The buffer
+ * should hold all I-blocks of the longest command APDU, see
+ * t1_tx_buffer_size(). Buffer may be replaced only when transmit FIFO is
+ * empty, i.e. there is no command APDU waiting for response.
+ * @param inst  protocol instance
+ * @param buf   memory buffer, must stay valid until replaced
+ * @param size  size of the buffer in bytes
+ * @return      true - OK, false - failure
+ */
+T1_EXTERN bool t1_set_tx_buffer(t1_inst_t* inst, uint8_t* buf, size_t size);
+
+/**
+ * Provides memory buffer receiving response APDU
+ *
+ * Replaces the buffer embedded in protocol instance (if any). The buffer
+ * should hold the longest expected response APDU including SW1 SW2, up to
+ * 65536 + 2 bytes for extended length APDUs. Buffer may be replaced only when
+ * no response APDU is being received.
+ * @param inst  protocol instance
+ * @param buf   memory buffer, must stay valid until replaced
+ * @param size  size of the buffer in bytes
+ * @return      true - OK, false - failure
+ */
+T1_EXTERN bool t1_set_rx_buffer(t1_inst_t* inst, uint8_t* buf, size_t size);
+
+/**
+ * Returns size of transmit FIFO buffer needed for a command APDU
+ *
+ * Result depends on IFSC and error detection code in use, so it is valid
+ * only for the current connection.
+ * @param inst      protocol instance
+ * @param apdu_len  length of command APDU in bytes
+ * @return          buffer size in bytes, 0 if failed
+ */
+T1_EXTERN size_t t1_tx_buffer_size(const t1_inst_t* inst, size_t apdu_len);
+
 /**
  * Sets configuration parameter
  *
@@ -234,6 +290,15 @@ T1_EXTERN uint32_t t1_can_sleep_ms(const t1_inst_t* inst);
  */
 T1_EXTERN void t1_serial_in(t1_inst_t* inst, const uint8_t* buf, size_t len);
 
+/**
+ * Notifies protocol that received bytes were lost, i.e. by buffer overrun
+ *
+ * Bytes are ignored until the card stops transmitting, then the block being
+ * received is handled as corrupted: an R-block requests its retransmission.
+ * @param inst   protocol instance
+ */
+T1_EXTERN void t1_serial_error(t1_inst_t* inst);
+
 /**
  * Transmits APDU
  * @param inst  protocol instance
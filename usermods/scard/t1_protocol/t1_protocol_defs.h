@@ -40,7 +40,8 @@ typedef enum {
   t1_rxs_pcb,      ///< Waiting for PCB byte
   t1_rxs_len,      ///< Waiting for LEN byte
   t1_rxs_inf,      ///< Receiving INF bytes
-  t1_rxs_edc       ///< Receiving EDC byte(s)
+  t1_rxs_edc,      ///< Receiving EDC byte(s)
+  t1_rxs_drop      ///< Ignoring bytes after lost data
 } t1_rx_state_t;
 
 /// T=1 protocol block type
@@ -109,8 +110,10 @@ typedef struct {
   void* p_user_prm;
   /// FSM state
   t1_fsm_state_t fsm_state;
-  /// Memory buffer for TX FIFO
+#if T1_TX_FIFO_SIZE
+  /// Embedded memory buffer for TX FIFO
   uint8_t tx_fifo_buf[T1_TX_FIFO_SIZE];
+#endif
   /// FIFO buffer
   fifo_buf_inst_t tx_fifo;
   /// Number of stored data blocks in TX FIFO
@@ -139,8 +142,14 @@ typedef struct {
   t1_rx_state_t rx_state;
   /// Number of bytes expected by receiver
   int32_t rx_expected_bytes;
+#if T1_MAX_APDU_SIZE
+  /// Embedded buffer storing received APDU + 2 status bytes
+  uint8_t rx_apdu_buf[T1_MAX_APDU_SIZE + 2U];
+#endif
   /// Buffer storing received APDU + 2 status bytes
-  uint8_t rx_apdu[T1_MAX_APDU_SIZE + 2U];
+  uint8_t* rx_apdu;
+  /// Size of rx_apdu buffer in bytes
+  size_t rx_apdu_size;
   /// Parameter of t1_ev_apdu_received event
   t1_apdu_t rx_apdu_prm;
   /// Flag indicating that a new APDU is going to be received
@@ -155,6 +164,12 @@ typedef struct {
   uint32_t tmr_atr_timeout;
   /// Timer for response timeout
   uint32_t tmr_response_timeout;
+  /// PPS1 byte proposed to the card, -1 if default rate is requested
+  int16_t pps_pps1;
+  /// Parameter of t1_ev_rate_changed event
+  t1_rate_t rate;
+  /// IFSD request is postponed until the host applies new rate
+  bool ifsd_req_pending;
 } t1_inst_t;
 
 #endif // T1_PROTOCOL_DEFS_H_PART1, T1_PROTOCOL_DEFS_H_PART2
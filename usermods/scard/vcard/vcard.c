@@ -0,0 +1,589 @@
+/**
+ * @file       vcard.c
+ * @brief      Virtual ISO/IEC 7816 T=1 smart card
+ */
+
+#include <string.h>
+#include "vcard.h"
+
+/// NAD byte sent by the card
+#define NAD_VALUE                       0x00
+/// Bit mask used to obtain block type marker from PCB byte
+#define PCB_MARKER_MASK                 0xC0
+/// I-block: sequence number, "N(S)" bit in PCB byte
+#define IB_NS_BIT                       0x40
+/// I-block: more-data bit, "M" in PCB byte
+#define IB_M_BIT                        0x20
+/// R-block marker in PCB byte: 2 higher bits are 10b
+#define RB_MARKER                       0x80
+/// R-block: sequence number, "N(R)" bit in PCB byte
+#define RB_NS_BIT                       0x10
+/// R-block: acknowledgement code
+#define RB_ACK_MASK                     0x0F
+/// S-block marker in PCB byte, 2 higher bits are 11b
+#define SB_MARKER                       0xC0
+/// S-block: response bit
+#define SB_RESP_BIT                     0x20
+/// S-block: command mask
+#define SB_CMD_MASK                     0x1F
+/// Size of T=1 prologue
+#define PROLOGUE_SIZE                   3U
+/// Default IFSD as defined by ISO/IEC 7816-3
+#define IFSD_DEFAULT                    32U
+/// Identifier of PPS request and response
+#define PPSS                            0xFFU
+/// TB3 advertised in ATR: BWI = 4, CWI = 5
+#define ATR_TB3                         0x45U
+/// FI and DI of default transmission rate
+#define FIDI_DEFAULT                    0x11U
+/// PPS0: bit indicating presence of PPS1
+#define PPS0_PPS1_BIT                   0x10U
+
+/// R-block acknowledgement codes
+enum {
+  ack_ok = 0x00,       ///< Error free
+  ack_err_edc = 0x01,  ///< EDC and/or parity error
+  ack_err_other = 0x02 ///< Other errors
+};
+
+/// S-block command codes
+enum {
+  sblock_resynch = 0x00, ///< Resynchronization
+  sblock_ifs = 0x01,     ///< Information field size
+  sblock_abort = 0x02,   ///< Abortion
+  sblock_wtx = 0x03      ///< Waiting time extension
+};
+
+/// Status word: success
+static const uint8_t sw_ok[] = { 0x90, 0x00 };
+/// Status word: wrong length
+static const uint8_t sw_wrong_length[] = { 0x67, 0x00 };
+/// Historical bytes of ATR
+static const uint8_t hist_bytes[] = { 'v', 'c', 'a', 'r', 'd' };
+/// Baud rate adjustment integer Di indexed by DI, 0 - RFU
+static const uint8_t di_table[16] = {
+  0, 1, 2, 4, 8, 16, 32, 64, 12, 20, 0, 0, 0, 0, 0, 0
+};
+
+/**
+ * Calculates LRC or CRC error detection code as configured
+ * @param card  card instance
+ * @param buf   source buffer
+ * @param len   number of bytes to process
+ * @param dst   destination buffer, at least 2 bytes
+ * @return      number of bytes written to destination buffer
+ */
+static size_t calc_edc(const vcard_t* card, const uint8_t* buf, size_t len,
+                       uint8_t* dst) {
+  if(card->config.use_crc) {
+    uint16_t crc = 0xFFFF;
+    while(len--) {
+      crc ^= *buf++;
+      for(int i = 0; i < 8; i++) {
+        crc = (crc & 1U) ? (crc >> 1) ^ 0x8408U : (crc >> 1);
+      }
+    }
+    dst[0] = (crc >> 8) & 0xFF;
+    dst[1] = crc & 0xFF;
+    return 2U;
+  }
+
+  uint8_t lrc = 0;
+  while(len--) {
+    lrc ^= *buf++;
+  }
+  dst[0] = lrc;
+  return 1U;
+}
+
+/**
+ * Returns size of EDC code
+ * @param card  card instance
+ * @return      size of EDC code in bytes
+ */
+static inline size_t edc_size(const vcard_t* card) {
+  return card->config.use_crc ? 2U : 1U;
+}
+
+/**
+ * Queues bytes for transmission to the reader
+ * @param card     card instance
+ * @param buf      buffer containing bytes
+ * @param len      number of bytes
+ */
+static void queue_output(vcard_t* card, const uint8_t* buf, size_t len) {
+  if(len <= sizeof(card->tx_buf)) {
+    memcpy(card->tx_buf, buf, len);
+    card->tx_len = len;
+    card->tx_pos = 0;
+    ++card->stats.blocks_out;
+  }
+}
+
+/**
+ * Codes T=1 block and queues it for transmission
+ * @param card     card instance
+ * @param pcb      PCB byte
+ * @param inf      information field
+ * @param inf_len  length of information field in bytes
+ */
+static void send_block(vcard_t* card, uint8_t pcb, const uint8_t* inf,
+                       size_t inf_len) {
+  uint8_t* p_block = card->last_block;
+
+  p_block[0] = NAD_VALUE;
+  p_block[1] = pcb;
+  p_block[2] = (uint8_t)inf_len;
+  if(inf_len) {
+    memcpy(p_block + PROLOGUE_SIZE, inf, inf_len);
+  }
+  size_t len = PROLOGUE_SIZE + inf_len;
+  len += calc_edc(card, p_block, len, p_block + len);
+  card->last_block_len = len;
+
+  queue_output(card, p_block, len);
+
+  // Corrupt the copy being sent, keeping original for retransmission
+  ++card->block_ctr;
+  if(card->config.corrupt_period &&
+     card->block_ctr % card->config.corrupt_period == 0) {
+    card->tx_buf[len - 1U] ^= 0x5A;
+    ++card->stats.corrupted;
+  }
+}
+
+/**
+ * Re-sends last block
+ * @param card  card instance
+ */
+static void resend_last_block(vcard_t* card) {
+  if(card->last_block_len) {
+    queue_output(card, card->last_block, card->last_block_len);
+    ++card->stats.retransmissions;
+  }
+}
+
+/**
+ * Sends R-block
+ * @param card      card instance
+ * @param ack_code  acknowledgement code
+ */
+static void send_rblock(vcard_t* card, uint8_t ack_code) {
+  send_block(card, RB_MARKER | (card->rx_seq_number ? RB_NS_BIT : 0) |
+             ack_code, NULL, 0);
+}
+
+/**
+ * Sends next I-block of response APDU
+ * @param card  card instance
+ */
+static void send_response_chunk(vcard_t* card) {
+  size_t rm_bytes = card->rsp_len - card->rsp_pos;
+  size_t inf_len = rm_bytes > card->ifsd ? card->ifsd : rm_bytes;
+  bool more_data = rm_bytes > inf_len;
+  uint8_t pcb = (card->tx_seq_number ? IB_NS_BIT : 0) |
+                (more_data ? IB_M_BIT : 0);
+
+  send_block(card, pcb, card->rsp + card->rsp_pos, inf_len);
+  card->tx_seq_number ^= 1;
+  card->rsp_pos += inf_len;
+}
+
+/**
+ * Built-in applet echoing data field of command APDU
+ *
+ * If Le is present the response is padded with a counting pattern or
+ * truncated to Le bytes.
+ * @param cmd         buffer containing command APDU
+ * @param cmd_len     length of command APDU in bytes
+ * @param rsp         buffer receiving response APDU including SW1 SW2
+ * @param rsp_size    size of response buffer in bytes
+ * @param p_user_prm  unused
+ * @return            length of response APDU in bytes
+ */
+static size_t echo_applet(const uint8_t* cmd, size_t cmd_len, uint8_t* rsp,
+                          size_t rsp_size, void* p_user_prm) {
+  (void)p_user_prm;
+  const uint8_t* data = NULL;
+  size_t lc = 0;
+  long le = -1;
+  bool ok = true;
+
+  if(cmd_len == 5U) { // Case 2S
+    le = cmd[4] ? cmd[4] : 256;
+  } else if(cmd_len > 5U && cmd[4]) {
+    lc = cmd[4];
+    data = cmd + 5;
+    if(cmd_len == 6U + lc) { // Case 4S
+      le = cmd[cmd_len - 1U] ? cmd[cmd_len - 1U] : 256;
+    } else {
+      ok = (cmd_len == 5U + lc); // Case 3S
+    }
+  } else if(cmd_len == 7U) { // Case 2E
+    le = ((long)cmd[5] << 8) | cmd[6];
+    le = le ? le : 65536L;
+  } else if(cmd_len > 7U) {
+    lc = ((size_t)cmd[5] << 8) | cmd[6];
+    data = cmd + 7;
+    if(cmd_len == 9U + lc) { // Case 4E
+      le = ((long)cmd[cmd_len - 2U] << 8) | cmd[cmd_len - 1U];
+      le = le ? le : 65536L;
+    } else {
+      ok = (cmd_len == 7U + lc && lc); // Case 3E
+    }
+  } else {
+    ok = (cmd_len == 4U); // Case 1
+  }
+  if(!ok) {
+    memcpy(rsp, sw_wrong_length, sizeof(sw_wrong_length));
+    return sizeof(sw_wrong_length);
+  }
+
+  size_t rsp_len = (le >= 0) ? (size_t)le : lc;
+  if(rsp_len + sizeof(sw_ok) > rsp_size) {
+    rsp_len = rsp_size - sizeof(sw_ok);
+  }
+  for(size_t i = 0; i < rsp_len; i++) {
+    rsp[i] = (i < lc) ? data[i] : (uint8_t)i;
+  }
+  memcpy(rsp + rsp_len, sw_ok, sizeof(sw_ok));
+  return rsp_len + sizeof(sw_ok);
+}
+
+/**
+ * Processes assembled command APDU and starts sending the response
+ * @param card  card instance
+ */
+static void process_command(vcard_t* card) {
+  if(card->cmd_overflow) {
+    memcpy(card->rsp, sw_wrong_length, sizeof(sw_wrong_length));
+    card->rsp_len = sizeof(sw_wrong_length);
+  } else {
+    vcard_cb_apdu_t cb_apdu = card->config.cb_apdu ?
+                              card->config.cb_apdu : echo_applet;
+    card->rsp_len = cb_apdu(card->cmd, card->cmd_len, card->rsp,
+                            sizeof(card->rsp), card->config.p_user_prm);
+  }
+  ++card->stats.apdus;
+  card->cmd_len = 0;
+  card->cmd_overflow = false;
+  card->rsp_pos = 0;
+  send_response_chunk(card);
+  card->tx_delay_ms = card->config.bwt_ms; // Busy executing the command
+}
+
+/**
+ * Handles I-block received from the reader
+ * @param card        card instance
+ * @param seq_number  sequence number, "N(S)"
+ * @param more_data   more-data bit, "M"
+ * @param inf         information field
+ * @param inf_len     length of information field in bytes
+ */
+static void handle_iblock(vcard_t* card, uint8_t seq_number, bool more_data,
+                          const uint8_t* inf, size_t inf_len) {
+  if(seq_number != card->rx_seq_number) { // Repeated block, we missed an ACK
+    resend_last_block(card);
+    return;
+  }
+  card->rx_seq_number ^= 1;
+
+  if(card->cmd_len + inf_len <= sizeof(card->cmd)) {
+    memcpy(card->cmd + card->cmd_len, inf, inf_len);
+    card->cmd_len += inf_len;
+  } else {
+    card->cmd_overflow = true;
+  }
+
+  if(more_data) {
+    send_rblock(card, ack_ok);
+  } else {
+    process_command(card);
+  }
+}
+
+/**
+ * Handles R-block received from the reader
+ * @param card        card instance
+ * @param seq_number  sequence number, "N(R)"
+ * @param ack_code    acknowledgement code
+ */
+static void handle_rblock(vcard_t* card, uint8_t seq_number,
+                          uint8_t ack_code) {
+  if(ack_code == ack_ok && seq_number == card->tx_seq_number &&
+     card->rsp_pos < card->rsp_len) {
+    send_response_chunk(card); // Reader acknowledged chained I-block
+  } else {
+    resend_last_block(card);
+  }
+}
+
+/**
+ * Handles S-block received from the reader
+ * @param card      card instance
+ * @param pcb       PCB byte
+ * @param inf       information field
+ * @param inf_len   length of information field in bytes
+ */
+static void handle_sblock(vcard_t* card, uint8_t pcb, const uint8_t* inf,
+                          size_t inf_len) {
+  if(pcb & SB_RESP_BIT) {
+    return; // Card never sends requests needing a response
+  }
+
+  switch(pcb & SB_CMD_MASK) {
+    case sblock_ifs:
+      if(inf_len == 1U && inf[0] >= 1U && inf[0] <= 254U) {
+        card->ifsd = inf[0];
+        send_block(card, pcb | SB_RESP_BIT, inf, inf_len);
+      } else {
+        send_rblock(card, ack_err_other);
+      }
+      break;
+
+    case sblock_resynch:
+      card->tx_seq_number = 0;
+      card->rx_seq_number = 0;
+      card->ifsd = IFSD_DEFAULT;
+      card->cmd_len = 0;
+      card->cmd_overflow = false;
+      card->rsp_len = 0;
+      card->rsp_pos = 0;
+      send_block(card, pcb | SB_RESP_BIT, NULL, 0);
+      break;
+
+    case sblock_abort:
+      card->cmd_len = 0;
+      card->rsp_len = 0;
+      card->rsp_pos = 0;
+      send_block(card, pcb | SB_RESP_BIT, NULL, 0);
+      break;
+
+    default:
+      send_rblock(card, ack_err_other);
+      break;
+  }
+}
+
+/**
+ * Handles complete T=1 block stored in receive buffer
+ * @param card  card instance
+ */
+static void handle_block(vcard_t* card) {
+  uint8_t edc[2];
+  size_t inf_len = card->rx_buf[2];
+  size_t checked_len = PROLOGUE_SIZE + inf_len;
+
+  calc_edc(card, card->rx_buf, checked_len, edc);
+  if(memcmp(edc, card->rx_buf + checked_len, edc_size(card)) != 0) {
+    ++card->stats.edc_errors;
+    send_rblock(card, ack_err_edc);
+    return;
+  }
+  ++card->stats.blocks_in;
+
+  uint8_t pcb = card->rx_buf[1];
+  const uint8_t* inf = card->rx_buf + PROLOGUE_SIZE;
+  switch(pcb & PCB_MARKER_MASK) {
+    case RB_MARKER:
+      handle_rblock(card, (pcb & RB_NS_BIT) ? 1 : 0, pcb & RB_ACK_MASK);
+      break;
+
+    case SB_MARKER:
+      handle_sblock(card, pcb, inf, inf_len);
+      break;
+
+    default:
+      handle_iblock(card, (pcb & IB_NS_BIT) ? 1 : 0,
+                    (pcb & IB_M_BIT) ? true : false, inf, inf_len);
+      break;
+  }
+}
+
+/**
+ * Returns expected length of PPS request from received bytes
+ * @param card  card instance
+ * @return      expected length in bytes or 0 if not known yet
+ */
+static size_t pps_expected_len(const vcard_t* card) {
+  if(card->rx_len < 2U) {
+    return 0;
+  }
+  uint8_t pps0 = card->rx_buf[1];
+  return 3U + ((pps0 >> 4) & 1U) + ((pps0 >> 5) & 1U) + ((pps0 >> 6) & 1U);
+}
+
+/**
+ * Handles complete PPS request
+ *
+ * Proposed rate is accepted if it uses Fi of the card and D not exceeding Di,
+ * otherwise the card answers without PPS1 keeping default rate.
+ * @param card  card instance
+ */
+static void handle_pps(vcard_t* card) {
+  uint8_t pck = 0;
+  for(size_t i = 0; i < card->rx_len; i++) {
+    pck ^= card->rx_buf[i];
+  }
+  card->rx_state = vcard_rxs_block;
+  if(pck != 0) {
+    return;
+  }
+  ++card->stats.blocks_in;
+
+  uint8_t pps0 = card->rx_buf[1];
+  if(!(pps0 & PPS0_PPS1_BIT)) {
+    queue_output(card, card->rx_buf, card->rx_len);
+    return;
+  }
+  if(card->config.ignore_pps1) {
+    return;
+  }
+
+  uint8_t pps1 = card->rx_buf[2];
+  uint8_t ta1 = card->config.ta1;
+  uint8_t d = di_table[pps1 & 0x0FU];
+  if(ta1 && (pps1 & 0xF0U) == (ta1 & 0xF0U) && d &&
+     d <= di_table[ta1 & 0x0FU]) {
+    queue_output(card, card->rx_buf, card->rx_len);
+    card->fidi = pps1;
+  } else {
+    uint8_t rsp[3] = { PPSS, pps0 & 0x0FU, 0 };
+    rsp[2] = rsp[0] ^ rsp[1];
+    queue_output(card, rsp, sizeof(rsp));
+  }
+}
+
+void vcard_default_config(vcard_config_t* p_config) {
+  if(p_config) {
+    p_config->ifsc = 254U;
+    p_config->use_crc = false;
+    p_config->specific_mode = false;
+    p_config->ta1 = 0;
+    p_config->ignore_pps1 = false;
+    p_config->bwt_ms = 0;
+    p_config->corrupt_period = 0;
+    p_config->cb_apdu = NULL;
+    p_config->p_user_prm = NULL;
+  }
+}
+
+bool vcard_init(vcard_t* card, const vcard_config_t* p_config) {
+  if(card) {
+    memset(card, 0, sizeof(vcard_t));
+    if(p_config) {
+      card->config = *p_config;
+    } else {
+      vcard_default_config(&card->config);
+    }
+    if(card->config.ifsc >= 1U && card->config.ifsc <= 254U) {
+      card->ifsd = IFSD_DEFAULT;
+      return true;
+    }
+  }
+  return false;
+}
+
+void vcard_reset(vcard_t* card) {
+  if(card) {
+    uint8_t atr[32];
+    size_t len = 0;
+
+    card->rx_state = vcard_rxs_pps;
+    card->fidi = (card->config.specific_mode && card->config.ta1) ?
+                 card->config.ta1 : FIDI_DEFAULT;
+    card->rx_len = 0;
+    card->tx_len = 0;
+    card->tx_pos = 0;
+    card->tx_delay_ms = 0;
+    card->last_block_len = 0;
+    card->ifsd = IFSD_DEFAULT;
+    card->tx_seq_number = 0;
+    card->rx_seq_number = 0;
+    card->cmd_len = 0;
+    card->cmd_overflow = false;
+    card->rsp_len = 0;
+    card->rsp_pos = 0;
+
+    atr[len++] = 0x3B;                                   // TS, direct
+    atr[len++] = (card->config.ta1 ? 0x90 : 0x80) |
+                 sizeof(hist_bytes);                     // T0: [TA1], TD1, K
+    if(card->config.ta1) {
+      atr[len++] = card->config.ta1;                     // TA1: FI, DI
+    }
+    atr[len++] = (card->config.specific_mode ? 0x90 : 0x80) | 0x01; // TD1
+    if(card->config.specific_mode) {
+      atr[len++] = 0x01;                                 // TA2: T=1
+    }
+    atr[len++] = (card->config.use_crc ? 0x70 : 0x30) | 0x01; // TD2
+    atr[len++] = card->config.ifsc;                      // TA3: IFSC
+    atr[len++] = ATR_TB3;                                // TB3: BWI, CWI
+    if(card->config.use_crc) {
+      atr[len++] = 0x01;                                 // TC3: CRC
+    }
+    memcpy(atr + len, hist_bytes, sizeof(hist_bytes));
+    len += sizeof(hist_bytes);
+    uint8_t tck = 0;
+    for(size_t i = 1; i < len; i++) {
+      tck ^= atr[i];
+    }
+    atr[len++] = tck;                                    // TCK
+
+    queue_output(card, atr, len);
+  }
+}
+
+void vcard_write(vcard_t* card, const uint8_t* buf, size_t len) {
+  if(!card || !buf) {
+    return;
+  }
+
+  card->stats.bytes_in += len;
+  if(card->tx_delay_ms) { // Busy card does not listen to the line
+    card->stats.ignored += len;
+    return;
+  }
+  for(size_t i = 0; i < len; i++) {
+    if(card->rx_len >= sizeof(card->rx_buf)) { // Garbage, start over
+      card->rx_len = 0;
+      send_rblock(card, ack_err_other);
+    }
+    card->rx_buf[card->rx_len++] = buf[i];
+
+    if(card->rx_state == vcard_rxs_pps && card->rx_buf[0] == PPSS) {
+      size_t exp_len = pps_expected_len(card);
+      if(exp_len && card->rx_len == exp_len) {
+        handle_pps(card);
+        card->rx_len = 0;
+      }
+    } else if(card->rx_len >= PROLOGUE_SIZE &&
+              card->rx_len == PROLOGUE_SIZE + card->rx_buf[2] +
+                              edc_size(card)) {
+      card->rx_state = vcard_rxs_block;
+      handle_block(card);
+      card->rx_len = 0;
+    }
+  }
+}
+
+size_t vcard_read(vcard_t* card, uint8_t* buf, size_t nbytes) {
+  if(!card || !buf || card->tx_delay_ms) {
+    return 0;
+  }
+
+  size_t len = card->tx_len - card->tx_pos;
+  if(len > nbytes) {
+    len = nbytes;
+  }
+  memcpy(buf, card->tx_buf + card->tx_pos, len);
+  card->tx_pos += len;
+  card->stats.bytes_out += len;
+  return len;
+}
+
+void vcard_timer_task(vcard_t* card, uint32_t elapsed_ms) {
+  if(card) {
+    card->tx_delay_ms -= (elapsed_ms < card->tx_delay_ms) ?
+                         elapsed_ms : card->tx_delay_ms;
+  }
+}
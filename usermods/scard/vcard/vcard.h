@@ -0,0 +1,185 @@
+/**
+ * @file       vcard.h
+ * @brief      Virtual ISO/IEC 7816 T=1 smart card, external API
+ *
+ * Card-side model of the T=1 protocol used to exercise the reader stack
+ * without hardware. It is pure C and shares no state with the reader side, so
+ * it may be driven either from the unix port of uscard module or from the
+ * host-side harness. The card generates ATR, negotiates rate with PPS, honours IFSD
+ * requests, chains long responses, retransmits blocks on R-block requests and
+ * optionally corrupts some of its blocks to exercise error recovery.
+ */
+
+#ifndef VCARD_H_INCLUDED
+/// Avoids multiple inclusion of this file
+#define VCARD_H_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef VCARD_MAX_CMD_SIZE
+  /// Maximal size of command APDU accepted by virtual card, extended length
+  #define VCARD_MAX_CMD_SIZE            (4U + 3U + 65535U + 2U)
+#endif
+#ifndef VCARD_MAX_RSP_SIZE
+  /// Maximal size of response APDU including status bytes, extended length
+  #define VCARD_MAX_RSP_SIZE            (65536U + 2U)
+#endif
+/// Size of buffers holding one T=1 block, ATR or PPS message
+#define VCARD_BLOCK_BUF_SIZE            (3U + 254U + 2U)
+
+/**
+ * Callback function processing command APDU
+ *
+ * @param cmd         buffer containing command APDU
+ * @param cmd_len     length of command APDU in bytes
+ * @param rsp         buffer receiving response APDU including SW1 SW2
+ * @param rsp_size    size of response buffer in bytes
+ * @param p_user_prm  user defined parameter
+ * @return            length of response APDU in bytes
+ */
+typedef size_t (*vcard_cb_apdu_t)(const uint8_t* cmd, size_t cmd_len,
+                                  uint8_t* rsp, size_t rsp_size,
+                                  void* p_user_prm);
+
+/// Configuration of virtual card
+typedef struct vcard_config_ {
+  /// IFSC advertised in ATR (TA3), 1...254
+  uint8_t ifsc;
+  /// Error detection code advertised in ATR (TC3): false - LRC, true - CRC
+  bool use_crc;
+  /// If true, ATR contains TA2 (specific mode) and PPS is not expected
+  bool specific_mode;
+  /// TA1 advertised in ATR: FI in higher nibble, DI in lower, 0 - absent
+  uint8_t ta1;
+  /// If true, card stays mute on PPS requests proposing a new rate
+  bool ignore_pps1;
+  /// Time in ms spent executing each command APDU, bytes sent by the reader
+  /// meanwhile are ignored
+  uint32_t bwt_ms;
+  /// Corrupt EDC of each N-th block sent by the card, 0 - never
+  uint32_t corrupt_period;
+  /// APDU handler, NULL selects built-in echo applet
+  vcard_cb_apdu_t cb_apdu;
+  /// User defined parameter passed to APDU handler
+  void* p_user_prm;
+} vcard_config_t;
+
+/// Statistics collected by virtual card
+typedef struct vcard_stats_ {
+  uint32_t bytes_in;        ///< Bytes received from reader
+  uint32_t bytes_out;       ///< Bytes sent to reader
+  uint32_t blocks_in;       ///< Valid blocks received from reader
+  uint32_t blocks_out;      ///< Blocks sent to reader, including ATR and PPS
+  uint32_t edc_errors;      ///< Blocks from reader with incorrect EDC
+  uint32_t retransmissions; ///< Blocks re-sent on request of reader
+  uint32_t corrupted;       ///< Blocks corrupted intentionally
+  uint32_t apdus;           ///< Processed command APDUs
+  uint32_t ignored;         ///< Bytes ignored while executing a command
+} vcard_stats_t;
+
+/// Receive state of virtual card
+typedef enum vcard_rx_state_ {
+  vcard_rxs_pps = 0, ///< PPS request or T=1 block may be received
+  vcard_rxs_block    ///< Only T=1 blocks are accepted
+} vcard_rx_state_t;
+
+/// Virtual card instance
+typedef struct vcard_ {
+  /// Configuration
+  vcard_config_t config;
+  /// Statistics
+  vcard_stats_t stats;
+  /// Receive state
+  vcard_rx_state_t rx_state;
+  /// FI and DI of the current transmission rate, 0x11 - default
+  uint8_t fidi;
+  /// Buffer holding incoming block or PPS request
+  uint8_t rx_buf[VCARD_BLOCK_BUF_SIZE];
+  /// Number of bytes in rx_buf[]
+  size_t rx_len;
+  /// Output buffer holding bytes queued for the reader
+  uint8_t tx_buf[VCARD_BLOCK_BUF_SIZE];
+  /// Number of bytes in tx_buf[]
+  size_t tx_len;
+  /// Read position within tx_buf[]
+  size_t tx_pos;
+  /// Time in ms remaining until the command is executed and the response
+  /// becomes available to the reader
+  uint32_t tx_delay_ms;
+  /// Copy of the last sent block used for retransmission
+  uint8_t last_block[VCARD_BLOCK_BUF_SIZE];
+  /// Length of last_block[] in bytes, 0 if none
+  size_t last_block_len;
+  /// Counter of sent blocks used for corruption
+  uint32_t block_ctr;
+  /// Reader's maximum information field size
+  uint8_t ifsd;
+  /// Sequence number "N(S)" of the next I-block sent by the card
+  uint8_t tx_seq_number;
+  /// Expected sequence number "N(S)" of the next I-block from reader
+  uint8_t rx_seq_number;
+  /// Command APDU assembled from chained I-blocks
+  uint8_t cmd[VCARD_MAX_CMD_SIZE];
+  /// Length of command APDU in bytes
+  size_t cmd_len;
+  /// Flag indicating that received command does not fit in cmd[]
+  bool cmd_overflow;
+  /// Response APDU
+  uint8_t rsp[VCARD_MAX_RSP_SIZE];
+  /// Length of response APDU in bytes
+  size_t rsp_len;
+  /// Number of response bytes already sent
+  size_t rsp_pos;
+} vcard_t;
+
+/**
+ * Fills configuration structure with default values
+ * @param p_config  configuration structure
+ */
+extern void vcard_default_config(vcard_config_t* p_config);
+
+/**
+ * Initializes virtual card
+ *
+ * Card stays silent until vcard_reset() is called.
+ * @param card      card instance, contents are "don't-care"
+ * @param p_config  configuration, NULL selects default configuration
+ * @return          true - OK, false - invalid configuration
+ */
+extern bool vcard_init(vcard_t* card, const vcard_config_t* p_config);
+
+/**
+ * Resets virtual card, queues ATR for transmission
+ * @param card  card instance
+ */
+extern void vcard_reset(vcard_t* card);
+
+/**
+ * Passes bytes sent by reader to virtual card
+ * @param card  card instance
+ * @param buf   buffer containing bytes
+ * @param len   number of bytes
+ */
+extern void vcard_write(vcard_t* card, const uint8_t* buf, size_t len);
+
+/**
+ * Reads bytes sent by virtual card to reader
+ *
+ * Nothing is returned while the card is executing a command.
+ * @param card    card instance
+ * @param buf     buffer receiving bytes
+ * @param nbytes  maximal number of bytes to read
+ * @return        number of bytes read
+ */
+extern size_t vcard_read(vcard_t* card, uint8_t* buf, size_t nbytes);
+
+/**
+ * Timer task, advances time of virtual card
+ * @param card        card instance
+ * @param elapsed_ms  time in milliseconds passed since previous call
+ */
+extern void vcard_timer_task(vcard_t* card, uint32_t elapsed_ms);
+
+#endif // VCARD_H_INCLUDED
@@ -0,0 +1,80 @@
+"""
+Filesystem throughput on SDRAM RAM disk, FAT compared to littlefs.
+Copy to the board and run after sdram.init(), works on unix as well:
+
+    import bench_fs
+    bench_fs.run()
+
+Every filesystem is formatted on a fresh RAMDevice, results are
+the best of several runs in KB/s.
+"""
+import os
+import time
+import sdram
+
+REPEAT = 3
+MOUNTPOINT = "/bench_ramdisk"
+
+
+def filesystems():
+    res = [("FAT", os.VfsFat)]
+    if hasattr(os, "VfsLfs2"):
+        res.append(("littlefs", os.VfsLfs2))
+    return res
+
+
+def best_of(fn, *args):
+    best = None
+    for _ in range(REPEAT):
+        t0 = time.ticks_us()
+        fn(*args)
+        dt = time.ticks_diff(time.ticks_us(), t0)
+        if best is None or dt < best:
+            best = dt
+    return best
+
+
+def write_file(fname, chunk, count):
+    with open(fname, "wb") as f:
+        for _ in range(count):
+            f.write(chunk)
+
+
+def read_file(fname, chunk):
+    with open(fname, "rb") as f:
+        while f.readinto(chunk):
+            pass
+
+
+def small_files(count):
+    # many small files, as created when storing wallets
+    for i in range(count):
+        with open("%s/s%d" % (MOUNTPOINT, i), "wb") as f:
+            f.write(b"x" * 100)
+    for i in range(count):
+        os.remove("%s/s%d" % (MOUNTPOINT, i))
+
+
+def kbps(size, us):
+    return size * 1000 // max(us, 1) * 1000 // 1024
+
+
+def run(size=256 * 1024, chunk_size=4096, small=20):
+    chunk = bytearray(chunk_size)
+    count = size // chunk_size
+    fname = MOUNTPOINT + "/big"
+    print("fs          write, KB/s  read, KB/s  %d files, us" % small)
+    for name, cls in filesystems():
+        bdev = sdram.RAMDevice(512)
+        cls.mkfs(bdev)
+        os.mount(cls(bdev), MOUNTPOINT)
+        try:
+            w = best_of(write_file, fname, chunk, count)
+            r = best_of(read_file, fname, chunk)
+            s = best_of(small_files, small)
+        finally:
+            os.umount(MOUNTPOINT)
+        print(
+            "%-10s %12d %11d %14d"
+            % (name, kbps(count * chunk_size, w), kbps(count * chunk_size, r), s)
+        )
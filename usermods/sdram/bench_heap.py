@@ -0,0 +1,85 @@
+"""
+Latency of SDRAM heap compared to internal SRAM.
+Copy to the board and run after sdram.init() and sdram.add_heap():
+
+    import bench_heap
+    bench_heap.run()
+
+Every workload runs on buffers allocated in internal SRAM and in SDRAM,
+results are the best of several runs in microseconds.
+"""
+import gc
+import time
+import hashlib
+import uctypes
+import sdram
+
+REPEAT = 5
+
+
+def in_sdram(obj):
+    start, size = sdram.heap_info()
+    return start <= uctypes.addressof(obj) < start + size
+
+
+def alloc(size, use_sdram):
+    prev = sdram.heap_first(use_sdram)
+    try:
+        return bytearray(size)
+    finally:
+        sdram.heap_first(prev)
+
+
+def best_of(fn, *args):
+    best = None
+    for _ in range(REPEAT):
+        t0 = time.ticks_us()
+        fn(*args)
+        dt = time.ticks_diff(time.ticks_us(), t0)
+        if best is None or dt < best:
+            best = dt
+    return best
+
+
+def copy(dst, src):
+    dst[:] = src
+
+
+def sha256(buf):
+    hashlib.sha256(buf).digest()
+
+
+def churn(use_sdram):
+    # many small objects, as created when parsing a transaction
+    prev = sdram.heap_first(use_sdram)
+    try:
+        lst = [(i, b"x" * 32) for i in range(500)]
+    finally:
+        sdram.heap_first(prev)
+    return lst
+
+
+def run(size=32 * 1024):
+    if sdram.heap_info() is None:
+        raise ValueError("call sdram.add_heap() first")
+    results = []
+    for use_sdram in (False, True):
+        gc.collect()
+        src = alloc(size, use_sdram)
+        dst = alloc(size, use_sdram)
+        if in_sdram(src) != use_sdram or in_sdram(dst) != use_sdram:
+            raise MemoryError("buffers are not in the requested memory")
+        results.append(
+            (
+                best_of(copy, dst, src),
+                best_of(sha256, src),
+                best_of(churn, use_sdram),
+            )
+        )
+        src = dst = None
+    print("workload       SRAM, us   SDRAM, us")
+    names = ("copy %dK" % (size // 1024), "sha256 %dK" % (size // 1024), "500 objects")
+    for i, name in enumerate(names):
+        print("%-12s %10d %11d" % (name, results[0][i], results[1][i]))
+    gc.collect()
+    print("gc.collect    %10d (all heaps)" % best_of(gc.collect))
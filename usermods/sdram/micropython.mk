@@ -3,4 +3,7 @@ ifeq ($(CMSIS_MCU),STM32F469xx)
 
 SRC_USERMOD += $(USERMOD_DIR)/sdram.c
 
+# sdram.add_heap() registers SDRAM as an additional GC heap area
+CFLAGS_USERMOD += -DMICROPY_GC_SPLIT_HEAP=1
+
 endif
@@ -3,6 +3,11 @@
 #include "py/obj.h"
 #include "py/runtime.h"
 #include "py/builtin.h"
+#include "py/gc.h"
+#include "py/mpstate.h"
+#include "py/objarray.h"
+#include "py/mperrno.h"
+#include "extmod/vfs.h"
 
 // works only together with udisplay module, for now...
 #include "stm32469i_discovery_sdram.h"
@@ -13,6 +18,20 @@
 #define SDRAM_START_ADDRESS ((size_t)0xC03EE000)
 #define SDRAM_END_ADDRESS   ((size_t)0xC1000000)
 
+// smallest region worth giving to GC
+#define SDRAM_HEAP_MIN_SIZE 0x1000  // 4 KB
+
+// GC heap occupies the top of SDRAM, RAMDevice gets what is left below it
+STATIC size_t sdram_heap_size = 0;
+// end of the memory used by RAMDevice instances created so far
+STATIC size_t sdram_ramdevice_end = SDRAM_START_ADDRESS;
+// true if SDRAM heap is searched before internal SRAM
+STATIC bool sdram_heap_first = false;
+
+STATIC size_t sdram_heap_start() {
+    return SDRAM_END_ADDRESS - sdram_heap_size;
+}
+
 typedef struct _mp_obj_sdram_ramdevice_t {
     mp_obj_base_t base;
     size_t start;
@@ -29,12 +48,17 @@ STATIC mp_obj_t sdram_ramdevice_make_new(const mp_obj_type_t *type,
     mp_obj_sdram_ramdevice_t *o = m_new_obj(mp_obj_sdram_ramdevice_t);
     o->base.type = type;
     o->start = SDRAM_START_ADDRESS;
-    o->len = SDRAM_END_ADDRESS-SDRAM_START_ADDRESS;
+    o->len = sdram_heap_start()-SDRAM_START_ADDRESS;
     if(n_args+n_kw > 0){
         o->block_size = mp_obj_get_int(args[0]);
     }else{
         o->block_size = 512;
     }
+    // round down to whole blocks
+    o->len -= o->len % o->block_size;
+    if(o->start+o->len > sdram_ramdevice_end){
+        sdram_ramdevice_end = o->start+o->len;
+    }
     return MP_OBJ_FROM_PTR(o);
 }
 
@@ -46,51 +70,96 @@ STATIC mp_obj_t sdram_ramdevice_copy(mp_obj_t self_in) {
     return MP_OBJ_FROM_PTR(o);
 }
 
-STATIC mp_obj_t sdram_ramdevice_readblocks(mp_obj_t self_in, 
-                                           mp_obj_t block_num, 
-                                           mp_obj_t buf) {
-    mp_obj_sdram_ramdevice_t *self = MP_OBJ_TO_PTR(self_in);
-    mp_buffer_info_t buffer;
-    mp_get_buffer_raise(buf, &buffer, MP_BUFFER_WRITE);
-    size_t start = self->start + mp_obj_get_int(block_num)*self->block_size;
-    if(start+buffer.len >= SDRAM_END_ADDRESS){
+// copies whole words when both buffers allow it,
+// FMC handles 32-bit accesses in a single burst
+STATIC void sdram_copy(uint8_t *dst, const uint8_t *src, size_t len) {
+    if((((size_t)dst | (size_t)src) & 3) == 0){
+        uint32_t *d = (uint32_t *)dst;
+        const uint32_t *s = (const uint32_t *)src;
+        size_t words = len / 4;
+        while(words >= 4){
+            d[0] = s[0]; d[1] = s[1]; d[2] = s[2]; d[3] = s[3];
+            d += 4; s += 4; words -= 4;
+        }
+        while(words--){
+            *d++ = *s++;
+        }
+        dst = (uint8_t *)d;
+        src = (const uint8_t *)s;
+        len &= 3;
+    }
+    memcpy(dst, src, len);
+}
+
+// address of block_num + offset, raises if len bytes don't fit the device
+STATIC size_t sdram_ramdevice_addr(mp_obj_sdram_ramdevice_t *self,
+                                   mp_obj_t block_num, size_t n_args,
+                                   const mp_obj_t *args, size_t len) {
+    mp_int_t block = mp_obj_get_int(block_num);
+    mp_int_t offset = 0;
+    if(n_args > 3){
+        offset = mp_obj_get_int(args[3]);
+    }
+    if(block < 0 || offset < 0){
         mp_raise_ValueError("Outer space...");
-        return mp_const_none;
     }
-    memcpy(buffer.buf, (uint8_t *)start, buffer.len);
+    size_t pos = block*self->block_size + offset;
+    if(pos+len > self->len){
+        mp_raise_ValueError("Outer space...");
+    }
+    return self->start + pos;
+}
+
+// readblocks(block_num, buf[, offset])
+STATIC mp_obj_t sdram_ramdevice_readblocks(size_t n_args, const mp_obj_t *args) {
+    mp_obj_sdram_ramdevice_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_buffer_info_t buffer;
+    mp_get_buffer_raise(args[2], &buffer, MP_BUFFER_WRITE);
+    size_t start = sdram_ramdevice_addr(self, args[1], n_args, args, buffer.len);
+    sdram_copy(buffer.buf, (uint8_t *)start, buffer.len);
     return mp_const_none;
 }
 
-STATIC mp_obj_t sdram_ramdevice_writeblocks(mp_obj_t self_in, 
-                                           mp_obj_t block_num, 
-                                           mp_obj_t buf) {
-    mp_obj_sdram_ramdevice_t *self = MP_OBJ_TO_PTR(self_in);
+// writeblocks(block_num, buf[, offset])
+// with offset only the given bytes are changed, so it works for partial blocks
+STATIC mp_obj_t sdram_ramdevice_writeblocks(size_t n_args, const mp_obj_t *args) {
+    mp_obj_sdram_ramdevice_t *self = MP_OBJ_TO_PTR(args[0]);
     mp_buffer_info_t buffer;
-    mp_get_buffer_raise(buf, &buffer, MP_BUFFER_READ);
-    size_t start = (self->start + mp_obj_get_int(block_num)*self->block_size);
-    if(start+buffer.len >= SDRAM_END_ADDRESS){
-        mp_raise_ValueError("Outer space...");
-        return mp_const_none;
-    }
-    memcpy((uint8_t *)start, buffer.buf, buffer.len);
+    mp_get_buffer_raise(args[2], &buffer, MP_BUFFER_READ);
+    size_t start = sdram_ramdevice_addr(self, args[1], n_args, args, buffer.len);
+    sdram_copy((uint8_t *)start, buffer.buf, buffer.len);
     return mp_const_none;
 }
 
+// Extended block protocol ioctl
+// RAM needs no erase and no sync, so these only report success
 STATIC mp_obj_t sdram_ramdevice_ioctl(mp_obj_t self_in, 
                                            mp_obj_t op, 
                                            mp_obj_t arg) {
     mp_obj_sdram_ramdevice_t *self = MP_OBJ_TO_PTR(self_in);
     mp_int_t op_int = mp_obj_get_int(op);
-    if(op_int == 4){
-        return mp_obj_new_int(self->len / self->block_size);
-    }else if(op_int == 5){
-        return mp_obj_new_int(self->block_size);
+    switch(op_int){
+        case MP_BLOCKDEV_IOCTL_INIT:
+        case MP_BLOCKDEV_IOCTL_DEINIT:
+        case MP_BLOCKDEV_IOCTL_SYNC:
+            return MP_OBJ_NEW_SMALL_INT(0);
+        case MP_BLOCKDEV_IOCTL_BLOCK_COUNT:
+            return mp_obj_new_int(self->len / self->block_size);
+        case MP_BLOCKDEV_IOCTL_BLOCK_SIZE:
+            return mp_obj_new_int(self->block_size);
+        case MP_BLOCKDEV_IOCTL_BLOCK_ERASE: {
+            mp_int_t block = mp_obj_get_int(arg);
+            if(block < 0 || (size_t)block >= self->len / self->block_size){
+                return MP_OBJ_NEW_SMALL_INT(-MP_EINVAL);
+            }
+            return MP_OBJ_NEW_SMALL_INT(0);
+        }
     }
     return mp_const_none;
 }
 
-STATIC MP_DEFINE_CONST_FUN_OBJ_3(sdram_ramdevice_readblocks_obj, sdram_ramdevice_readblocks);
-STATIC MP_DEFINE_CONST_FUN_OBJ_3(sdram_ramdevice_writeblocks_obj, sdram_ramdevice_writeblocks);
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(sdram_ramdevice_readblocks_obj, 3, 4, sdram_ramdevice_readblocks);
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(sdram_ramdevice_writeblocks_obj, 3, 4, sdram_ramdevice_writeblocks);
 STATIC MP_DEFINE_CONST_FUN_OBJ_3(sdram_ramdevice_ioctl_obj, sdram_ramdevice_ioctl);
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(sdram_ramdevice_copy_obj, sdram_ramdevice_copy);
 
@@ -127,6 +196,273 @@ STATIC mp_obj_t sdram_preallocated_size() {
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_0(sdram_preallocated_size_obj, sdram_preallocated_size);
 
+/***************** Named arena in preallocated memory ***************/
+
+// allocations are aligned to cache line / DMA2D friendly boundary
+#define SDRAM_ARENA_ALIGN       32
+#define SDRAM_ARENA_MAX_REGIONS 16
+// names are copied: qstrs of arbitrary names would never be freed
+#define SDRAM_ARENA_NAME_LEN    32
+
+typedef struct _sdram_region_t {
+    char name[SDRAM_ARENA_NAME_LEN]; // empty for a free block
+    size_t offset;  // from PREALLOCATED_SDRAM_PTR
+    size_t size;
+} sdram_region_t;
+
+// allocated and freed regions below the bump pointer
+STATIC sdram_region_t sdram_regions[SDRAM_ARENA_MAX_REGIONS];
+STATIC size_t sdram_region_count = 0;
+// everything above is free
+STATIC size_t sdram_arena_top = 0;
+
+// region name from str argument, must fit into sdram_region_t.name
+STATIC const char *sdram_region_name(mp_obj_t name_in, size_t *len) {
+    const char *name = mp_obj_str_get_data(name_in, len);
+    if(*len == 0 || *len >= SDRAM_ARENA_NAME_LEN || memchr(name, 0, *len) != NULL){
+        mp_raise_ValueError("Invalid region name");
+    }
+    return name;
+}
+
+STATIC bool sdram_region_is_free(const sdram_region_t *region) {
+    return region->name[0] == 0;
+}
+
+STATIC sdram_region_t *sdram_region_find(const char *name, size_t len) {
+    for(size_t i = 0; i < sdram_region_count; i++){
+        sdram_region_t *region = &sdram_regions[i];
+        if(strlen(region->name) == len && memcmp(region->name, name, len) == 0){
+            return region;
+        }
+    }
+    return NULL;
+}
+
+STATIC void sdram_region_set_name(sdram_region_t *region, const char *name, size_t len) {
+    memcpy(region->name, name, len);
+    region->name[len] = 0;
+}
+
+STATIC void sdram_region_remove(sdram_region_t *region) {
+    *region = sdram_regions[--sdram_region_count];
+}
+
+// returns free blocks touching the bump pointer to the arena and merges
+// adjacent free blocks, so the free list doesn't fragment forever
+STATIC void sdram_arena_coalesce() {
+    bool changed = true;
+    while(changed){
+        changed = false;
+        for(size_t i = 0; i < sdram_region_count && !changed; i++){
+            sdram_region_t *a = &sdram_regions[i];
+            if(!sdram_region_is_free(a)){
+                continue;
+            }
+            if(a->offset + a->size == sdram_arena_top){
+                sdram_arena_top = a->offset;
+                sdram_region_remove(a);
+                changed = true;
+                break;
+            }
+            for(size_t j = 0; j < sdram_region_count; j++){
+                sdram_region_t *b = &sdram_regions[j];
+                if(sdram_region_is_free(b) && a->offset + a->size == b->offset){
+                    a->size += b->size;
+                    sdram_region_remove(b);
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+STATIC mp_obj_t sdram_region_view(const sdram_region_t *region, size_t size) {
+    void *ptr = (void *)(PREALLOCATED_SDRAM_PTR + region->offset);
+    return mp_obj_new_memoryview(MP_OBJ_ARRAY_TYPECODE_FLAG_RW | 'B', size, ptr);
+}
+
+// sdram.alloc(name, size) - writable memoryview backed by SDRAM
+// Regions are shared by name: allocating an existing name returns
+// the same memory if it is large enough
+STATIC mp_obj_t sdram_alloc(mp_obj_t name_in, mp_obj_t size_in) {
+    size_t len;
+    const char *name = sdram_region_name(name_in, &len);
+    mp_int_t size = mp_obj_get_int(size_in);
+    if(size <= 0){
+        mp_raise_ValueError("Invalid size");
+    }
+    sdram_region_t *region = sdram_region_find(name, len);
+    if(region != NULL){
+        if((size_t)size > region->size){
+            mp_raise_ValueError("Region exists and is smaller");
+        }
+        return sdram_region_view(region, size);
+    }
+    size_t aligned = (size + SDRAM_ARENA_ALIGN - 1) & ~(SDRAM_ARENA_ALIGN - 1);
+    // first fit in the free list
+    for(size_t i = 0; i < sdram_region_count; i++){
+        region = &sdram_regions[i];
+        if(!sdram_region_is_free(region) || region->size < aligned){
+            continue;
+        }
+        // split the rest of the block if there is a free slot for it
+        if(region->size > aligned && sdram_region_count < SDRAM_ARENA_MAX_REGIONS){
+            sdram_region_t *rest = &sdram_regions[sdram_region_count++];
+            rest->name[0] = 0;
+            rest->offset = region->offset + aligned;
+            rest->size = region->size - aligned;
+            region->size = aligned;
+        }
+        sdram_region_set_name(region, name, len);
+        return sdram_region_view(region, size);
+    }
+    // bump allocation
+    if(aligned > PREALLOCATED_SDRAM_SIZE - sdram_arena_top){
+        mp_raise_msg(&mp_type_MemoryError, "SDRAM arena is full");
+    }
+    if(sdram_region_count == SDRAM_ARENA_MAX_REGIONS){
+        mp_raise_msg(&mp_type_MemoryError, "Too many SDRAM regions");
+    }
+    region = &sdram_regions[sdram_region_count++];
+    sdram_region_set_name(region, name, len);
+    region->offset = sdram_arena_top;
+    region->size = aligned;
+    sdram_arena_top += aligned;
+    return sdram_region_view(region, size);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(sdram_alloc_obj, sdram_alloc);
+
+// sdram.free(name) - returns region to the arena
+// memoryviews of the region must not be used afterwards
+STATIC mp_obj_t sdram_free(mp_obj_t name_in) {
+    size_t len;
+    const char *name = sdram_region_name(name_in, &len);
+    sdram_region_t *region = sdram_region_find(name, len);
+    if(region == NULL){
+        mp_raise_ValueError("Region not found");
+    }
+    region->name[0] = 0;
+    sdram_arena_coalesce();
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(sdram_free_obj, sdram_free);
+
+// sdram.arena_stats() - dict with size, used, free, largest_free and regions
+STATIC mp_obj_t sdram_arena_stats() {
+    size_t used = 0;
+    size_t regions = 0;
+    size_t largest = PREALLOCATED_SDRAM_SIZE - sdram_arena_top;
+    for(size_t i = 0; i < sdram_region_count; i++){
+        if(!sdram_region_is_free(&sdram_regions[i])){
+            used += sdram_regions[i].size;
+            regions++;
+        } else if(sdram_regions[i].size > largest){
+            largest = sdram_regions[i].size;
+        }
+    }
+    mp_obj_t stats = mp_obj_new_dict(5);
+    mp_obj_dict_store(stats, MP_OBJ_NEW_QSTR(MP_QSTR_size), mp_obj_new_int(PREALLOCATED_SDRAM_SIZE));
+    mp_obj_dict_store(stats, MP_OBJ_NEW_QSTR(MP_QSTR_used), mp_obj_new_int(used));
+    mp_obj_dict_store(stats, MP_OBJ_NEW_QSTR(MP_QSTR_free), mp_obj_new_int(PREALLOCATED_SDRAM_SIZE - used));
+    mp_obj_dict_store(stats, MP_OBJ_NEW_QSTR(MP_QSTR_largest_free), mp_obj_new_int(largest));
+    mp_obj_dict_store(stats, MP_OBJ_NEW_QSTR(MP_QSTR_regions), mp_obj_new_int(regions));
+    return stats;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(sdram_arena_stats_obj, sdram_arena_stats);
+
+// sdram.arena_reset() - frees all regions at once
+STATIC mp_obj_t sdram_arena_reset() {
+    sdram_region_count = 0;
+    sdram_arena_top = 0;
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(sdram_arena_reset_obj, sdram_arena_reset);
+
+/***************** SDRAM as a GC heap ***************/
+
+#if MICROPY_GC_SPLIT_HEAP
+// Exchanges descriptors of two GC heap areas keeping the list links in place,
+// so the allocator searches them in the opposite order
+STATIC void sdram_swap_areas(mp_state_mem_area_t *a, mp_state_mem_area_t *b) {
+    mp_state_mem_area_t tmp = *a;
+    *a = *b;
+    *b = tmp;
+    mp_state_mem_area_t *next = a->next;
+    a->next = b->next;
+    b->next = next;
+}
+
+// List slot of the SDRAM heap descriptor, it describes internal SRAM while
+// SDRAM heap is searched first
+STATIC mp_state_mem_area_t *sdram_heap_area = NULL;
+#endif
+
+// sdram.add_heap(size) - gives the top `size` bytes of SDRAM to GC
+STATIC mp_obj_t sdram_add_heap(mp_obj_t size_in) {
+#if MICROPY_GC_SPLIT_HEAP
+    mp_int_t size = mp_obj_get_int(size_in);
+    if(sdram_heap_size > 0){
+        mp_raise_ValueError("SDRAM heap is already added");
+    }
+    // keep heap aligned to 4K so RAMDevice keeps whole blocks
+    size = (size + SDRAM_HEAP_MIN_SIZE - 1) & ~(SDRAM_HEAP_MIN_SIZE - 1);
+    if(size < SDRAM_HEAP_MIN_SIZE || (size_t)size > SDRAM_END_ADDRESS-sdram_ramdevice_end){
+        mp_raise_ValueError("Invalid heap size");
+    }
+    sdram_heap_size = size;
+    gc_add((void *)sdram_heap_start(), (void *)SDRAM_END_ADDRESS);
+    // new area is appended to the end of the list
+    sdram_heap_area = &MP_STATE_MEM(area);
+    while(sdram_heap_area->next != NULL){
+        sdram_heap_area = sdram_heap_area->next;
+    }
+    return mp_obj_new_int(sdram_heap_size);
+#else
+    (void)size_in;
+    mp_raise_NotImplementedError("GC split heap is disabled");
+#endif
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(sdram_add_heap_obj, sdram_add_heap);
+
+// sdram.heap_first([flag]) - allocate from SDRAM heap before internal SRAM
+// Returns previous value, so the caller can restore it afterwards
+STATIC mp_obj_t sdram_heap_first_fn(size_t n_args, const mp_obj_t *args) {
+    bool prev = sdram_heap_first;
+    if(n_args > 0){
+        bool first = mp_obj_is_true(args[0]);
+#if MICROPY_GC_SPLIT_HEAP
+        if(first && sdram_heap_size == 0){
+            mp_raise_ValueError("SDRAM heap is not added");
+        }
+        if(first != sdram_heap_first){
+            sdram_swap_areas(&MP_STATE_MEM(area), sdram_heap_area);
+            sdram_heap_first = first;
+        }
+#else
+        if(first){
+            mp_raise_NotImplementedError("GC split heap is disabled");
+        }
+#endif
+    }
+    return mp_obj_new_bool(prev);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(sdram_heap_first_obj, 0, 1, sdram_heap_first_fn);
+
+// sdram.heap_info() - (start, size) of SDRAM heap or None
+STATIC mp_obj_t sdram_heap_info() {
+    if(sdram_heap_size == 0){
+        return mp_const_none;
+    }
+    mp_obj_t items[] = {
+        mp_obj_new_int_from_ull(sdram_heap_start()),
+        mp_obj_new_int(sdram_heap_size),
+    };
+    return mp_obj_new_tuple(2, items);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(sdram_heap_info_obj, sdram_heap_info);
+
 /****************************** MODULE ******************************/
 
 STATIC const mp_rom_map_elem_t sdram_module_globals_table[] = {
@@ -136,6 +472,15 @@ STATIC const mp_rom_map_elem_t sdram_module_globals_table[] = {
 
     { MP_ROM_QSTR(MP_QSTR_preallocated_ptr), MP_ROM_PTR(&sdram_preallocated_ptr_obj) },
     { MP_ROM_QSTR(MP_QSTR_preallocated_size), MP_ROM_PTR(&sdram_preallocated_size_obj) },
+
+    { MP_ROM_QSTR(MP_QSTR_alloc), MP_ROM_PTR(&sdram_alloc_obj) },
+    { MP_ROM_QSTR(MP_QSTR_free), MP_ROM_PTR(&sdram_free_obj) },
+    { MP_ROM_QSTR(MP_QSTR_arena_stats), MP_ROM_PTR(&sdram_arena_stats_obj) },
+    { MP_ROM_QSTR(MP_QSTR_arena_reset), MP_ROM_PTR(&sdram_arena_reset_obj) },
+
+    { MP_ROM_QSTR(MP_QSTR_add_heap), MP_ROM_PTR(&sdram_add_heap_obj) },
+    { MP_ROM_QSTR(MP_QSTR_heap_first), MP_ROM_PTR(&sdram_heap_first_obj) },
+    { MP_ROM_QSTR(MP_QSTR_heap_info), MP_ROM_PTR(&sdram_heap_info_obj) },
 };
 
 STATIC MP_DEFINE_CONST_DICT(sdram_module_globals, sdram_module_globals_table);
@@ -0,0 +1,10 @@
+# Native TaskQueue and Task for asyncio (extmod/moduasyncio.c) on all ports,
+# same token sequence as in mpconfigport.h so there is no redefinition warning
+CFLAGS_USERMOD += -DMICROPY_PY_UASYNCIO="(1)"
+
+ifeq ($(CMSIS_MCU),STM32F469xx)
+
+SRC_USERMOD += $(USERMOD_DIR)/tickless.c
+CFLAGS_USERMOD += -DMODULE_TICKLESS_ENABLED=1
+
+endif
@@ -0,0 +1,128 @@
+#include "py/obj.h"
+#include "py/runtime.h"
+#include "py/builtin.h"
+#include "py/mpstate.h"
+#include "py/mphal.h"
+#include "irq.h"
+#include "pendsv.h"
+#include "softtimer.h"
+#include "systick.h"
+
+// HAL millisecond counter, incremented by SysTick_Handler
+extern __IO uint32_t uwTick;
+
+/**
+ * Advances tick counter by n ticks doing what SysTick_Handler does on
+ * every tick: runs systick dispatch slots and schedules soft timers
+ * that are due. Called with interrupts disabled.
+ */
+STATIC void advance_ticks(uint32_t n){
+    for(uint32_t i = 0; i < n; i++){
+        uint32_t tick = uwTick + 1;
+        uwTick = tick;
+        systick_dispatch_t f = systick_dispatch_table[tick & (SYSTICK_DISPATCH_NUM_SLOTS - 1)];
+        if(f != NULL){
+            f(tick);
+        }
+        if(soft_timer_next == tick){
+            pendsv_schedule_dispatch(PENDSV_DISPATCH_SOFT_TIMER, soft_timer_handler);
+        }
+    }
+}
+
+/**
+ * Sleeps with WFI for up to ms milliseconds without SysTick interrupts.
+ *
+ * SysTick is reprogrammed to fire once at the end of the sleep instead of
+ * every millisecond, any other interrupt (USB, UART, timers, touchscreen)
+ * wakes the MCU earlier. On wakeup the tick counter is advanced by the time
+ * that passed and SysTick goes back to 1 ms period.
+ * Sleep ends at the tick the next soft timer (machine.Timer) is due.
+ * Sleep length is limited by 24-bit SysTick counter, ~90 ms at 180 MHz.
+ * Negative ms means "as long as possible".
+ * Returns number of milliseconds actually slept.
+ */
+STATIC mp_obj_t tickless_sleep_ms(mp_obj_t ms_obj){
+    mp_int_t ms = mp_obj_get_int(ms_obj);
+    // cycles per tick
+    uint32_t tick_cycles = SysTick->LOAD + 1;
+    mp_int_t max_ms = (SysTick_LOAD_RELOAD_Msk + 1) / tick_cycles - 1;
+    if(ms < 0 || ms > max_ms){
+        ms = max_ms;
+    }
+    // run scheduled callbacks first, they could make some task runnable
+    mp_handle_pending(true);
+    uint32_t irq_state = disable_irq();
+    if(MP_STATE_VM(sched_state) == MP_SCHED_PENDING){
+        enable_irq(irq_state);
+        return MP_OBJ_NEW_SMALL_INT(0);
+    }
+    // SysTick_Handler runs soft timers only when the tick matches exactly,
+    // so the sleep can't go past it. Without timers it's 2^32 ticks away.
+    uint32_t to_timer = soft_timer_next - uwTick;
+    if(to_timer != 0 && (uint32_t)ms > to_timer){
+        ms = to_timer;
+    }
+    if(ms < 2){
+        // nothing to gain, regular sleep until the next tick
+        __WFI();
+        enable_irq(irq_state);
+        return MP_OBJ_NEW_SMALL_INT(0);
+    }
+    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+    // cycles left until the next tick
+    uint32_t left = SysTick->VAL;
+    SysTick->LOAD = left + (ms - 1) * tick_cycles - 1;
+    SysTick->VAL = 0;
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+    __DSB();
+    // wakes up on any pending interrupt even with PRIMASK set
+    __WFI();
+    // reading CTRL clears COUNTFLAG, so read it only once
+    uint32_t ctrl = SysTick->CTRL;
+    SysTick->CTRL = ctrl & ~SysTick_CTRL_ENABLE_Msk;
+    mp_int_t slept;
+    if(ctrl & SysTick_CTRL_COUNTFLAG_Msk){
+        // full period, SysTick interrupt is pending and adds the last tick
+        slept = ms;
+        advance_ticks(ms - 1);
+        SysTick->LOAD = tick_cycles - 1;
+        SysTick->VAL = 0;
+        SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+    }else{
+        // woken up by another interrupt
+        uint32_t done = SysTick->LOAD - SysTick->VAL;
+        slept = 0;
+        if(done >= left){
+            slept = 1 + (done - left) / tick_cycles;
+            left = tick_cycles - (done - left) % tick_cycles;
+        }else{
+            left -= done;
+        }
+        advance_ticks(slept);
+        // finish the current tick, the new reload value applies after it
+        SysTick->LOAD = left - 1;
+        SysTick->VAL = 0;
+        SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+        SysTick->LOAD = tick_cycles - 1;
+    }
+    enable_irq(irq_state);
+    return MP_OBJ_NEW_SMALL_INT(slept);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(tickless_sleep_ms_obj, tickless_sleep_ms);
+
+/****************************** MODULE ******************************/
+
+STATIC const mp_rom_map_elem_t tickless_module_globals_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_tickless) },
+    { MP_ROM_QSTR(MP_QSTR_sleep_ms), MP_ROM_PTR(&tickless_sleep_ms_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(tickless_module_globals, tickless_module_globals_table);
+
+const mp_obj_module_t tickless_user_cmodule = {
+    .base = { &mp_type_module },
+    .globals = (mp_obj_dict_t*)&tickless_module_globals,
+};
+
+MP_REGISTER_MODULE(MP_QSTR_tickless, tickless_user_cmodule, MODULE_TICKLESS_ENABLED);
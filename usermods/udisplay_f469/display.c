@@ -2,18 +2,43 @@
 #include "py/obj.h"
 #include "py/runtime.h"
 #include "py/builtin.h"
+#include "py/mphal.h"
 #include "lvgl.h"
 #include "lv_stm_hal.h"
 #include "stm32469i_discovery_lcd.h"
 
+// durations of init() phases in microseconds, for boot tracing
+STATIC uint32_t init_phases[3];
+
 STATIC mp_obj_t display_init(){
+    uint32_t t0 = mp_hal_ticks_us();
     lv_init();
+    uint32_t t1 = mp_hal_ticks_us();
     tft_init();
+    uint32_t t2 = mp_hal_ticks_us();
     touchpad_init();
+    init_phases[0] = t1 - t0;
+    init_phases[1] = t2 - t1;
+    init_phases[2] = mp_hal_ticks_us() - t2;
     return mp_const_none;
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_0(display_init_obj, display_init);
 
+// returns ((name, duration_us), ...) for the last init() call
+STATIC mp_obj_t display_init_phases(){
+    static const qstr names[] = { MP_QSTR_lv_init, MP_QSTR_tft_init, MP_QSTR_touchpad_init };
+    mp_obj_t items[3];
+    for(int i = 0; i < 3; i++){
+        mp_obj_t pair[2] = {
+            MP_OBJ_NEW_QSTR(names[i]),
+            mp_obj_new_int_from_uint(init_phases[i]),
+        };
+        items[i] = mp_obj_new_tuple(2, pair);
+    }
+    return mp_obj_new_tuple(3, items);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(display_init_phases_obj, display_init_phases);
+
 STATIC mp_obj_t display_update(mp_obj_t dt_obj){
     uint32_t dt = mp_obj_get_int(dt_obj);
     lv_tick_inc(dt);
@@ -60,6 +85,7 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_1(display_set_rotation_obj, display_set_rotation)
 STATIC const mp_rom_map_elem_t display_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_display) },
     { MP_ROM_QSTR(MP_QSTR_init), MP_ROM_PTR(&display_init_obj) },
+    { MP_ROM_QSTR(MP_QSTR_init_phases), MP_ROM_PTR(&display_init_phases_obj) },
     { MP_ROM_QSTR(MP_QSTR_update), MP_ROM_PTR(&display_update_obj) },
     { MP_ROM_QSTR(MP_QSTR_on), MP_ROM_PTR(&display_on_obj) },
     { MP_ROM_QSTR(MP_QSTR_off), MP_ROM_PTR(&display_off_obj) },
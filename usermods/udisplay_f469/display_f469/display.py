@@ -1,8 +1,26 @@
 from udisplay import update, on, off, set_rotation
 
+def _trace_init(udisplay):
+    """Adds udisplay.init() phases to the boot trace if it's available"""
+    try:
+        import boottrace
+    except ImportError:
+        return
+    if not boottrace.active():
+        return
+    # phases finished just now, restore their start times
+    t = boottrace.now()
+    phases = udisplay.init_phases()
+    for name, dt in phases:
+        t -= dt
+    for name, dt in phases:
+        boottrace.record("display." + name, t, dt)
+        t += dt
+
 def init(autoupdate=True):
     import udisplay
     udisplay.init()
+    _trace_init(udisplay)
 
     if autoupdate:
         import micropython
@@ -1,5 +1,17 @@
 from udisplay import update, on, off, set_rotation
 
+try:
+    from boottrace import phase
+except ImportError:
+    class phase:
+        """No-op replacement if boot tracing is not frozen"""
+        def __init__(self, name):
+            pass
+        def __enter__(self):
+            return self
+        def __exit__(self, *args):
+            pass
+
 def init(autoupdate=True):
     import lvgl as lv
     import SDL
@@ -12,31 +24,34 @@ def init(autoupdate=True):
     """
 
     # init the gui library
-    lv.init()
+    with phase("display.lv_init"):
+        lv.init()
     # init the hardware library
-    SDL.init()
+    with phase("display.sdl_init"):
+        SDL.init()
 
-    # Register SDL display driver
-    disp_buf1 = lv.disp_buf_t()
-    buf1_1 = bytearray(HOR_RES*10)
-    lv.disp_buf_init(disp_buf1,buf1_1, None, len(buf1_1)//4)
-    disp_drv = lv.disp_drv_t()
-    lv.disp_drv_init(disp_drv)
-    disp_drv.buffer = disp_buf1
-    disp_drv.flush_cb = SDL.monitor_flush
-    disp_drv.hor_res = HOR_RES
-    disp_drv.ver_res = VER_RES
-    lv.disp_drv_register(disp_drv)
+    with phase("display.drivers"):
+        # Register SDL display driver
+        disp_buf1 = lv.disp_buf_t()
+        buf1_1 = bytearray(HOR_RES*10)
+        lv.disp_buf_init(disp_buf1,buf1_1, None, len(buf1_1)//4)
+        disp_drv = lv.disp_drv_t()
+        lv.disp_drv_init(disp_drv)
+        disp_drv.buffer = disp_buf1
+        disp_drv.flush_cb = SDL.monitor_flush
+        disp_drv.hor_res = HOR_RES
+        disp_drv.ver_res = VER_RES
+        lv.disp_drv_register(disp_drv)
 
-    # Regsiter SDL mouse driver
-    indev_drv = lv.indev_drv_t()
-    lv.indev_drv_init(indev_drv) 
-    indev_drv.type = lv.INDEV_TYPE.POINTER;
-    indev_drv.read_cb = SDL.mouse_read;
-    lv.indev_drv_register(indev_drv);
+        # Regsiter SDL mouse driver
+        indev_drv = lv.indev_drv_t()
+        lv.indev_drv_init(indev_drv) 
+        indev_drv.type = lv.INDEV_TYPE.POINTER;
+        indev_drv.read_cb = SDL.mouse_read;
+        lv.indev_drv_register(indev_drv);
 
-    scr = lv.obj()
-    lv.scr_load(scr)
+        scr = lv.obj()
+        lv.scr_load(scr)
     if autoupdate:
         import SDL
         SDL.enable_autoupdate()